@@ -0,0 +1,110 @@
+/**
+ * @file lcz_ble_gw_dm_backoff.h
+ * @brief Reconnect backoff policies
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_BACKOFF_H__
+#define __LCZ_BLE_GW_DM_BACKOFF_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+/* Values match the dm_cnx_backoff_policy attribute */
+enum lcz_ble_gw_dm_backoff_policy {
+	/* base * multiplier^n */
+	LCZ_BLE_GW_DM_BACKOFF_CAPPED_EXPONENTIAL = 0,
+	/* random in [0, base * multiplier^n] */
+	LCZ_BLE_GW_DM_BACKOFF_FULL_JITTER,
+	/* random in [base, previous * multiplier] */
+	LCZ_BLE_GW_DM_BACKOFF_DECORRELATED_JITTER,
+	LCZ_BLE_GW_DM_BACKOFF_POLICY__NUM
+};
+
+typedef uint32_t (*lcz_ble_gw_dm_backoff_rand_t)(void);
+
+struct lcz_ble_gw_dm_backoff {
+	enum lcz_ble_gw_dm_backoff_policy policy;
+	/* Delays are in seconds */
+	uint32_t base;
+	uint32_t ceiling;
+	float multiplier;
+	lcz_ble_gw_dm_backoff_rand_t rand32;
+	/* Number of delays generated since the last reset */
+	uint32_t attempt;
+	/* Un-jittered exponential delay of the last attempt */
+	uint32_t exp_delay;
+	/* Last delay that was returned */
+	uint32_t delay;
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Initialize a backoff and reset it
+ *
+ * @param b backoff
+ * @param rand32 source of uniformly distributed 32-bit random numbers
+ */
+void lcz_ble_gw_dm_backoff_init(struct lcz_ble_gw_dm_backoff *b,
+				lcz_ble_gw_dm_backoff_rand_t rand32);
+
+/**
+ * @brief Set the policy and its parameters. The attempt count is kept so that
+ * parameters can change while backing off.
+ *
+ * @param b backoff
+ * @param policy backoff policy, invalid values select capped exponential
+ * @param base delay of the first attempt (seconds)
+ * @param ceiling largest delay that will be returned (seconds)
+ * @param multiplier growth factor, values below 1.0 are treated as 1.0
+ */
+void lcz_ble_gw_dm_backoff_configure(struct lcz_ble_gw_dm_backoff *b,
+				     enum lcz_ble_gw_dm_backoff_policy policy, uint32_t base,
+				     uint32_t ceiling, float multiplier);
+
+/**
+ * @brief Start over from the base delay (after a successful connection)
+ *
+ * @param b backoff
+ */
+void lcz_ble_gw_dm_backoff_reset(struct lcz_ble_gw_dm_backoff *b);
+
+/**
+ * @brief Get the delay before the next attempt
+ *
+ * @param b backoff
+ * @return delay in seconds
+ */
+uint32_t lcz_ble_gw_dm_backoff_next(struct lcz_ble_gw_dm_backoff *b);
+
+/**
+ * @brief Get a uniformly distributed random number in [min, max]. Rejection sampling is
+ * used so that ranges that don't divide 2^32 aren't biased.
+ *
+ * @param rand32 source of uniformly distributed 32-bit random numbers
+ * @param min lower bound (inclusive)
+ * @param max upper bound (inclusive)
+ * @return random number, min if max < min
+ */
+uint32_t lcz_ble_gw_dm_backoff_rand_range(lcz_ble_gw_dm_backoff_rand_t rand32, uint32_t min,
+					  uint32_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_BACKOFF_H__ */
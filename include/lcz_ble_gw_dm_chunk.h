@@ -0,0 +1,108 @@
+/**
+ * @file lcz_ble_gw_dm_chunk.h
+ * @brief Double-buffered Memfault chunk pipeline
+ *
+ * A packetizer thread reads the next chunk into one buffer while the caller sends the chunk in
+ * the other buffer, so the link isn't idle while chunks are prepared.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_CHUNK_H__
+#define __LCZ_BLE_GW_DM_CHUNK_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+/* Same signature as memfault_packetizer_get_chunk(). Returns false when there is no more data. */
+typedef bool (*lcz_ble_gw_dm_chunk_read_t)(void *buf, size_t *len);
+
+/* Send one chunk. Returns a negative error code to stop the stream. */
+typedef int (*lcz_ble_gw_dm_chunk_send_t)(const void *buf, size_t len, void *user_data);
+
+struct lcz_ble_gw_dm_chunk_stats {
+	uint32_t streams;
+	uint32_t chunks;
+	uint32_t bytes;
+	/* Buffer size of the last stream */
+	uint32_t chunk_size;
+	/* Time spent reading and sending chunks in the last stream (ms) */
+	uint32_t read_ms;
+	uint32_t send_ms;
+	/* Time the sender waited for the packetizer in the last stream (ms) */
+	uint32_t stall_ms;
+	/* Duration (ms) and throughput of the last stream */
+	uint32_t last_ms;
+	uint32_t last_bytes_per_s;
+	/* Chunks kept for the next stream after a send error */
+	uint32_t held;
+	/* Kept chunks that were discarded */
+	uint32_t dropped;
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Read chunks until there is no more data and send each one. Runs the sender in the
+ * calling thread. Must not be called from more than one thread at a time.
+ *
+ * @param read reads the next chunk, runs in the packetizer thread
+ * @param send sends a chunk, runs in the calling thread
+ * @param user_data passed to send
+ * @param chunk_size size of each buffer, limited to CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_BUF_SIZE
+ * @return 0 on success, otherwise the first error returned by send. The chunk that failed and
+ * any chunk already read are kept and sent before new chunks by the next stream.
+ */
+int lcz_ble_gw_dm_chunk_stream(lcz_ble_gw_dm_chunk_read_t read, lcz_ble_gw_dm_chunk_send_t send,
+			       void *user_data, size_t chunk_size);
+
+/**
+ * @brief Send the chunks kept after a failed stream, oldest first, e.g. to another destination
+ * before it reads new chunks. Same threading rules as lcz_ble_gw_dm_chunk_stream.
+ *
+ * @param send sends a chunk, runs in the calling thread
+ * @param user_data passed to send
+ * @return 0 when no chunks are kept anymore, otherwise the error returned by send
+ */
+int lcz_ble_gw_dm_chunk_held_send(lcz_ble_gw_dm_chunk_send_t send, void *user_data);
+
+/**
+ * @brief Get the number of chunks kept after a failed stream
+ *
+ * @return number of chunks
+ */
+int lcz_ble_gw_dm_chunk_held_count(void);
+
+/**
+ * @brief Discard the chunks kept after a failed stream
+ *
+ * @return number of chunks discarded
+ */
+int lcz_ble_gw_dm_chunk_held_discard(void);
+
+/**
+ * @brief Get the pipeline statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_chunk_stats_get(struct lcz_ble_gw_dm_chunk_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_CHUNK_H__ */
@@ -0,0 +1,68 @@
+/**
+ * @file lcz_ble_gw_dm_creds.h
+ * @brief Cache of the TLS credentials loaded for the LwM2M connections
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_CREDS_H__
+#define __LCZ_BLE_GW_DM_CREDS_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <lcz_pki_auth.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+struct lcz_ble_gw_dm_creds_stats {
+	/* Loads skipped because the credentials were unchanged */
+	uint32_t hits;
+	/* Loads from the file system */
+	uint32_t loads;
+	uint32_t failures;
+	uint32_t invalidations;
+	/* Time spent loading from the file system */
+	uint32_t load_total_ms;
+	uint32_t load_max_ms;
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Load credentials from a PKI store into the TLS stack, unless they were already loaded
+ * for the same tag and the file sizes haven't changed since.
+ *
+ * @param store PKI store
+ * @param tls_tag security tag to register the credentials with
+ * @return 0 on success, negative errno otherwise
+ */
+int lcz_ble_gw_dm_creds_load(LCZ_PKI_AUTH_STORE_T store, int tls_tag);
+
+/**
+ * @brief Force the next load of every store to read the files again, even if the file sizes
+ * didn't change. Called when a key file write completes.
+ */
+void lcz_ble_gw_dm_creds_invalidate(void);
+
+/**
+ * @brief Get the cache statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_creds_stats_get(struct lcz_ble_gw_dm_creds_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_CREDS_H__ */
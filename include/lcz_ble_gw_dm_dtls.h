@@ -0,0 +1,91 @@
+/**
+ * @file lcz_ble_gw_dm_dtls.h
+ * @brief DTLS session reuse for the device management connection
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_DTLS_H__
+#define __LCZ_BLE_GW_DM_DTLS_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <lcz_lwm2m_client.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+struct lcz_ble_gw_dm_dtls_handshake_stats {
+	uint32_t count;
+	uint32_t total_ms;
+	/* All interfaces, so other traffic during the handshake is included.
+	 * Zero if network statistics aren't available.
+	 */
+	uint64_t bytes_sent;
+	uint64_t bytes_received;
+};
+
+struct lcz_ble_gw_dm_dtls_stats {
+	/* Handshakes where no session was offered */
+	struct lcz_ble_gw_dm_dtls_handshake_stats full;
+	/* Handshakes where the cached session was offered, the socket layer doesn't report
+	 * whether the server accepted it
+	 */
+	struct lcz_ble_gw_dm_dtls_handshake_stats offered;
+	uint32_t failed;
+	/* Connections where the server accepted a connection ID */
+	uint32_t cid_negotiated;
+	bool session_cached;
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief LwM2M set_socketoptions callback. Sets the same options as the LwM2M engine and
+ * enables the socket session cache and the DTLS connection ID when they are supported.
+ * Only install it on the DM client context.
+ *
+ * @param client_ctx LwM2M client context
+ * @return 0 on success, negative errno otherwise
+ */
+int lcz_ble_gw_dm_dtls_set_socketoptions(struct lwm2m_ctx *client_ctx);
+
+/**
+ * @brief Call before connecting to the server
+ */
+void lcz_ble_gw_dm_dtls_handshake_start(void);
+
+/**
+ * @brief Call when the connection started by lcz_ble_gw_dm_dtls_handshake_start completes
+ *
+ * @param success true if the client registered
+ */
+void lcz_ble_gw_dm_dtls_handshake_done(bool success);
+
+/**
+ * @brief Forget the cached session so that the next handshake is a full handshake
+ * (after the credentials or the server change)
+ */
+void lcz_ble_gw_dm_dtls_session_invalidate(void);
+
+/**
+ * @brief Get the handshake statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_dtls_stats_get(struct lcz_ble_gw_dm_dtls_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_DTLS_H__ */
@@ -0,0 +1,124 @@
+/**
+ * @file lcz_ble_gw_dm_mflt_store.h
+ * @brief Segmented ring store for Memfault chunks that can't be uploaded
+ *
+ * Chunks are appended as records to segment files in CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE_DIR.
+ * When the store is full the oldest segment is deleted, segments holding coredumps are only
+ * deleted when there are no others.
+ *
+ * Segment file "<seq>.seg" (seq is 8 hex digits, little endian fields):
+ *   header: magic (u32), version (u8), class (u8), reserved (u16), seq (u32)
+ *   records: length (u16), reserved (u16), crc32_ieee of the chunk (u32), chunk
+ *
+ * File "commit": magic (u32), seq (u32), offset (u32), crc32_ieee of the other fields (u32)
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_MFLT_STORE_H__
+#define __LCZ_BLE_GW_DM_MFLT_STORE_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+#define LCZ_BLE_GW_DM_MFLT_STORE_MAGIC 0x3153464d /* "MFS1" */
+#define LCZ_BLE_GW_DM_MFLT_STORE_VERSION 1
+
+/* Chunks of different classes are never in the same segment */
+enum lcz_ble_gw_dm_mflt_store_class {
+	LCZ_BLE_GW_DM_MFLT_STORE_DATA = 0,
+	LCZ_BLE_GW_DM_MFLT_STORE_COREDUMP,
+	LCZ_BLE_GW_DM_MFLT_STORE_CLASS__NUM
+};
+
+/* Read position, zero to start at the oldest chunk */
+struct lcz_ble_gw_dm_mflt_store_pos {
+	/* Segment of the next chunk */
+	uint32_t seq;
+	/* Offset of the next record in the segment */
+	uint32_t offset;
+};
+
+struct lcz_ble_gw_dm_mflt_store_stats {
+	uint32_t segments;
+	uint32_t coredump_segments;
+	/* Size of all segments */
+	uint32_t bytes;
+	/* Size of the records after the commit position */
+	uint32_t backlog;
+	uint32_t appended;
+	uint32_t evicted;
+	uint32_t evicted_coredumps;
+	uint32_t evicted_bytes;
+	/* Records skipped by the reader because their CRC didn't match */
+	uint32_t corrupt;
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Append a chunk. Starts a new segment and evicts old ones as needed.
+ *
+ * @param cls class of the chunk
+ * @param chunk chunk data
+ * @param len chunk length, at most UINT16_MAX
+ * @return 0 on success, negative error code otherwise
+ */
+int lcz_ble_gw_dm_mflt_store_append(enum lcz_ble_gw_dm_mflt_store_class cls, const void *chunk,
+				    size_t len);
+
+/**
+ * @brief Read the chunk at a position and advance the position. Evicted segments are skipped,
+ * as are records with a bad CRC.
+ *
+ * @param pos read position
+ * @param buf chunk buffer
+ * @param size size of the buffer
+ * @param len length of the chunk
+ * @return 0 on success, -ENODATA if there are no more chunks, -ENOBUFS if the chunk doesn't fit
+ * (the position isn't advanced), negative error code otherwise
+ */
+int lcz_ble_gw_dm_mflt_store_read(struct lcz_ble_gw_dm_mflt_store_pos *pos, void *buf,
+				  size_t size, size_t *len);
+
+/**
+ * @brief Record that every chunk before a position has been uploaded. Segments before the
+ * position are deleted and the position is saved so that it survives a reset.
+ *
+ * @param pos position after the last uploaded chunk
+ * @return 0 on success, negative error code otherwise
+ */
+int lcz_ble_gw_dm_mflt_store_commit(const struct lcz_ble_gw_dm_mflt_store_pos *pos);
+
+/**
+ * @brief Get the position after the last uploaded chunk
+ *
+ * @param pos committed position, zero if nothing has been committed
+ */
+void lcz_ble_gw_dm_mflt_store_committed(struct lcz_ble_gw_dm_mflt_store_pos *pos);
+
+/**
+ * @brief Get the store statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_mflt_store_stats_get(struct lcz_ble_gw_dm_mflt_store_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_MFLT_STORE_H__ */
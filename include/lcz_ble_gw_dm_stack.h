@@ -0,0 +1,72 @@
+/**
+ * @file lcz_ble_gw_dm_stack.h
+ * @brief Stack headroom monitor for the threads used by the gateway device manager
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_STACK_H__
+#define __LCZ_BLE_GW_DM_STACK_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+struct lcz_ble_gw_dm_stack_stats {
+	const char *name;
+	/* Stack size in bytes */
+	uint32_t size;
+	/* Deepest use seen since boot */
+	uint32_t max_used;
+	/* Times the stack was sampled */
+	uint32_t samples;
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Get the number of monitored threads
+ *
+ * @return number of threads
+ */
+int lcz_ble_gw_dm_stack_count(void);
+
+/**
+ * @brief Get the stack usage of a monitored thread
+ *
+ * @param index index of the thread
+ * @param stats copy of the statistics
+ * @return 0 on success, -EINVAL if the index is invalid
+ */
+int lcz_ble_gw_dm_stack_stats_get(int index, struct lcz_ble_gw_dm_stack_stats *stats);
+
+/**
+ * @brief Sample the stacks now instead of waiting for the next period
+ */
+void lcz_ble_gw_dm_stack_sample(void);
+
+/**
+ * @brief Run the code paths that don't run shortly after boot so that their stack use is
+ * included. Blocks until the Memfault data has been sent and the script has run.
+ *
+ * @param script optional shell script to run on the system work queue, as the file rules do
+ * @return 0 on success, negative error code otherwise
+ */
+int lcz_ble_gw_dm_stack_exercise(const char *script);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_STACK_H__ */
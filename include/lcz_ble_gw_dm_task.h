@@ -10,10 +10,241 @@
 #ifndef __LCZ_BLE_GW_DM_TASK_H__
 #define __LCZ_BLE_GW_DM_TASK_H__
 
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/types.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+/* Upper edges (in seconds) of the time-in-state histogram buckets. The last bucket holds
+ * everything at or above the last edge.
+ */
+#define LCZ_BLE_GW_DM_STATE_HIST_EDGES_S                                                           \
+	{                                                                                          \
+		1, 5, 15, 30, 60, 300, 900, 3600, 14400                                            \
+	}
+#define LCZ_BLE_GW_DM_STATE_HIST_BUCKETS 10
+
+struct lcz_ble_gw_dm_state_stats {
+	/* Number of transitions into the state */
+	uint32_t transitions;
+	/* Longest single visit */
+	uint32_t max_ms;
+	/* Total time spent in the state (completed visits only) */
+	uint64_t total_ms;
+	/* Count of completed visits per time-in-state bucket */
+	uint32_t hist[LCZ_BLE_GW_DM_STATE_HIST_BUCKETS];
+};
+
+struct lcz_ble_gw_dm_queue_stats {
+	/* Broadcasts queued to the task */
+	uint32_t accepted;
+	/* Broadcasts merged into a message of the same type that was already queued */
+	uint32_t coalesced;
+	/* Broadcasts the task doesn't handle */
+	uint32_t filtered;
+	/* Broadcasts that didn't fit in the queue, a coalesced one is delivered by the next kick */
+	uint32_t dropped;
+	/* Most messages in the queue at once */
+	uint32_t high_water;
+	/* Messages currently in the queue */
+	uint32_t used;
+	/* Size of the queue */
+	uint32_t depth;
+};
+
+struct lcz_ble_gw_dm_psm_stats {
+	bool radio_on;
+	/* Time the radio was on since boot */
+	uint32_t radio_on_s;
+	/* Radio on time extrapolated to a day */
+	uint32_t radio_on_per_day;
+	uint32_t wakes;
+	/* Registration updates moved forward to a modem wake */
+	uint32_t aligned_updates;
+};
+
+/* Messages handled by the task, for dispatch profiling */
+enum lcz_ble_gw_dm_dispatch_msg {
+	LCZ_BLE_GW_DM_DISPATCH_FSM_KICK = 0,
+	LCZ_BLE_GW_DM_DISPATCH_ATTR_CHANGED,
+	LCZ_BLE_GW_DM_DISPATCH_SENSOR_MEASURED,
+	LCZ_BLE_GW_DM_DISPATCH_BATTERY_STATE,
+	LCZ_BLE_GW_DM_DISPATCH_OBJ_CREATED,
+	LCZ_BLE_GW_DM_DISPATCH_MEMFAULT_POSTED,
+	LCZ_BLE_GW_DM_DISPATCH_MSG__NUM
+};
+
+/* Bucket b of the dispatch histograms holds times below 2^(b + 1) us. The last bucket holds
+ * everything above.
+ */
+#define LCZ_BLE_GW_DM_DISPATCH_HIST_BUCKETS 24
+
+struct lcz_ble_gw_dm_dispatch_timing {
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint32_t hist[LCZ_BLE_GW_DM_DISPATCH_HIST_BUCKETS];
+};
+
+struct lcz_ble_gw_dm_dispatch_stats {
+	/* Messages handled */
+	uint32_t count;
+	/* Time spent in the handler */
+	struct lcz_ble_gw_dm_dispatch_timing exec;
+	/* Time from queueing the message until the handler ran */
+	struct lcz_ble_gw_dm_dispatch_timing wait;
+};
+
+/* Connection recovery steps, in the order they are tried */
+enum lcz_ble_gw_dm_recovery_step {
+	LCZ_BLE_GW_DM_RECOVERY_NONE = 0,
+	LCZ_BLE_GW_DM_RECOVERY_REREGISTER,
+	LCZ_BLE_GW_DM_RECOVERY_RECREATE_CONTEXT,
+	LCZ_BLE_GW_DM_RECOVERY_REBOOT,
+	LCZ_BLE_GW_DM_RECOVERY_STEP__NUM
+};
+
+struct lcz_ble_gw_dm_recovery_stats {
+	/* Step in progress, LCZ_BLE_GW_DM_RECOVERY_NONE if connected */
+	int step;
+	/* Time from the watchdog expiring until the last recovery */
+	uint32_t last_recovery_ms;
+	/* Number of times each step was run */
+	uint32_t attempts[LCZ_BLE_GW_DM_RECOVERY_STEP__NUM];
+	/* Number of recoveries that happened while each step was the latest */
+	uint32_t recovered[LCZ_BLE_GW_DM_RECOVERY_STEP__NUM];
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Get the number of gateway FSM states
+ *
+ * @return number of states
+ */
+int lcz_ble_gw_dm_state_count(void);
+
+/**
+ * @brief Get the name of a gateway FSM state
+ *
+ * @param state index of the state
+ * @return name of the state or NULL if the index is invalid
+ */
+const char *lcz_ble_gw_dm_state_name(int state);
+
+/**
+ * @brief Get the current gateway FSM state
+ *
+ * @param time_in_state_ms optional, time spent in the current state
+ * @return index of the current state
+ */
+int lcz_ble_gw_dm_state_get(uint32_t *time_in_state_ms);
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+/**
+ * @brief Get the timing statistics of a gateway FSM state
+ *
+ * @param state index of the state
+ * @param stats copy of the statistics
+ * @return 0 on success, -EINVAL if the state index is invalid
+ */
+int lcz_ble_gw_dm_state_stats_get(int state, struct lcz_ble_gw_dm_state_stats *stats);
+
+/**
+ * @brief Clear the timing statistics of all gateway FSM states
+ */
+void lcz_ble_gw_dm_state_stats_clear(void);
+#endif
+
+/**
+ * @brief Get the task queue statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_queue_stats_get(struct lcz_ble_gw_dm_queue_stats *stats);
+
+/**
+ * @brief Clear the task queue counters and high-water mark
+ */
+void lcz_ble_gw_dm_queue_stats_clear(void);
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+/**
+ * @brief Get the name of a message handled by the task
+ *
+ * @param msg message index
+ * @return name of the message or NULL if the index is invalid
+ */
+const char *lcz_ble_gw_dm_dispatch_msg_name(int msg);
+
+/**
+ * @brief Get the handler timing of a message
+ *
+ * @param msg message index
+ * @param stats copy of the statistics
+ * @return 0 on success, -EINVAL if the message index is invalid
+ */
+int lcz_ble_gw_dm_dispatch_stats_get(int msg, struct lcz_ble_gw_dm_dispatch_stats *stats);
+
+/**
+ * @brief Clear the handler timing of all messages
+ */
+void lcz_ble_gw_dm_dispatch_stats_clear(void);
+
+/**
+ * @brief Estimate a percentile from a dispatch histogram
+ *
+ * @param timing histogram to use
+ * @param count number of samples in the histogram
+ * @param percent percentile to get (1-100)
+ * @return upper edge of the bucket holding the percentile (us), capped at the maximum
+ */
+uint32_t lcz_ble_gw_dm_dispatch_percentile(const struct lcz_ble_gw_dm_dispatch_timing *timing,
+					   uint32_t count, uint32_t percent);
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+/**
+ * @brief Get the power save statistics. The radio is considered on while the modem is awake,
+ * or without modem sleep events, from a registration update until the client stops listening.
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_psm_stats_get(struct lcz_ble_gw_dm_psm_stats *stats);
+
+/**
+ * @brief Get the estimated radio on time per day
+ *
+ * @return seconds per day
+ */
+uint32_t lcz_ble_gw_dm_psm_radio_on_per_day(void);
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+/**
+ * @brief Get the name of a connection recovery step
+ *
+ * @param step recovery step
+ * @return name of the step or NULL if the step is invalid
+ */
+const char *lcz_ble_gw_dm_recovery_step_name(int step);
+
+/**
+ * @brief Get the connection recovery statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_recovery_stats_get(struct lcz_ble_gw_dm_recovery_stats *stats);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
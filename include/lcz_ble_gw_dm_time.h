@@ -0,0 +1,110 @@
+/**
+ * @file lcz_ble_gw_dm_time.h
+ * @brief Time service of the gateway device manager
+ *
+ * Tracks where and when the time was last obtained and estimates the error of the clock since
+ * then, so that the network time is only queried when it is needed.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_TIME_H__
+#define __LCZ_BLE_GW_DM_TIME_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+enum lcz_ble_gw_dm_time_source {
+	LCZ_BLE_GW_DM_TIME_SOURCE_NONE = 0,
+	LCZ_BLE_GW_DM_TIME_SOURCE_MODEM,
+	LCZ_BLE_GW_DM_TIME_SOURCE_NTP,
+	LCZ_BLE_GW_DM_TIME_SOURCE_EXTERNAL,
+	LCZ_BLE_GW_DM_TIME_SOURCE__NUM
+};
+
+struct lcz_ble_gw_dm_time_stats {
+	enum lcz_ble_gw_dm_time_source source;
+	/* Time since the last update, -1 if the time was never obtained */
+	int64_t age_ms;
+	/* Estimated error of the clock now */
+	uint32_t error_ms;
+	/* Drift used for the estimate and the last measured drift */
+	uint32_t drift_ppm;
+	uint32_t measured_drift_ppm;
+	uint32_t updates;
+	/* Network time queries made and skipped because the time was still accurate */
+	uint32_t queries;
+	uint32_t queries_skipped;
+	/* Device time writes by the LwM2M server, the offset they set and the time since the last
+	 * one, -1 if the server never wrote the time
+	 */
+	uint32_t lwm2m_writes;
+	int32_t lwm2m_offset_s;
+	int64_t lwm2m_write_age_ms;
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Record that the system time was obtained
+ *
+ * @param source where the time came from
+ * @param unix_time_ms time that was obtained
+ */
+void lcz_ble_gw_dm_time_update(enum lcz_ble_gw_dm_time_source source, int64_t unix_time_ms);
+
+/**
+ * @brief Check if the time should be obtained from the network. Counts the query or the skip.
+ *
+ * @return true if the estimated error exceeds CONFIG_LCZ_BLE_GW_DM_TIME_MAX_ERROR
+ */
+bool lcz_ble_gw_dm_time_query_needed(void);
+
+/**
+ * @brief Get the time reported to the LwM2M server (system time plus the offset written by
+ * the server)
+ *
+ * @return unix time in seconds
+ */
+int32_t lcz_ble_gw_dm_time_get(void);
+
+/**
+ * @brief Set the time as written by the LwM2M server. Only the time reported to the server
+ * changes, the system time and its estimated error are left alone.
+ *
+ * @param unix_time unix time in seconds
+ */
+void lcz_ble_gw_dm_time_set(int32_t unix_time);
+
+/**
+ * @brief Get the name of a time source
+ *
+ * @param source time source
+ * @return name of the source or NULL if the source is invalid
+ */
+const char *lcz_ble_gw_dm_time_source_name(enum lcz_ble_gw_dm_time_source source);
+
+/**
+ * @brief Get the time service statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_time_stats_get(struct lcz_ble_gw_dm_time_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_TIME_H__ */
@@ -0,0 +1,121 @@
+/**
+ * @file lcz_ble_gw_dm_timer.h
+ * @brief Timer service shared by the gateway device manager
+ *
+ * All module deadlines are kept in one sorted list that is serviced by a single delayable
+ * work item, so the module schedules at most one kernel timeout at a time. Handlers run on the
+ * system work queue.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_TIMER_H__
+#define __LCZ_BLE_GW_DM_TIMER_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/sys/dlist.h>
+#include <zephyr/sys/slist.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+struct lcz_ble_gw_dm_timer;
+
+typedef void (*lcz_ble_gw_dm_timer_handler_t)(struct lcz_ble_gw_dm_timer *timer);
+
+struct lcz_ble_gw_dm_timer {
+	/* Running or expired list */
+	sys_dnode_t node;
+	/* List of all timers that have been started */
+	sys_snode_t reg_node;
+	bool registered;
+	lcz_ble_gw_dm_timer_handler_t handler;
+	const char *name;
+	int64_t expiry_tick;
+	uint32_t period_ticks;
+	uint32_t expirations;
+};
+
+#define LCZ_BLE_GW_DM_TIMER_DEFINE(_timer, _handler)                                               \
+	struct lcz_ble_gw_dm_timer _timer = { .handler = _handler, .name = #_timer }
+
+struct lcz_ble_gw_dm_timer_stats {
+	/* Timer handlers run since boot */
+	uint32_t expirations;
+	/* Times the service work item ran since boot */
+	uint32_t wakeups;
+	/* Expirations in the last complete hour */
+	uint32_t expirations_last_hour;
+	/* Average expirations per hour since boot */
+	uint32_t expirations_per_hour;
+	/* Uptime (ms) of the next deadline, -1 if no timer is running */
+	int64_t next_deadline;
+};
+
+typedef void (*lcz_ble_gw_dm_timer_foreach_cb_t)(const struct lcz_ble_gw_dm_timer *timer,
+						  int64_t remaining_ms, void *user_data);
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Start or restart a timer. Deadlines are rounded up to the service resolution.
+ *
+ * @param timer timer to start
+ * @param delay_ms time until the first expiration
+ * @param period_ms time between expirations after the first, 0 for a one-shot timer
+ */
+void lcz_ble_gw_dm_timer_start(struct lcz_ble_gw_dm_timer *timer, uint32_t delay_ms,
+			       uint32_t period_ms);
+
+/**
+ * @brief Stop a timer. Does nothing if it isn't running.
+ *
+ * @param timer timer to stop
+ */
+void lcz_ble_gw_dm_timer_stop(struct lcz_ble_gw_dm_timer *timer);
+
+/**
+ * @brief Check if a timer is running
+ *
+ * @param timer timer to check
+ * @return true if the timer will expire
+ */
+bool lcz_ble_gw_dm_timer_is_pending(struct lcz_ble_gw_dm_timer *timer);
+
+/**
+ * @brief Get the earliest deadline of all running timers
+ *
+ * @return uptime in milliseconds or -1 if no timer is running
+ */
+int64_t lcz_ble_gw_dm_timer_next_deadline(void);
+
+/**
+ * @brief Get the timer service statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_timer_stats_get(struct lcz_ble_gw_dm_timer_stats *stats);
+
+/**
+ * @brief Call a function for each timer that has been started at least once
+ *
+ * @param cb called with the time until expiration, -1 if the timer isn't running
+ * @param user_data passed to the callback
+ */
+void lcz_ble_gw_dm_timer_foreach(lcz_ble_gw_dm_timer_foreach_cb_t cb, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_TIMER_H__ */
@@ -0,0 +1,126 @@
+/**
+ * @file lcz_ble_gw_dm_trace.h
+ * @brief Binary trace of the gateway state transitions
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#ifndef __LCZ_BLE_GW_DM_TRACE_H__
+#define __LCZ_BLE_GW_DM_TRACE_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+/* The dump is little-endian: header, state names (NUL terminated), then records oldest first.
+ * tools/trace_decode/gw_dm_trace.c decodes it.
+ */
+#define LCZ_BLE_GW_DM_TRACE_MAGIC 0x52544447 /* "GDTR" */
+#define LCZ_BLE_GW_DM_TRACE_VERSION 1
+
+/* What ran the FSM. When several events are merged into one run the lowest value is kept. */
+enum lcz_ble_gw_dm_trace_cause {
+	LCZ_BLE_GW_DM_TRACE_CAUSE_START = 0,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_RECOVERY,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_NETWORK,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_LWM2M,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_MODEM_WAKE,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_DEADLINE,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_ATTR,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_OBJ_CREATED,
+	LCZ_BLE_GW_DM_TRACE_CAUSE_MEMFAULT,
+	LCZ_BLE_GW_DM_TRACE_CAUSE__NUM
+};
+
+struct lcz_ble_gw_dm_trace_header {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t record_size;
+	uint8_t state_count;
+	uint8_t reserved;
+	uint16_t records;
+	/* Sequence number of the next record, records lost to wrapping can be counted from it */
+	uint16_t next_seq;
+	/* Uptime when the dump was made */
+	uint32_t uptime_ms;
+} __packed;
+
+struct lcz_ble_gw_dm_trace_record {
+	/* Uptime, wraps after 49 days */
+	uint32_t timestamp_ms;
+	uint8_t from;
+	uint8_t to;
+	/* enum lcz_ble_gw_dm_trace_cause */
+	uint8_t cause;
+	/* Last enum lwm2m_rd_client_event of the DM client */
+	uint8_t lwm2m_event;
+	uint16_t cnx_tries;
+	uint16_t seq;
+} __packed;
+
+typedef void (*lcz_ble_gw_dm_trace_foreach_cb_t)(const struct lcz_ble_gw_dm_trace_record *record,
+						  void *user_data);
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Add a state transition to the trace, overwriting the oldest when it is full
+ *
+ * @param from previous state
+ * @param to new state
+ * @param cause what ran the FSM
+ * @param lwm2m_event last LwM2M event of the DM client
+ * @param cnx_tries connection attempts
+ */
+void lcz_ble_gw_dm_trace_add(uint8_t from, uint8_t to, uint8_t cause, uint8_t lwm2m_event,
+			     uint16_t cnx_tries);
+
+/**
+ * @brief Get the size of a dump of the current trace
+ *
+ * @return size in bytes
+ */
+size_t lcz_ble_gw_dm_trace_dump_size(void);
+
+/**
+ * @brief Copy the trace into a buffer. Records added after lcz_ble_gw_dm_trace_dump_size()
+ * may not fit and are left out.
+ *
+ * @param buf destination
+ * @param size size of the destination
+ * @return number of bytes written or -ENOMEM if the header and state names don't fit
+ */
+int lcz_ble_gw_dm_trace_dump(uint8_t *buf, size_t size);
+
+/**
+ * @brief Call a function for each record, oldest first
+ *
+ * @param cb called for each record
+ * @param user_data passed to the callback
+ */
+void lcz_ble_gw_dm_trace_foreach(lcz_ble_gw_dm_trace_foreach_cb_t cb, void *user_data);
+
+/**
+ * @brief Get the name of a cause
+ *
+ * @param cause trace cause
+ * @return name of the cause or NULL if it is invalid
+ */
+const char *lcz_ble_gw_dm_trace_cause_name(uint8_t cause);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_BLE_GW_DM_TRACE_H__ */
@@ -18,6 +18,9 @@ extern "C" {
 /**************************************************************************************************/
 int lwm2m_telemetry_init(void);
 
+/* Write the configuration on the next init, the objects holding it were recreated or reset */
+void lwm2m_telemetry_invalidate(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,30 @@ extern "C" {
 /**************************************************************************************************/
 /* Global Constants, Macros and Type Definitions                                                  */
 /**************************************************************************************************/
+/* Called from the Memfault thread with the result of the post (or save) */
+typedef void (*lcz_ble_gw_dm_memfault_done_cb_t)(int result);
+
+struct lcz_ble_gw_dm_memfault_stats {
+	/* Uploads (or saves) run since boot */
+	uint32_t uploads;
+	/* Post requests since boot */
+	uint32_t requests;
+	/* Requests that were served by an upload another request started */
+	uint32_t merged;
+	/* Requests waiting for the next upload */
+	uint32_t queued;
+	/* Duration (ms) of the last and longest upload */
+	uint32_t last_ms;
+	uint32_t max_ms;
+	int last_result;
+	/* Drain of stored data */
+	uint32_t drain_batches;
+	uint32_t drain_bytes;
+	uint32_t drain_bytes_per_s;
+	/* Stored bytes waiting to be drained */
+	uint32_t drain_backlog;
+};
+
 #ifdef CONFIG_LCZ_BLE_GW_DM_MEMFAULT
 #define LCZ_BLE_GW_DM_MEMFAULT_POST_DATA lcz_ble_gw_dm_memfault_post_data
 #define LCZ_BLE_GW_DM_MEMFAULT_POST_DATA_SYNC lcz_ble_gw_dm_memfault_post_data_sync
@@ -39,6 +63,7 @@ extern "C" {
 /**
  * @brief Post any available data to memfault cloud via HTTPS
  * NOTE: This is a non-blocking call that signals the task to send data asynchronously.
+ * Requests made while an upload is in progress are merged into one follow-up upload.
  *
  * @return 0 on success
  */
@@ -48,9 +73,39 @@ int lcz_ble_gw_dm_memfault_post_data(void);
  * @brief Post any available data to memfault cloud via HTTPS synchronously.
  * NOTE: This is a blocking call that returns once data has been sent.
  *
- * @return 0 on success
+ * @return 0 on success, result of the upload or -EAGAIN on timeout
  */
 int lcz_ble_gw_dm_memfault_post_data_sync(void);
+
+/**
+ * @brief Post any available data to memfault cloud and call a function when done.
+ * NOTE: This is a non-blocking call, the callback runs in the Memfault thread.
+ *
+ * @param done called with the result once the data has been sent or saved
+ * @return 0 on success, -EBUSY if a post with a callback is already in progress
+ */
+int lcz_ble_gw_dm_memfault_post_data_async(lcz_ble_gw_dm_memfault_done_cb_t done);
+
+/**
+ * @brief Get the upload statistics
+ *
+ * @param stats copy of the statistics
+ */
+void lcz_ble_gw_dm_memfault_stats_get(struct lcz_ble_gw_dm_memfault_stats *stats);
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+/**
+ * @brief Post the next batch of stored data over HTTP. Nothing is posted while lcz_memfault
+ * uses MQTT or CoAP. Safe to call from an ISR.
+ */
+void lcz_ble_gw_dm_memfault_drain(void);
+
+/**
+ * @brief Check the link after an LTE RAT or signal change, a drain is started if the link is
+ * now good enough.
+ */
+void lcz_ble_gw_dm_memfault_link_changed(void);
+#endif
 #endif /* CONFIG_LCZ_BLE_GW_DM_MEMFAULT*/
 
 #ifdef __cplusplus
@@ -1,2 +1,4 @@
 	FMC_NETWORK_CONNECTED,
 	FMC_NETWORK_DISCONNECTED,
+	FMC_GW_DM_FSM_KICK,
+	FMC_GW_DM_MEMFAULT_POSTED,
@@ -0,0 +1,118 @@
+/**
+ * @file lcz_ble_gw_dm_backoff.c
+ * @brief Reconnect backoff policies
+ *
+ * This file doesn't depend on the kernel so that it can also be built on a host.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <stddef.h>
+
+#include "lcz_ble_gw_dm_backoff.h"
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static uint32_t grow(const struct lcz_ble_gw_dm_backoff *b, uint32_t value);
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static uint32_t grow(const struct lcz_ble_gw_dm_backoff *b, uint32_t value)
+{
+	float next = (float)value * b->multiplier;
+
+	if (next >= (float)b->ceiling) {
+		return b->ceiling;
+	}
+
+	return (uint32_t)next;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+void lcz_ble_gw_dm_backoff_init(struct lcz_ble_gw_dm_backoff *b,
+				lcz_ble_gw_dm_backoff_rand_t rand32)
+{
+	b->rand32 = rand32;
+	lcz_ble_gw_dm_backoff_configure(b, LCZ_BLE_GW_DM_BACKOFF_CAPPED_EXPONENTIAL, 1, 1, 1.0f);
+	lcz_ble_gw_dm_backoff_reset(b);
+}
+
+void lcz_ble_gw_dm_backoff_configure(struct lcz_ble_gw_dm_backoff *b,
+				     enum lcz_ble_gw_dm_backoff_policy policy, uint32_t base,
+				     uint32_t ceiling, float multiplier)
+{
+	if (policy >= LCZ_BLE_GW_DM_BACKOFF_POLICY__NUM) {
+		policy = LCZ_BLE_GW_DM_BACKOFF_CAPPED_EXPONENTIAL;
+	}
+	b->policy = policy;
+	b->base = (base == 0) ? 1 : base;
+	b->ceiling = (ceiling == 0) ? 1 : ceiling;
+	b->multiplier = (multiplier < 1.0f) ? 1.0f : multiplier;
+}
+
+void lcz_ble_gw_dm_backoff_reset(struct lcz_ble_gw_dm_backoff *b)
+{
+	b->attempt = 0;
+	b->exp_delay = b->base;
+	b->delay = b->base;
+}
+
+uint32_t lcz_ble_gw_dm_backoff_next(struct lcz_ble_gw_dm_backoff *b)
+{
+	uint32_t lower;
+
+	/* The first backoff delay is the base delay grown once */
+	b->exp_delay = grow(b, (b->attempt == 0) ? b->base : b->exp_delay);
+
+	switch (b->policy) {
+	case LCZ_BLE_GW_DM_BACKOFF_FULL_JITTER:
+		b->delay = lcz_ble_gw_dm_backoff_rand_range(b->rand32, 0, b->exp_delay);
+		break;
+	case LCZ_BLE_GW_DM_BACKOFF_DECORRELATED_JITTER:
+		lower = (b->base < b->ceiling) ? b->base : b->ceiling;
+		b->delay = lcz_ble_gw_dm_backoff_rand_range(
+			b->rand32, lower, grow(b, (b->attempt == 0) ? b->base : b->delay));
+		break;
+	default:
+		b->delay = b->exp_delay;
+		break;
+	}
+
+	b->attempt++;
+	return b->delay;
+}
+
+uint32_t lcz_ble_gw_dm_backoff_rand_range(lcz_ble_gw_dm_backoff_rand_t rand32, uint32_t min,
+					  uint32_t max)
+{
+	uint32_t range;
+	uint32_t threshold;
+	uint32_t r;
+
+	if (max <= min || rand32 == NULL) {
+		return min;
+	}
+
+	range = max - min + 1;
+	if (range == 0) {
+		/* Full 32-bit range */
+		return rand32();
+	}
+
+	/* 2^32 mod range, values below this would make the low end of the range more likely */
+	threshold = (0U - range) % range;
+	do {
+		r = rand32();
+	} while (r < threshold);
+
+	return min + (r % range);
+}
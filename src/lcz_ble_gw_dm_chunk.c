@@ -0,0 +1,264 @@
+/**
+ * @file lcz_ble_gw_dm_chunk.c
+ * @brief Double-buffered Memfault chunk pipeline
+ *
+ * The two buffers are passed between the packetizer thread and the sender with a pair of
+ * counting semaphores. A zero length chunk marks the end of the stream. After a send error the
+ * packetizer is told to stop and the sender keeps releasing buffers until it sees the end.
+ *
+ * Chunks taken from the Memfault packetizer can't be given back, so the chunk that failed and
+ * any chunk read ahead are kept in their buffers and sent first by the next stream. Once told
+ * to stop, the packetizer only writes the end marker length, never the buffer contents.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lcz_ble_gw_dm_chunk, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <string.h>
+
+#include "lcz_ble_gw_dm_chunk.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define BUF_COUNT 2
+#define BUF_SIZE CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_BUF_SIZE
+
+struct held_chunk {
+	int slot;
+	size_t len;
+};
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static void chunk_thread(void *arg1, void *arg2, void *arg3);
+static void hold(int slot, size_t len);
+static int send_held(lcz_ble_gw_dm_chunk_send_t send, void *user_data, uint32_t *chunks,
+		     uint32_t *bytes);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static uint8_t bufs[BUF_COUNT][BUF_SIZE];
+static size_t lens[BUF_COUNT];
+/* Buffers the packetizer can fill */
+static K_SEM_DEFINE(free_sem, 0, BUF_COUNT);
+/* Buffers the sender can send */
+static K_SEM_DEFINE(full_sem, 0, BUF_COUNT);
+static K_SEM_DEFINE(start_sem, 0, 1);
+static atomic_t stop;
+
+/* Set by the sender before the packetizer is started */
+static lcz_ble_gw_dm_chunk_read_t read_chunk;
+static size_t chunk_size;
+/* Written by the packetizer, read by the sender once the stream has ended */
+static uint32_t read_ms;
+
+/* Chunks read but not sent, oldest first. Only used by the sender, between streams. */
+static struct held_chunk held[BUF_COUNT];
+static int held_count;
+
+static struct k_spinlock lock;
+static struct lcz_ble_gw_dm_chunk_stats stats;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void chunk_thread(void *arg1, void *arg2, void *arg3)
+{
+	int slot;
+	size_t len;
+	bool more;
+	int64_t start;
+
+	ARG_UNUSED(arg1);
+	ARG_UNUSED(arg2);
+	ARG_UNUSED(arg3);
+
+	while (true) {
+		k_sem_take(&start_sem, K_FOREVER);
+		read_ms = 0;
+
+		for (slot = 0;; slot = (slot + 1) % BUF_COUNT) {
+			k_sem_take(&free_sem, K_FOREVER);
+
+			more = false;
+			if (!atomic_get(&stop)) {
+				len = chunk_size;
+				start = k_uptime_get();
+				more = read_chunk(bufs[slot], &len);
+				read_ms += (uint32_t)k_uptime_delta(&start);
+			}
+
+			lens[slot] = more ? len : 0;
+			k_sem_give(&full_sem);
+			if (!more) {
+				break;
+			}
+		}
+	}
+}
+
+static void hold(int slot, size_t len)
+{
+	held[held_count].slot = slot;
+	held[held_count].len = len;
+	held_count++;
+}
+
+static int send_held(lcz_ble_gw_dm_chunk_send_t send, void *user_data, uint32_t *chunks,
+		     uint32_t *bytes)
+{
+	int ret = 0;
+
+	while (held_count > 0) {
+		ret = send(bufs[held[0].slot], held[0].len, user_data);
+		if (ret < 0) {
+			break;
+		}
+		ret = 0;
+		*chunks += 1;
+		*bytes += held[0].len;
+		held_count--;
+		memmove(&held[0], &held[1], held_count * sizeof(held[0]));
+	}
+
+	return ret;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_ble_gw_dm_chunk_held_send(lcz_ble_gw_dm_chunk_send_t send, void *user_data)
+{
+	uint32_t chunks = 0;
+	uint32_t bytes = 0;
+
+	return send_held(send, user_data, &chunks, &bytes);
+}
+
+int lcz_ble_gw_dm_chunk_held_count(void)
+{
+	return held_count;
+}
+
+int lcz_ble_gw_dm_chunk_held_discard(void)
+{
+	int count = held_count;
+	k_spinlock_key_t key;
+
+	held_count = 0;
+	key = k_spin_lock(&lock);
+	stats.dropped += count;
+	k_spin_unlock(&lock, key);
+	return count;
+}
+
+int lcz_ble_gw_dm_chunk_stream(lcz_ble_gw_dm_chunk_read_t read, lcz_ble_gw_dm_chunk_send_t send,
+			       void *user_data, size_t size)
+{
+	uint32_t chunks = 0;
+	uint32_t bytes = 0;
+	uint32_t send_ms = 0;
+	uint32_t stall_ms = 0;
+	uint32_t duration;
+	k_spinlock_key_t key;
+	int64_t stream_start;
+	int64_t start;
+	size_t len;
+	int slot;
+	int ret = 0;
+	int i;
+
+	/* Older chunks first, the buffers are only refilled once they have been sent */
+	stream_start = k_uptime_get();
+	ret = send_held(send, user_data, &chunks, &bytes);
+	send_ms = (uint32_t)(k_uptime_get() - stream_start);
+	if (ret < 0) {
+		LOG_ERR("Kept chunk send failed: %d", ret);
+		return ret;
+	}
+
+	read_chunk = read;
+	chunk_size = CLAMP(size, 1, BUF_SIZE);
+	atomic_clear(&stop);
+	k_sem_reset(&full_sem);
+	k_sem_reset(&free_sem);
+	for (i = 0; i < BUF_COUNT; i++) {
+		k_sem_give(&free_sem);
+	}
+
+	k_sem_give(&start_sem);
+
+	for (slot = 0;; slot = (slot + 1) % BUF_COUNT) {
+		start = k_uptime_get();
+		k_sem_take(&full_sem, K_FOREVER);
+		stall_ms += (uint32_t)k_uptime_delta(&start);
+
+		len = lens[slot];
+		if (len == 0) {
+			break;
+		}
+
+		if (ret == 0) {
+			start = k_uptime_get();
+			ret = send(bufs[slot], len, user_data);
+			send_ms += (uint32_t)k_uptime_delta(&start);
+			if (ret < 0) {
+				LOG_ERR("Chunk send failed: %d", ret);
+				atomic_set(&stop, 1);
+				hold(slot, len);
+			} else {
+				ret = 0;
+				chunks++;
+				bytes += len;
+			}
+		} else {
+			/* Read ahead before the packetizer saw the stop */
+			hold(slot, len);
+		}
+
+		k_sem_give(&free_sem);
+	}
+	duration = (uint32_t)k_uptime_delta(&stream_start);
+
+	LOG_DBG("%u chunks %u bytes in %u ms (read %u ms send %u ms)", chunks, bytes, duration,
+		read_ms, send_ms);
+
+	key = k_spin_lock(&lock);
+	stats.streams++;
+	stats.chunks += chunks;
+	stats.bytes += bytes;
+	stats.chunk_size = chunk_size;
+	stats.read_ms = read_ms;
+	stats.send_ms = send_ms;
+	stats.stall_ms = stall_ms;
+	stats.last_ms = duration;
+	stats.last_bytes_per_s = (duration > 0) ? (uint32_t)(((uint64_t)bytes * 1000) / duration) :
+						  bytes;
+	k_spin_unlock(&lock, key);
+
+	return ret;
+}
+
+void lcz_ble_gw_dm_chunk_stats_get(struct lcz_ble_gw_dm_chunk_stats *s)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*s = stats;
+	s->held = held_count;
+	k_spin_unlock(&lock, key);
+}
+
+K_THREAD_DEFINE(memfault_chunk, CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_THREAD_STACK_SIZE,
+		chunk_thread, NULL, NULL, NULL,
+		K_PRIO_PREEMPT(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_THREAD_PRIORITY), 0, 0);
@@ -0,0 +1,157 @@
+/**
+ * @file lcz_ble_gw_dm_creds.c
+ * @brief Cache of the TLS credentials loaded for the LwM2M connections
+ *
+ * Loading credentials reads and decrypts the key and certificate files and registers them with
+ * the TLS stack. A load is skipped when the tag already holds the credentials and the size of
+ * each file is the same as when they were loaded. The sizes come from the directory entries, the
+ * files aren't read. The file rules invalidate the cache when a key file write completes, so a
+ * rotation to a key of the same size is still seen.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lcz_ble_gw_dm_creds, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <string.h>
+#include <file_system_utilities.h>
+
+#include "lcz_ble_gw_dm_creds.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+/* DM and telemetry */
+#define CREDS_CACHE_ENTRIES 2
+
+struct creds_entry {
+	bool valid;
+	LCZ_PKI_AUTH_STORE_T store;
+	int tls_tag;
+	/* Size of each file, negative errno if it can't be found */
+	ssize_t sizes[LCZ_PKI_AUTH_FILE__NUM];
+};
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static void sizes_get(LCZ_PKI_AUTH_STORE_T store, ssize_t *sizes);
+static struct creds_entry *entry_get(LCZ_PKI_AUTH_STORE_T store, int tls_tag);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static K_MUTEX_DEFINE(creds_mutex);
+static struct creds_entry cache[CREDS_CACHE_ENTRIES];
+static struct lcz_ble_gw_dm_creds_stats stats;
+static uint8_t next_victim;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void sizes_get(LCZ_PKI_AUTH_STORE_T store, ssize_t *sizes)
+{
+	char fname[FSU_MAX_ABS_PATH_SIZE + 1];
+	LCZ_PKI_AUTH_FILE_T file;
+
+	for (file = 0; file < LCZ_PKI_AUTH_FILE__NUM; file++) {
+		if (lcz_pki_auth_file_name_get(store, file, fname, sizeof(fname)) == 0) {
+			sizes[file] = fsu_get_file_size_abs(fname);
+		} else {
+			sizes[file] = -ENOENT;
+		}
+	}
+}
+
+/* Mutex must be held */
+static struct creds_entry *entry_get(LCZ_PKI_AUTH_STORE_T store, int tls_tag)
+{
+	struct creds_entry *entry;
+	int i;
+
+	for (i = 0; i < CREDS_CACHE_ENTRIES; i++) {
+		if (cache[i].valid && cache[i].store == store && cache[i].tls_tag == tls_tag) {
+			return &cache[i];
+		}
+	}
+
+	for (i = 0; i < CREDS_CACHE_ENTRIES; i++) {
+		if (!cache[i].valid) {
+			return &cache[i];
+		}
+	}
+
+	entry = &cache[next_victim];
+	next_victim = (next_victim + 1) % CREDS_CACHE_ENTRIES;
+	entry->valid = false;
+	return entry;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_ble_gw_dm_creds_load(LCZ_PKI_AUTH_STORE_T store, int tls_tag)
+{
+	ssize_t sizes[LCZ_PKI_AUTH_FILE__NUM];
+	struct creds_entry *entry;
+	uint32_t elapsed;
+	int64_t start;
+	int ret;
+
+	sizes_get(store, sizes);
+
+	k_mutex_lock(&creds_mutex, K_FOREVER);
+	entry = entry_get(store, tls_tag);
+	if (entry->valid && memcmp(entry->sizes, sizes, sizeof(sizes)) == 0) {
+		stats.hits++;
+		k_mutex_unlock(&creds_mutex);
+		return 0;
+	}
+
+	start = k_uptime_get();
+	ret = lcz_pki_auth_tls_credential_load(store, tls_tag, false);
+	elapsed = (uint32_t)(k_uptime_get() - start);
+
+	stats.loads++;
+	stats.load_total_ms += elapsed;
+	stats.load_max_ms = MAX(stats.load_max_ms, elapsed);
+	if (ret < 0) {
+		stats.failures++;
+		entry->valid = false;
+	} else {
+		entry->valid = true;
+		entry->store = store;
+		entry->tls_tag = tls_tag;
+		memcpy(entry->sizes, sizes, sizeof(sizes));
+	}
+	k_mutex_unlock(&creds_mutex);
+
+	LOG_DBG("Loaded credentials for tag %d in %u ms: %d", tls_tag, elapsed, ret);
+	return ret;
+}
+
+void lcz_ble_gw_dm_creds_invalidate(void)
+{
+	int i;
+
+	k_mutex_lock(&creds_mutex, K_FOREVER);
+	for (i = 0; i < CREDS_CACHE_ENTRIES; i++) {
+		cache[i].valid = false;
+	}
+	stats.invalidations++;
+	k_mutex_unlock(&creds_mutex);
+}
+
+void lcz_ble_gw_dm_creds_stats_get(struct lcz_ble_gw_dm_creds_stats *s)
+{
+	k_mutex_lock(&creds_mutex, K_FOREVER);
+	memcpy(s, &stats, sizeof(stats));
+	k_mutex_unlock(&creds_mutex);
+}
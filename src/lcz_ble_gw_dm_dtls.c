@@ -0,0 +1,236 @@
+/**
+ * @file lcz_ble_gw_dm_dtls.c
+ * @brief DTLS session reuse for the device management connection
+ *
+ * The socket layer keeps the last session for each peer when a socket is closed and offers it
+ * in the next handshake to the same peer. A resumed handshake skips the certificate exchange
+ * and key agreement. The session only lives in RAM, the socket API doesn't export it.
+ *
+ * The socket API doesn't report whether the server accepted the session either, so handshakes
+ * are counted by whether a session was offered. The byte counts come from the interface
+ * statistics, the socket doesn't have its own.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lcz_ble_gw_dm_dtls, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/net/socket.h>
+#if defined(CONFIG_NET_STATISTICS_USER_API)
+#include <zephyr/net/net_mgmt.h>
+#include <zephyr/net/net_stats.h>
+#endif
+#include <errno.h>
+#include <string.h>
+
+#include <lcz_memfault.h>
+
+#include "lcz_ble_gw_dm_dtls.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+struct handshake {
+	int64_t start;
+	uint64_t sent;
+	uint64_t received;
+	bool offered;
+	bool active;
+};
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static void bytes_get(uint64_t *sent, uint64_t *received);
+static bool cid_negotiated(struct lwm2m_ctx *client_ctx);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static struct k_spinlock lock;
+static struct lcz_ble_gw_dm_dtls_stats stats;
+static struct handshake handshake;
+/* Context of the DM connection, its socket is only valid while it is registered */
+static struct lwm2m_ctx *dm_ctx;
+static bool purge;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+/* Counts all interfaces, so it includes any other traffic during the handshake */
+static void bytes_get(uint64_t *sent, uint64_t *received)
+{
+#if defined(CONFIG_NET_STATISTICS_USER_API)
+	struct net_stats_bytes bytes;
+
+	if (net_mgmt(NET_REQUEST_STATS_GET_BYTES, NULL, &bytes, sizeof(bytes)) == 0) {
+		*sent = bytes.sent;
+		*received = bytes.received;
+		return;
+	}
+#endif
+	*sent = 0;
+	*received = 0;
+}
+
+static bool cid_negotiated(struct lwm2m_ctx *client_ctx)
+{
+#if defined(TLS_DTLS_CID_STATUS)
+	int status = TLS_DTLS_CID_STATUS_DISABLED;
+	socklen_t len = sizeof(status);
+
+	if (client_ctx != NULL && client_ctx->sock_fd >= 0 &&
+	    zsock_getsockopt(client_ctx->sock_fd, SOL_TLS, TLS_DTLS_CID_STATUS, &status,
+			     &len) == 0) {
+		return (status == TLS_DTLS_CID_STATUS_BIDIRECTIONAL);
+	}
+#else
+	ARG_UNUSED(client_ctx);
+#endif
+	return false;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_ble_gw_dm_dtls_set_socketoptions(struct lwm2m_ctx *client_ctx)
+{
+	sec_tag_t tls_tag_list[] = { client_ctx->tls_tag };
+	int session_cache = TLS_SESSION_CACHE_ENABLED;
+	char tmp;
+	int ret;
+
+	if (!client_ctx->use_dtls) {
+		return 0;
+	}
+
+	dm_ctx = client_ctx;
+
+	ret = zsock_setsockopt(client_ctx->sock_fd, SOL_TLS, TLS_SEC_TAG_LIST, tls_tag_list,
+			       sizeof(tls_tag_list));
+	if (ret < 0) {
+		LOG_ERR("Failed to set TLS_SEC_TAG_LIST option: %d", errno);
+		return -errno;
+	}
+
+	if (client_ctx->hostname_verify && client_ctx->desthostname != NULL) {
+		/* The host name isn't terminated, it points into the server URL */
+		tmp = client_ctx->desthostname[client_ctx->desthostnamelen];
+		client_ctx->desthostname[client_ctx->desthostnamelen] = '\0';
+		ret = zsock_setsockopt(client_ctx->sock_fd, SOL_TLS, TLS_HOSTNAME,
+				       client_ctx->desthostname, client_ctx->desthostnamelen);
+		client_ctx->desthostname[client_ctx->desthostnamelen] = tmp;
+		if (ret < 0) {
+			LOG_ERR("Failed to set TLS_HOSTNAME option: %d", errno);
+			return -errno;
+		}
+	}
+
+#if defined(TLS_SESSION_CACHE_PURGE)
+	if (purge) {
+		purge = false;
+		(void)zsock_setsockopt(client_ctx->sock_fd, SOL_TLS, TLS_SESSION_CACHE_PURGE, NULL,
+				       0);
+	}
+#endif
+
+	ret = zsock_setsockopt(client_ctx->sock_fd, SOL_TLS, TLS_SESSION_CACHE, &session_cache,
+			       sizeof(session_cache));
+	if (ret < 0) {
+		/* Not fatal, the handshake will be a full handshake */
+		LOG_WRN("Failed to enable TLS session cache: %d", errno);
+	}
+
+#if defined(TLS_DTLS_CID)
+	int cid = TLS_DTLS_CID_SUPPORTED;
+
+	ret = zsock_setsockopt(client_ctx->sock_fd, SOL_TLS, TLS_DTLS_CID, &cid, sizeof(cid));
+	if (ret < 0) {
+		LOG_WRN("Failed to enable DTLS connection ID: %d", errno);
+	}
+#endif
+
+	return 0;
+}
+
+void lcz_ble_gw_dm_dtls_handshake_start(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	handshake.offered = stats.session_cached;
+	handshake.start = k_uptime_get();
+	bytes_get(&handshake.sent, &handshake.received);
+	handshake.active = true;
+
+	k_spin_unlock(&lock, key);
+}
+
+void lcz_ble_gw_dm_dtls_handshake_done(bool success)
+{
+	struct lcz_ble_gw_dm_dtls_handshake_stats *hs;
+	k_spinlock_key_t key;
+	uint64_t received;
+	uint64_t sent;
+	bool offered = false;
+	bool active;
+	bool cid;
+
+	/* Read before taking the lock, this calls into the socket layer */
+	bytes_get(&sent, &received);
+	cid = success && cid_negotiated(dm_ctx);
+
+	key = k_spin_lock(&lock);
+	active = handshake.active;
+	if (active) {
+		handshake.active = false;
+		if (success) {
+			offered = handshake.offered;
+			hs = offered ? &stats.offered : &stats.full;
+			hs->count++;
+			hs->total_ms += (uint32_t)(k_uptime_get() - handshake.start);
+			hs->bytes_sent += sent - handshake.sent;
+			hs->bytes_received += received - handshake.received;
+			stats.cid_negotiated += cid ? 1 : 0;
+		} else {
+			stats.failed++;
+		}
+		/* A failed resumption may have been caused by a stale session */
+		stats.session_cached = success;
+	}
+	k_spin_unlock(&lock, key);
+
+	if (!active || !success) {
+		return;
+	}
+
+	if (offered) {
+		MFLT_METRICS_ADD(lwm2m_dm_dtls_offered, 1);
+	} else {
+		MFLT_METRICS_ADD(lwm2m_dm_dtls_full, 1);
+	}
+	LOG_INF("DM registered, cached session %s", offered ? "offered" : "not offered");
+}
+
+void lcz_ble_gw_dm_dtls_session_invalidate(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	stats.session_cached = false;
+	purge = true;
+	k_spin_unlock(&lock, key);
+}
+
+void lcz_ble_gw_dm_dtls_stats_get(struct lcz_ble_gw_dm_dtls_stats *s)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	memcpy(s, &stats, sizeof(stats));
+	k_spin_unlock(&lock, key);
+}
@@ -38,12 +38,25 @@ LOG_MODULE_REGISTER(lcz_ble_gw_dm_file_rules, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 #include <lcz_lwm2m_fw_update.h>
 #endif
 
+#include "lcz_ble_gw_dm_timer.h"
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+#include "lcz_ble_gw_dm_creds.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_TRACE)
+#include "lcz_ble_gw_dm_trace.h"
+#endif
+
 /**************************************************************************************************/
 /* Local Constant, Macro and Type Definitions                                                     */
 /**************************************************************************************************/
 #ifdef ATTR_ID_factory_load_path
 /* How long after the last write will writes to the factory load path still succeed */
-#define FACTORY_WRITE_DURATION K_SECONDS(1)
+#define FACTORY_WRITE_DURATION_MS 1000
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+/* How long after the last write request to a key file the write is considered complete */
+#define KEY_WRITE_DURATION_MS 1000
 #endif
 
 struct exec_queue_entry_t {
@@ -59,7 +72,10 @@ static bool is_key_file(char *path);
 #endif
 static int lcz_ble_gw_dm_file_rules_init(const struct device *device);
 static bool gw_dm_file_test(const char *path, bool write);
-static void factory_write_work_handler(struct k_work *work);
+static void factory_write_timer_handler(struct lcz_ble_gw_dm_timer *timer);
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+static void key_write_timer_handler(struct lcz_ble_gw_dm_timer *timer);
+#endif
 static int gw_dm_file_exec(const char *path);
 static void exec_work_handler(struct k_work *work);
 
@@ -67,7 +83,10 @@ static void exec_work_handler(struct k_work *work);
 /* Local Data Definitions                                                                         */
 /**************************************************************************************************/
 #ifdef ATTR_ID_factory_load_path
-static K_WORK_DELAYABLE_DEFINE(factory_write_work, factory_write_work_handler);
+static LCZ_BLE_GW_DM_TIMER_DEFINE(factory_write_timer, factory_write_timer_handler);
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+static LCZ_BLE_GW_DM_TIMER_DEFINE(key_write_timer, key_write_timer_handler);
 #endif
 static K_FIFO_DEFINE(exec_queue);
 static K_WORK_DEFINE(exec_work, exec_work_handler);
@@ -140,13 +159,13 @@ static bool gw_dm_file_test(const char *path, bool write)
 #if defined(ATTR_ID_factory_load_path)
 	load_path = (char *)attr_get_quasi_static(ATTR_ID_factory_load_path);
 	if (strcmp(load_path, simple_path) == 0) {
-		if (k_work_delayable_is_pending(&factory_write_work)) {
+		if (lcz_ble_gw_dm_timer_is_pending(&factory_write_timer)) {
 			/* Write of the factory file is pending */
-			k_work_reschedule(&factory_write_work, FACTORY_WRITE_DURATION);
+			lcz_ble_gw_dm_timer_start(&factory_write_timer, FACTORY_WRITE_DURATION_MS, 0);
 			return true;
 		} else if (efs_get_file_size(simple_path) < 0) {
 			/* New write of factory file is allowed */
-			k_work_reschedule(&factory_write_work, FACTORY_WRITE_DURATION);
+			lcz_ble_gw_dm_timer_start(&factory_write_timer, FACTORY_WRITE_DURATION_MS, 0);
 			return true;
 		}
 	}
@@ -155,6 +174,10 @@ static bool gw_dm_file_test(const char *path, bool write)
 	/* Writes of private/public key files are allowed */
 #if defined(CONFIG_LCZ_PKI_AUTH)
 	if (is_key_file(simple_path)) {
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+		/* The cached credentials are dropped once the write completes */
+		lcz_ble_gw_dm_timer_start(&key_write_timer, KEY_WRITE_DURATION_MS, 0);
+#endif
 		return true;
 	}
 #endif
@@ -163,11 +186,19 @@ static bool gw_dm_file_test(const char *path, bool write)
 	return false;
 }
 
-static void factory_write_work_handler(struct k_work *work)
+static void factory_write_timer_handler(struct lcz_ble_gw_dm_timer *timer)
 {
 	/* Nothing to do */
 }
 
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+static void key_write_timer_handler(struct lcz_ble_gw_dm_timer *timer)
+{
+	/* A new key may have the same size as the old one */
+	lcz_ble_gw_dm_creds_invalidate();
+}
+#endif
+
 static int gw_dm_file_exec(const char *path)
 {
 	char simple_path[FSU_MAX_ABS_PATH_SIZE + 1];
@@ -228,6 +259,29 @@ static int gw_dm_file_exec(const char *path)
 	}
 #endif
 
+	/* Attempting to execute the trace path will dump the state transition trace */
+#if defined(CONFIG_LCZ_BLE_GW_DM_TRACE)
+	if (strcmp(CONFIG_LCZ_BLE_GW_DM_TRACE_PATH, simple_path) == 0) {
+		size_t size = lcz_ble_gw_dm_trace_dump_size();
+		uint8_t *buf = k_malloc(size);
+
+		if (buf == NULL) {
+			return -ENOMEM;
+		}
+		ret = lcz_ble_gw_dm_trace_dump(buf, size);
+		if (ret > 0) {
+			if (fsu_write_abs(simple_path, buf, ret) == ret) {
+				lcz_lwm2m_obj_fs_mgmt_exec_complete(0);
+				ret = 0;
+			} else {
+				ret = -ENOENT;
+			}
+		}
+		k_free(buf);
+		return ret;
+	}
+#endif
+
 	/* Allow shell scripts to be executed */
 #if defined(CONFIG_LCZ_SHELL_SCRIPT_RUNNER)
 	if (lcz_zsh_is_script(simple_path) == true) {
@@ -0,0 +1,541 @@
+/**
+ * @file lcz_ble_gw_dm_mflt_store.c
+ * @brief Segmented ring store for Memfault chunks that can't be uploaded
+ *
+ * An index of the segments is loaded from the directory on first use. Appends only write to the
+ * newest segment, which is never reopened after a reboot so that a record torn by a reset is
+ * only ever at the end of a segment.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lcz_ble_gw_dm_mflt_store, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/sys/crc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <file_system_utilities.h>
+
+#include "lcz_ble_gw_dm_mflt_store.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define STORE_DIR CONFIG_FSU_MOUNT_POINT "/" CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE_DIR
+#define MAX_SIZE CONFIG_LCZ_BLE_GW_DM_MEMFAULT_FILE_MAX_SIZE_BYTES
+#define SEGMENT_SIZE CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE_SEGMENT_SIZE
+#define MAX_SEGMENTS CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE_MAX_SEGMENTS
+#define SEGMENT_NAME_LEN 12 /* "xxxxxxxx.seg" */
+#define COMMIT_NAME "commit"
+#define COMMIT_PATH STORE_DIR "/" COMMIT_NAME
+/* Written by the single file save used without the store */
+#define LEGACY_FILE_PATH CONFIG_FSU_MOUNT_POINT "/" CONFIG_LCZ_BLE_GW_DM_MEMFAULT_FILE_NAME
+
+struct seg_header {
+	uint32_t magic;
+	uint8_t version;
+	uint8_t cls;
+	uint16_t reserved;
+	uint32_t seq;
+} __packed;
+
+struct rec_header {
+	uint16_t len;
+	uint16_t reserved;
+	uint32_t crc;
+} __packed;
+
+struct commit_record {
+	uint32_t magic;
+	uint32_t seq;
+	uint32_t offset;
+	/* crc32_ieee of the fields above */
+	uint32_t crc;
+} __packed;
+
+struct segment {
+	uint32_t seq;
+	uint32_t size;
+	uint8_t cls;
+};
+
+BUILD_ASSERT((2 * SEGMENT_SIZE) <= MAX_SIZE, "The store must hold at least two segments");
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static void segment_path(char *path, uint32_t seq);
+static int load(void);
+static void index_insert(const struct segment *seg);
+static int pick_victim(bool keep_head);
+static void remove_segment(int i);
+static void evict(int i);
+static int new_segment(enum lcz_ble_gw_dm_mflt_store_class cls);
+static int append_record(struct segment *seg, const void *chunk, size_t len);
+static int find_segment(uint32_t seq);
+static int read_record(const struct segment *seg, uint32_t offset, void *buf, size_t size,
+		       size_t *len);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static K_MUTEX_DEFINE(store_mutex);
+static bool loaded;
+/* Sorted by sequence number, oldest first */
+static struct segment segs[MAX_SEGMENTS];
+static int count;
+static uint32_t total_size;
+static uint32_t next_seq = 1;
+/* Everything before this position has been uploaded */
+static struct lcz_ble_gw_dm_mflt_store_pos committed;
+/* The newest segment can be appended to */
+static bool head_open;
+static struct lcz_ble_gw_dm_mflt_store_stats stats;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void segment_path(char *path, uint32_t seq)
+{
+	snprintk(path, FSU_MAX_ABS_PATH_SIZE + 1, STORE_DIR "/%08x.seg", seq);
+}
+
+/* Mutex must be held */
+static int load(void)
+{
+	struct fs_dirent entry;
+	struct commit_record rec;
+	struct seg_header hdr;
+	struct segment seg;
+	struct fs_dir_t dir;
+	struct fs_file_t file;
+	char path[FSU_MAX_ABS_PATH_SIZE + 1];
+	ssize_t legacy_size;
+	char *end;
+	bool valid;
+	int ret;
+
+	if (loaded) {
+		return 0;
+	}
+
+	/* The store can't read the single file format, and keeping the file after an update
+	 * would use the space of a second store.
+	 */
+	legacy_size = fsu_get_file_size_abs(LEGACY_FILE_PATH);
+	if (legacy_size >= 0) {
+		LOG_WRN("Deleting %s (%d bytes)", LEGACY_FILE_PATH, (int)legacy_size);
+		(void)fs_unlink(LEGACY_FILE_PATH);
+	}
+
+	ret = fs_mkdir(STORE_DIR);
+	if (ret < 0 && ret != -EEXIST) {
+		LOG_ERR("Unable to create %s: %d", STORE_DIR, ret);
+		return ret;
+	}
+
+	fs_dir_t_init(&dir);
+	ret = fs_opendir(&dir, STORE_DIR);
+	if (ret < 0) {
+		return ret;
+	}
+
+	while (fs_readdir(&dir, &entry) == 0 && entry.name[0] != '\0') {
+		if (entry.type != FS_DIR_ENTRY_FILE || strcmp(entry.name, COMMIT_NAME) == 0) {
+			continue;
+		}
+
+		snprintk(path, sizeof(path), STORE_DIR "/%s", entry.name);
+		seg.seq = strtoul(entry.name, &end, 16);
+		valid = (strlen(entry.name) == SEGMENT_NAME_LEN && strcmp(end, ".seg") == 0 &&
+			 entry.size >= sizeof(hdr));
+		if (valid) {
+			fs_file_t_init(&file);
+			valid = (fs_open(&file, path, FS_O_READ) == 0);
+			if (valid) {
+				valid = (fs_read(&file, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+					 hdr.magic == LCZ_BLE_GW_DM_MFLT_STORE_MAGIC &&
+					 hdr.version == LCZ_BLE_GW_DM_MFLT_STORE_VERSION &&
+					 hdr.seq == seg.seq &&
+					 hdr.cls < LCZ_BLE_GW_DM_MFLT_STORE_CLASS__NUM);
+				(void)fs_close(&file);
+			}
+		}
+
+		if (!valid || count >= MAX_SEGMENTS) {
+			LOG_WRN("Deleting %s", path);
+			(void)fs_unlink(path);
+			continue;
+		}
+
+		seg.size = entry.size;
+		seg.cls = hdr.cls;
+		index_insert(&seg);
+		total_size += seg.size;
+		next_seq = MAX(next_seq, seg.seq + 1);
+	}
+	(void)fs_closedir(&dir);
+
+	if (fsu_read_abs(COMMIT_PATH, &rec, sizeof(rec)) == sizeof(rec) &&
+	    rec.magic == LCZ_BLE_GW_DM_MFLT_STORE_MAGIC &&
+	    rec.crc == crc32_ieee((const uint8_t *)&rec, offsetof(struct commit_record, crc))) {
+		committed.seq = rec.seq;
+		committed.offset = rec.offset;
+		next_seq = MAX(next_seq, rec.seq + 1);
+	}
+
+	LOG_INF("%d segments %u bytes", count, total_size);
+	head_open = false;
+	loaded = true;
+	return 0;
+}
+
+static void index_insert(const struct segment *seg)
+{
+	int i = count;
+
+	while (i > 0 && segs[i - 1].seq > seg->seq) {
+		segs[i] = segs[i - 1];
+		i--;
+	}
+	segs[i] = *seg;
+	count++;
+}
+
+/* Oldest data segment, or the oldest coredump segment if there are only coredumps */
+static int pick_victim(bool keep_head)
+{
+	int limit = (keep_head && head_open) ? (count - 1) : count;
+	int i;
+
+	for (i = 0; i < limit; i++) {
+		if (segs[i].cls != LCZ_BLE_GW_DM_MFLT_STORE_COREDUMP) {
+			return i;
+		}
+	}
+
+	return (limit > 0) ? 0 : -1;
+}
+
+static void remove_segment(int i)
+{
+	char path[FSU_MAX_ABS_PATH_SIZE + 1];
+
+	segment_path(path, segs[i].seq);
+	(void)fs_unlink(path);
+
+	if (i == (count - 1)) {
+		head_open = false;
+	}
+	total_size -= segs[i].size;
+	count--;
+	memmove(&segs[i], &segs[i + 1], (count - i) * sizeof(segs[0]));
+}
+
+static void evict(int i)
+{
+	LOG_WRN("Evicting segment %u (%u bytes)", segs[i].seq, segs[i].size);
+
+	stats.evicted++;
+	stats.evicted_bytes += segs[i].size;
+	if (segs[i].cls == LCZ_BLE_GW_DM_MFLT_STORE_COREDUMP) {
+		stats.evicted_coredumps++;
+	}
+	remove_segment(i);
+}
+
+static int new_segment(enum lcz_ble_gw_dm_mflt_store_class cls)
+{
+	struct seg_header hdr = { .magic = LCZ_BLE_GW_DM_MFLT_STORE_MAGIC,
+				  .version = LCZ_BLE_GW_DM_MFLT_STORE_VERSION,
+				  .cls = cls,
+				  .seq = next_seq };
+	struct fs_file_t file;
+	char path[FSU_MAX_ABS_PATH_SIZE + 1];
+	ssize_t written;
+	int ret;
+
+	segment_path(path, hdr.seq);
+	fs_file_t_init(&file);
+	ret = fs_open(&file, path, FS_O_CREATE | FS_O_WRITE);
+	if (ret < 0) {
+		LOG_ERR("Unable to create %s: %d", path, ret);
+		return ret;
+	}
+	written = fs_write(&file, &hdr, sizeof(hdr));
+	(void)fs_close(&file);
+	if (written != sizeof(hdr)) {
+		(void)fs_unlink(path);
+		return (written < 0) ? (int)written : -ENOSPC;
+	}
+
+	next_seq++;
+	segs[count].seq = hdr.seq;
+	segs[count].size = sizeof(hdr);
+	segs[count].cls = cls;
+	count++;
+	total_size += sizeof(hdr);
+	head_open = true;
+	return 0;
+}
+
+static int append_record(struct segment *seg, const void *chunk, size_t len)
+{
+	struct rec_header rec = { .len = (uint16_t)len, .crc = crc32_ieee(chunk, len) };
+	struct fs_file_t file;
+	char path[FSU_MAX_ABS_PATH_SIZE + 1];
+	ssize_t written;
+	int ret;
+
+	segment_path(path, seg->seq);
+	fs_file_t_init(&file);
+	ret = fs_open(&file, path, FS_O_WRITE | FS_O_APPEND);
+	if (ret < 0) {
+		return ret;
+	}
+
+	written = fs_write(&file, &rec, sizeof(rec));
+	if (written == sizeof(rec)) {
+		written = fs_write(&file, chunk, len);
+		ret = (written == (ssize_t)len) ? 0 : -EIO;
+	} else {
+		ret = -EIO;
+	}
+	(void)fs_close(&file);
+
+	if (ret < 0) {
+		/* The end of the segment may hold part of a record, don't add to it */
+		head_open = false;
+		seg->size = fsu_get_file_size_abs(path);
+	} else {
+		seg->size += sizeof(rec) + len;
+	}
+	return ret;
+}
+
+/* Index of the first segment at or after seq, -1 if there is none */
+static int find_segment(uint32_t seq)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (segs[i].seq >= seq) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Returns the record length plus its header, or a negative error code */
+static int read_record(const struct segment *seg, uint32_t offset, void *buf, size_t size,
+		       size_t *len)
+{
+	struct rec_header rec;
+	struct fs_file_t file;
+	char path[FSU_MAX_ABS_PATH_SIZE + 1];
+	int ret;
+
+	segment_path(path, seg->seq);
+	fs_file_t_init(&file);
+	ret = fs_open(&file, path, FS_O_READ);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = fs_seek(&file, offset, FS_SEEK_SET);
+	if (ret == 0) {
+		if (fs_read(&file, &rec, sizeof(rec)) != sizeof(rec) || rec.len == 0 ||
+		    (offset + sizeof(rec) + rec.len) > seg->size) {
+			ret = -EBADMSG;
+		} else if (rec.len > size) {
+			ret = -ENOBUFS;
+		} else if (fs_read(&file, buf, rec.len) != rec.len ||
+			   crc32_ieee(buf, rec.len) != rec.crc) {
+			ret = -EBADMSG;
+		} else {
+			*len = rec.len;
+			ret = sizeof(rec) + rec.len;
+		}
+	}
+	(void)fs_close(&file);
+
+	return ret;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_ble_gw_dm_mflt_store_append(enum lcz_ble_gw_dm_mflt_store_class cls, const void *chunk,
+				    size_t len)
+{
+	struct segment *head;
+	uint32_t need;
+	bool start_new;
+	int victim;
+	int ret;
+
+	if (len == 0 || len > UINT16_MAX || cls >= LCZ_BLE_GW_DM_MFLT_STORE_CLASS__NUM) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&store_mutex, K_FOREVER);
+	ret = load();
+	if (ret < 0) {
+		goto exit;
+	}
+
+	need = sizeof(struct rec_header) + len;
+	head = (head_open && count > 0) ? &segs[count - 1] : NULL;
+	start_new = (head == NULL || head->cls != cls || (head->size + need) > SEGMENT_SIZE);
+	if (start_new) {
+		need += sizeof(struct seg_header);
+	}
+
+	while ((total_size + need) > MAX_SIZE || (start_new && count >= MAX_SEGMENTS)) {
+		victim = pick_victim(!start_new);
+		if (victim < 0) {
+			ret = -ENOSPC;
+			goto exit;
+		}
+		evict(victim);
+	}
+
+	if (start_new) {
+		ret = new_segment(cls);
+		if (ret < 0) {
+			goto exit;
+		}
+	}
+
+	head = &segs[count - 1];
+	total_size -= head->size;
+	ret = append_record(head, chunk, len);
+	total_size += head->size;
+	if (ret == 0) {
+		stats.appended++;
+	} else {
+		LOG_ERR("Unable to append to segment %u: %d", head->seq, ret);
+	}
+
+exit:
+	k_mutex_unlock(&store_mutex);
+	return ret;
+}
+
+int lcz_ble_gw_dm_mflt_store_read(struct lcz_ble_gw_dm_mflt_store_pos *pos, void *buf,
+				  size_t size, size_t *len)
+{
+	int i;
+	int ret;
+
+	k_mutex_lock(&store_mutex, K_FOREVER);
+	ret = load();
+
+	while (ret == 0) {
+		i = find_segment(pos->seq);
+		if (i < 0) {
+			ret = -ENODATA;
+			break;
+		}
+		if (segs[i].seq != pos->seq || pos->offset < sizeof(struct seg_header)) {
+			pos->seq = segs[i].seq;
+			pos->offset = sizeof(struct seg_header);
+		}
+		if (pos->offset >= segs[i].size) {
+			if (i == (count - 1)) {
+				/* Stay at the end of the newest segment, it may still grow */
+				ret = -ENODATA;
+				break;
+			}
+			pos->seq++;
+			pos->offset = 0;
+			continue;
+		}
+
+		ret = read_record(&segs[i], pos->offset, buf, size, len);
+		if (ret == -EBADMSG) {
+			/* Records can't be found after a bad one, go to the next segment */
+			LOG_WRN("Bad record in segment %u at %u", pos->seq, pos->offset);
+			stats.corrupt++;
+			pos->seq++;
+			pos->offset = 0;
+			ret = 0;
+		} else if (ret > 0) {
+			pos->offset += ret;
+			ret = 0;
+			break;
+		}
+	}
+
+	k_mutex_unlock(&store_mutex);
+	return ret;
+}
+
+int lcz_ble_gw_dm_mflt_store_commit(const struct lcz_ble_gw_dm_mflt_store_pos *pos)
+{
+	struct commit_record rec = { .magic = LCZ_BLE_GW_DM_MFLT_STORE_MAGIC,
+				     .seq = pos->seq,
+				     .offset = pos->offset };
+	ssize_t written;
+	int ret;
+
+	rec.crc = crc32_ieee((const uint8_t *)&rec, offsetof(struct commit_record, crc));
+
+	k_mutex_lock(&store_mutex, K_FOREVER);
+	ret = load();
+	if (ret == 0) {
+		committed = *pos;
+		while (count > 0 && segs[0].seq < pos->seq) {
+			remove_segment(0);
+		}
+
+		written = fsu_write_abs(COMMIT_PATH, &rec, sizeof(rec));
+		ret = (written == sizeof(rec)) ? 0 : -EIO;
+	}
+	k_mutex_unlock(&store_mutex);
+
+	return ret;
+}
+
+void lcz_ble_gw_dm_mflt_store_committed(struct lcz_ble_gw_dm_mflt_store_pos *pos)
+{
+	k_mutex_lock(&store_mutex, K_FOREVER);
+	(void)load();
+	*pos = committed;
+	k_mutex_unlock(&store_mutex);
+}
+
+void lcz_ble_gw_dm_mflt_store_stats_get(struct lcz_ble_gw_dm_mflt_store_stats *s)
+{
+	uint32_t start;
+	int i;
+
+	k_mutex_lock(&store_mutex, K_FOREVER);
+	(void)load();
+	*s = stats;
+	s->segments = count;
+	s->coredump_segments = 0;
+	s->backlog = 0;
+	for (i = 0; i < count; i++) {
+		if (segs[i].cls == LCZ_BLE_GW_DM_MFLT_STORE_COREDUMP) {
+			s->coredump_segments++;
+		}
+		if (segs[i].seq > committed.seq) {
+			s->backlog += segs[i].size - sizeof(struct seg_header);
+		} else if (segs[i].seq == committed.seq) {
+			start = MAX(committed.offset, sizeof(struct seg_header));
+			s->backlog += (segs[i].size > start) ? (segs[i].size - start) : 0;
+		}
+	}
+	s->bytes = total_size;
+	k_mutex_unlock(&store_mutex);
+}
@@ -0,0 +1,477 @@
+/**
+ * @file lcz_ble_gw_dm_shell.c
+ * @brief Shell commands for inspecting the gateway device manager
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/shell/shell.h>
+#include <stdlib.h>
+
+#include "lcz_ble_gw_dm_task.h"
+#include "lcz_ble_gw_dm_timer.h"
+#include "lcz_ble_gw_dm_time.h"
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+#include "lcz_ble_gw_dm_dtls.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+#include "lcz_ble_gw_dm_creds.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_TRACE)
+#include "lcz_ble_gw_dm_trace.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_STACK_MONITOR)
+#include "lcz_ble_gw_dm_stack.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+#include "memfault_task.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+#include "lcz_ble_gw_dm_chunk.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE)
+#include "lcz_ble_gw_dm_mflt_store.h"
+#endif
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static int cmd_state(const struct shell *shell, size_t argc, char **argv)
+{
+	uint32_t time_in_state_ms;
+	int state = lcz_ble_gw_dm_state_get(&time_in_state_ms);
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(shell, "%s for %u ms", lcz_ble_gw_dm_state_name(state), time_in_state_ms);
+	return 0;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+static int cmd_stats(const struct shell *shell, size_t argc, char **argv)
+{
+	static const uint32_t EDGES[] = LCZ_BLE_GW_DM_STATE_HIST_EDGES_S;
+	struct lcz_ble_gw_dm_state_stats stats;
+	int state;
+	int b;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_fprintf(shell, SHELL_NORMAL, "%-30s %6s %10s %10s |", "state", "count", "total_s",
+		      "max_s");
+	for (b = 0; b < ARRAY_SIZE(EDGES); b++) {
+		shell_fprintf(shell, SHELL_NORMAL, " <%-4u", EDGES[b]);
+	}
+	shell_fprintf(shell, SHELL_NORMAL, " >=%-3u\n", EDGES[ARRAY_SIZE(EDGES) - 1]);
+
+	for (state = 0; state < lcz_ble_gw_dm_state_count(); state++) {
+		if (lcz_ble_gw_dm_state_stats_get(state, &stats) < 0) {
+			continue;
+		}
+		shell_fprintf(shell, SHELL_NORMAL, "%-30s %6u %10u %10u |",
+			      lcz_ble_gw_dm_state_name(state), stats.transitions,
+			      (uint32_t)(stats.total_ms / MSEC_PER_SEC), stats.max_ms / MSEC_PER_SEC);
+		for (b = 0; b < LCZ_BLE_GW_DM_STATE_HIST_BUCKETS; b++) {
+			shell_fprintf(shell, SHELL_NORMAL, " %5u", stats.hist[b]);
+		}
+		shell_fprintf(shell, SHELL_NORMAL, "\n");
+	}
+
+	return 0;
+}
+
+static int cmd_stats_clear(const struct shell *shell, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_state_stats_clear();
+	shell_print(shell, "State statistics cleared");
+	return 0;
+}
+#endif
+
+static int cmd_queue(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_queue_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_queue_stats_get(&stats);
+	shell_print(shell, "used %u/%u high-water %u", stats.used, stats.depth, stats.high_water);
+	shell_print(shell, "accepted %u coalesced %u filtered %u dropped %u", stats.accepted,
+		    stats.coalesced, stats.filtered, stats.dropped);
+	return 0;
+}
+
+static int cmd_queue_clear(const struct shell *shell, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_queue_stats_clear();
+	shell_print(shell, "Queue statistics cleared");
+	return 0;
+}
+
+static void print_timer(const struct lcz_ble_gw_dm_timer *timer, int64_t remaining_ms,
+			void *user_data)
+{
+	const struct shell *shell = user_data;
+
+	if (remaining_ms < 0) {
+		shell_print(shell, "%-36s %10s %8u", timer->name, "stopped", timer->expirations);
+	} else {
+		shell_print(shell, "%-36s %10u %8u", timer->name, (uint32_t)remaining_ms,
+			    timer->expirations);
+	}
+}
+
+static int cmd_timers(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_timer_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_timer_stats_get(&stats);
+	shell_print(shell, "expirations %u (last hour %u, average %u/hour) wakeups %u",
+		    stats.expirations, stats.expirations_last_hour, stats.expirations_per_hour,
+		    stats.wakeups);
+	if (stats.next_deadline >= 0) {
+		shell_print(shell, "next deadline in %u ms",
+			    (uint32_t)MAX(stats.next_deadline - k_uptime_get(), 0));
+	}
+	shell_print(shell, "%-36s %10s %8s", "timer", "remain_ms", "expired");
+	lcz_ble_gw_dm_timer_foreach(print_timer, (void *)shell);
+	return 0;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+static int cmd_recovery(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_recovery_stats stats;
+	int step;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_recovery_stats_get(&stats);
+	shell_print(shell, "current step: %s", lcz_ble_gw_dm_recovery_step_name(stats.step));
+	shell_print(shell, "last recovery took %u ms", stats.last_recovery_ms);
+	shell_print(shell, "%-30s %8s %10s", "step", "attempts", "recovered");
+	for (step = LCZ_BLE_GW_DM_RECOVERY_NONE + 1; step < LCZ_BLE_GW_DM_RECOVERY_STEP__NUM;
+	     step++) {
+		shell_print(shell, "%-30s %8u %10u", lcz_ble_gw_dm_recovery_step_name(step),
+			    stats.attempts[step], stats.recovered[step]);
+	}
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+static void print_dispatch_timing(const struct shell *shell, const char *name, const char *type,
+				  uint32_t count,
+				  const struct lcz_ble_gw_dm_dispatch_timing *timing)
+{
+	shell_print(shell, "%-22s %-4s %8u %10u %10u %10u %10u", name, type, count, timing->min_us,
+		    (count > 0) ? (uint32_t)(timing->total_us / count) : 0,
+		    lcz_ble_gw_dm_dispatch_percentile(timing, count, 99), timing->max_us);
+}
+
+static int cmd_dispatch(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_dispatch_stats stats;
+	int msg;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(shell, "%-22s %-4s %8s %10s %10s %10s %10s", "message", "time", "count",
+		    "min_us", "mean_us", "p99_us", "max_us");
+	for (msg = 0; msg < LCZ_BLE_GW_DM_DISPATCH_MSG__NUM; msg++) {
+		if (lcz_ble_gw_dm_dispatch_stats_get(msg, &stats) < 0 || stats.count == 0) {
+			continue;
+		}
+		print_dispatch_timing(shell, lcz_ble_gw_dm_dispatch_msg_name(msg), "exec",
+				      stats.count, &stats.exec);
+		print_dispatch_timing(shell, "", "wait", stats.count, &stats.wait);
+	}
+	return 0;
+}
+
+static int cmd_dispatch_clear(const struct shell *shell, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_dispatch_stats_clear();
+	shell_print(shell, "Dispatch statistics cleared");
+	return 0;
+}
+#endif
+
+static int cmd_time(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_time_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_time_stats_get(&stats);
+	shell_print(shell, "source: %s", lcz_ble_gw_dm_time_source_name(stats.source));
+	if (stats.age_ms >= 0) {
+		shell_print(shell, "age %u s estimated error %u ms",
+			    (uint32_t)(stats.age_ms / MSEC_PER_SEC), stats.error_ms);
+	}
+	shell_print(shell, "drift %u ppm (measured %u ppm)", stats.drift_ppm,
+		    stats.measured_drift_ppm);
+	shell_print(shell, "updates %u queries %u skipped %u", stats.updates, stats.queries,
+		    stats.queries_skipped);
+	shell_print(shell, "LwM2M writes %u offset %d s", stats.lwm2m_writes,
+		    stats.lwm2m_offset_s);
+	if (stats.lwm2m_write_age_ms >= 0) {
+		shell_print(shell, "LwM2M write age %u s",
+			    (uint32_t)(stats.lwm2m_write_age_ms / MSEC_PER_SEC));
+	}
+	return 0;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+static int cmd_psm(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_psm_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_psm_stats_get(&stats);
+	shell_print(shell, "radio %s, on %u s since boot (%u s/day)", stats.radio_on ? "on" : "off",
+		    stats.radio_on_s, stats.radio_on_per_day);
+	shell_print(shell, "wakes %u aligned updates %u", stats.wakes, stats.aligned_updates);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+static void print_handshakes(const struct shell *shell, const char *name,
+			     const struct lcz_ble_gw_dm_dtls_handshake_stats *hs)
+{
+	shell_print(shell, "%-8s %6u %10u %12llu %12llu", name, hs->count,
+		    (hs->count > 0) ? (hs->total_ms / hs->count) : 0, hs->bytes_sent,
+		    hs->bytes_received);
+}
+
+static int cmd_dtls(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_dtls_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_dtls_stats_get(&stats);
+	shell_print(shell, "session cached: %s", stats.session_cached ? "yes" : "no");
+	shell_print(shell, "failed %u connection ID %u", stats.failed, stats.cid_negotiated);
+	shell_print(shell, "%-8s %6s %10s %12s %12s", "type", "count", "avg_ms", "sent",
+		    "received");
+	print_handshakes(shell, "full", &stats.full);
+	print_handshakes(shell, "offered", &stats.offered);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+static int cmd_creds(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_creds_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_creds_stats_get(&stats);
+	shell_print(shell, "hits %u loads %u failures %u invalidations %u", stats.hits,
+		    stats.loads, stats.failures, stats.invalidations);
+	shell_print(shell, "load time average %u ms max %u ms",
+		    (stats.loads > 0) ? (stats.load_total_ms / stats.loads) : 0, stats.load_max_ms);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_TRACE)
+static void print_trace_record(const struct lcz_ble_gw_dm_trace_record *record, void *user_data)
+{
+	const struct shell *shell = (const struct shell *)user_data;
+	const char *cause = lcz_ble_gw_dm_trace_cause_name(record->cause);
+
+	shell_print(shell, "%5u %10u %-30s %-30s %-14s %5u %5u", record->seq, record->timestamp_ms,
+		    lcz_ble_gw_dm_state_name(record->from), lcz_ble_gw_dm_state_name(record->to),
+		    (cause != NULL) ? cause : "?", record->lwm2m_event, record->cnx_tries);
+}
+
+static int cmd_trace(const struct shell *shell, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	shell_print(shell, "%5s %10s %-30s %-30s %-14s %5s %5s", "seq", "ms", "from", "to",
+		    "cause", "event", "tries");
+	lcz_ble_gw_dm_trace_foreach(print_trace_record, (void *)shell);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_STACK_MONITOR)
+static int cmd_stack(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_stack_stats stats;
+	int i;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_stack_sample();
+	shell_print(shell, "%-12s %8s %8s %8s %5s", "thread", "size", "max_used", "free", "%");
+	for (i = 0; i < lcz_ble_gw_dm_stack_count(); i++) {
+		if (lcz_ble_gw_dm_stack_stats_get(i, &stats) < 0 || stats.size == 0) {
+			continue;
+		}
+		shell_print(shell, "%-12s %8u %8u %8u %5u", stats.name, stats.size, stats.max_used,
+			    stats.size - stats.max_used, (stats.max_used * 100) / stats.size);
+	}
+	return 0;
+}
+
+static int cmd_stack_exercise(const struct shell *shell, size_t argc, char **argv)
+{
+	int ret;
+
+	shell_print(shell, "Exercising, this can take a while...");
+	ret = lcz_ble_gw_dm_stack_exercise((argc > 1) ? argv[1] : NULL);
+	if (ret < 0) {
+		shell_error(shell, "Exercise failed: %d", ret);
+	}
+	return cmd_stack(shell, 1, argv);
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+static int cmd_memfault(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_memfault_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_memfault_stats_get(&stats);
+	shell_print(shell, "uploads %u requests %u merged %u queued %u", stats.uploads,
+		    stats.requests, stats.merged, stats.queued);
+	shell_print(shell, "last %u ms (%d) max %u ms", stats.last_ms, stats.last_result,
+		    stats.max_ms);
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+	shell_print(shell, "drain batches %u bytes %u last %u B/s backlog %u",
+		    stats.drain_batches, stats.drain_bytes, stats.drain_bytes_per_s,
+		    stats.drain_backlog);
+#endif
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+static int cmd_chunks(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_chunk_stats stats;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_chunk_stats_get(&stats);
+	shell_print(shell, "streams %u chunks %u bytes %u", stats.streams, stats.chunks,
+		    stats.bytes);
+	shell_print(shell, "last %u ms %u B/s chunk size %u", stats.last_ms,
+		    stats.last_bytes_per_s, stats.chunk_size);
+	shell_print(shell, "read %u ms send %u ms stall %u ms", stats.read_ms, stats.send_ms,
+		    stats.stall_ms);
+	shell_print(shell, "kept %u dropped %u", stats.held, stats.dropped);
+	return 0;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE)
+static int cmd_mflt_store(const struct shell *shell, size_t argc, char **argv)
+{
+	struct lcz_ble_gw_dm_mflt_store_stats stats;
+	struct lcz_ble_gw_dm_mflt_store_pos pos;
+
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	lcz_ble_gw_dm_mflt_store_stats_get(&stats);
+	lcz_ble_gw_dm_mflt_store_committed(&pos);
+	shell_print(shell, "segments %u (coredump %u) bytes %u appended %u", stats.segments,
+		    stats.coredump_segments, stats.bytes, stats.appended);
+	shell_print(shell, "evicted %u (coredump %u) bytes %u corrupt %u", stats.evicted,
+		    stats.evicted_coredumps, stats.evicted_bytes, stats.corrupt);
+	shell_print(shell, "backlog %u committed %08x:%u", stats.backlog, pos.seq, pos.offset);
+	return 0;
+}
+#endif
+
+/**************************************************************************************************/
+/* Shell Commands                                                                                 */
+/**************************************************************************************************/
+SHELL_STATIC_SUBCMD_SET_CREATE(
+	gw_dm_cmds, SHELL_CMD(state, NULL, "Current gateway state", cmd_state),
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+	SHELL_CMD(stats, NULL, "Time-in-state histograms", cmd_stats),
+	SHELL_CMD(stats_clear, NULL, "Clear time-in-state histograms", cmd_stats_clear),
+#endif
+	SHELL_CMD(queue, NULL, "Task queue statistics", cmd_queue),
+	SHELL_CMD(queue_clear, NULL, "Clear task queue statistics", cmd_queue_clear),
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+	SHELL_CMD(dispatch, NULL, "Message handler and queue wait times", cmd_dispatch),
+	SHELL_CMD(dispatch_clear, NULL, "Clear message handler times", cmd_dispatch_clear),
+#endif
+	SHELL_CMD(timers, NULL, "Timer service deadlines and expirations", cmd_timers),
+	SHELL_CMD(time, NULL, "Time source and estimated error", cmd_time),
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+	SHELL_CMD(psm, NULL, "Power save statistics", cmd_psm),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+	SHELL_CMD(dtls, NULL, "DM DTLS handshake statistics", cmd_dtls),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+	SHELL_CMD(creds, NULL, "TLS credential cache statistics", cmd_creds),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_TRACE)
+	SHELL_CMD(trace, NULL, "State transition trace", cmd_trace),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_STACK_MONITOR)
+	SHELL_CMD(stack, NULL, "Deepest stack use of the module threads", cmd_stack),
+	SHELL_CMD_ARG(stack_exercise, NULL,
+		      "Run the Memfault post and an optional script, then show stack use\n"
+		      "Usage: stack_exercise [script path]",
+		      cmd_stack_exercise, 1, 1),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	SHELL_CMD(memfault, NULL, "Memfault upload statistics", cmd_memfault),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+	SHELL_CMD(chunks, NULL, "Memfault chunk pipeline statistics", cmd_chunks),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE)
+	SHELL_CMD(mflt_store, NULL, "Stored Memfault data", cmd_mflt_store),
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+	SHELL_CMD(recovery, NULL, "Connection recovery steps", cmd_recovery),
+#endif
+	SHELL_SUBCMD_SET_END);
+SHELL_CMD_REGISTER(gw_dm, &gw_dm_cmds, "Gateway device manager", NULL);
@@ -28,6 +28,8 @@ LOG_MODULE_REGISTER(lcz_ble_gw_dm_smp_rules, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 #include <attr.h>
 #endif
 
+#include "lcz_ble_gw_dm_timer.h"
+
 /**************************************************************************************************/
 /* Local Constant, Macro and Type Definitions                                                     */
 /**************************************************************************************************/
@@ -41,7 +43,7 @@ static void bt_disconnected(struct bt_conn *conn, uint8_t reason);
 #if defined(CONFIG_LCZ_PKI_AUTH_SMP_PERIPHERAL)
 static void auth_complete_cb(bool status);
 static void reset_auth_timer(void);
-static void smp_auth_timeout_work_handler(struct k_work *work);
+static void smp_auth_timeout_handler(struct lcz_ble_gw_dm_timer *timer);
 #endif
 static bool gw_dm_smp_test(uint16_t group_id, uint16_t command_id);
 static int lcz_ble_gw_dm_smp_rules_init(const struct device *device);
@@ -51,7 +53,7 @@ static int lcz_ble_gw_dm_smp_rules_init(const struct device *device);
 /**************************************************************************************************/
 #if defined(CONFIG_LCZ_PKI_AUTH_SMP_PERIPHERAL)
 struct lcz_pki_auth_smp_periph_auth_callback_agent auth_cb = { .cb = auth_complete_cb };
-static K_WORK_DELAYABLE_DEFINE(smp_auth_timeout_work, smp_auth_timeout_work_handler);
+static LCZ_BLE_GW_DM_TIMER_DEFINE(smp_auth_timer, smp_auth_timeout_handler);
 #endif
 #if defined(CONFIG_BT_PERIPHERAL)
 static struct bt_conn_cb conn_callbacks = { .disconnected = bt_disconnected };
@@ -82,17 +84,16 @@ static void auth_complete_cb(bool status)
 
 static void reset_auth_timer(void)
 {
-	k_timeout_t auth_timeout = K_SECONDS(CONFIG_LCZ_GW_DM_SMP_AUTH_TIMEOUT);
+	uint32_t auth_timeout = CONFIG_LCZ_GW_DM_SMP_AUTH_TIMEOUT;
 
 #if defined(ATTR_ID_smp_auth_timeout)
-	auth_timeout = K_SECONDS(
-		attr_get_uint32(ATTR_ID_smp_auth_timeout, CONFIG_LCZ_GW_DM_SMP_AUTH_TIMEOUT));
+	auth_timeout = attr_get_uint32(ATTR_ID_smp_auth_timeout, CONFIG_LCZ_GW_DM_SMP_AUTH_TIMEOUT);
 #endif
 
-	k_work_reschedule(&smp_auth_timeout_work, auth_timeout);
+	lcz_ble_gw_dm_timer_start(&smp_auth_timer, auth_timeout * MSEC_PER_SEC, 0);
 }
 
-static void smp_auth_timeout_work_handler(struct k_work *work)
+static void smp_auth_timeout_handler(struct lcz_ble_gw_dm_timer *timer)
 {
     authorized = false;
 }
@@ -116,7 +117,7 @@ static bool gw_dm_smp_test(uint16_t group_id, uint16_t command_id)
 	}
 
 	/* If we were recently authorized, allow anything */
-	if (authorized && k_work_delayable_is_pending(&smp_auth_timeout_work)) {
+	if (authorized && lcz_ble_gw_dm_timer_is_pending(&smp_auth_timer)) {
 		reset_auth_timer();
 		return true;
 	}
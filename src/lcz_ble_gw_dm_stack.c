@@ -0,0 +1,253 @@
+/**
+ * @file lcz_ble_gw_dm_stack.c
+ * @brief Stack headroom monitor for the threads used by the gateway device manager
+ *
+ * Stacks are painted at thread creation (INIT_STACKS), so each sample gives the deepest use
+ * since boot. The system work queue is included because the timer service and the file rules
+ * script runner use it, and the chunk reader thread when the Memfault chunk pipeline is used.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lcz_ble_gw_dm_stack, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/init.h>
+#include <lcz_memfault.h>
+#if defined(CONFIG_LCZ_SHELL_SCRIPT_RUNNER)
+#include <lcz_shell_script_runner.h>
+#endif
+
+#include "lcz_ble_gw_dm_stack.h"
+#include "lcz_ble_gw_dm_timer.h"
+#include "memfault_task.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+enum stack_thread {
+	STACK_GW_DM = 0,
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	STACK_MEMFAULT,
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+	STACK_MEMFAULT_CHUNK,
+#endif
+	STACK_SYSWORKQ,
+	STACK_THREAD__NUM
+};
+
+struct stack_monitor {
+	const char *name;
+	struct k_thread *thread;
+	uint32_t max_used;
+	uint32_t samples;
+};
+
+#if defined(CONFIG_LCZ_SHELL_SCRIPT_RUNNER)
+struct script_work {
+	struct k_work work;
+	const char *path;
+	int result;
+	struct k_sem done;
+};
+#endif
+
+/**************************************************************************************************/
+/* Global Data Definitions                                                                        */
+/**************************************************************************************************/
+extern const k_tid_t ble_gw_dm;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+extern const k_tid_t memfault;
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+extern const k_tid_t memfault_chunk;
+#endif
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static int lcz_ble_gw_dm_stack_init(const struct device *device);
+static void sample_timer_handler(struct lcz_ble_gw_dm_timer *timer);
+static void set_metric(int index, uint32_t used);
+#if defined(CONFIG_LCZ_SHELL_SCRIPT_RUNNER)
+static void script_work_handler(struct k_work *work);
+#endif
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static struct stack_monitor monitors[STACK_THREAD__NUM] = {
+	[STACK_GW_DM] = { .name = "ble_gw_dm" },
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	[STACK_MEMFAULT] = { .name = "memfault" },
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+	[STACK_MEMFAULT_CHUNK] = { .name = "memfault_chunk" },
+#endif
+	[STACK_SYSWORKQ] = { .name = "sysworkq" },
+};
+static struct k_spinlock lock;
+static LCZ_BLE_GW_DM_TIMER_DEFINE(stack_sample_timer, sample_timer_handler);
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void sample_timer_handler(struct lcz_ble_gw_dm_timer *timer)
+{
+	lcz_ble_gw_dm_stack_sample();
+}
+
+static void set_metric(int index, uint32_t used)
+{
+	switch (index) {
+	case STACK_GW_DM:
+		MFLT_METRICS_SET_UNSIGNED(gw_dm_stack_max_used, used);
+		break;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	case STACK_MEMFAULT:
+		MFLT_METRICS_SET_UNSIGNED(memfault_stack_max_used, used);
+		break;
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+	case STACK_MEMFAULT_CHUNK:
+		MFLT_METRICS_SET_UNSIGNED(memfault_chunk_stack_max_used, used);
+		break;
+#endif
+	default:
+		MFLT_METRICS_SET_UNSIGNED(sysworkq_stack_max_used, used);
+		break;
+	}
+}
+
+#if defined(CONFIG_LCZ_SHELL_SCRIPT_RUNNER)
+static void script_work_handler(struct k_work *work)
+{
+	struct script_work *sw = CONTAINER_OF(work, struct script_work, work);
+
+	sw->result = lcz_zsh_run_script(sw->path, NULL);
+	k_sem_give(&sw->done);
+}
+#endif
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_ble_gw_dm_stack_count(void)
+{
+	return STACK_THREAD__NUM;
+}
+
+int lcz_ble_gw_dm_stack_stats_get(int index, struct lcz_ble_gw_dm_stack_stats *stats)
+{
+	k_spinlock_key_t key;
+
+	if (index < 0 || index >= STACK_THREAD__NUM) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&lock);
+	stats->name = monitors[index].name;
+	stats->size = (monitors[index].thread != NULL) ?
+			      (uint32_t)monitors[index].thread->stack_info.size :
+			      0;
+	stats->max_used = monitors[index].max_used;
+	stats->samples = monitors[index].samples;
+	k_spin_unlock(&lock, key);
+	return 0;
+}
+
+void lcz_ble_gw_dm_stack_sample(void)
+{
+	struct stack_monitor *m;
+	k_spinlock_key_t key;
+	size_t unused;
+	uint32_t used;
+	bool deeper;
+	int i;
+
+	for (i = 0; i < STACK_THREAD__NUM; i++) {
+		m = &monitors[i];
+		if (m->thread == NULL || k_thread_stack_space_get(m->thread, &unused) != 0) {
+			continue;
+		}
+		used = m->thread->stack_info.size - unused;
+
+		key = k_spin_lock(&lock);
+		deeper = used > m->max_used;
+		m->max_used = MAX(m->max_used, used);
+		m->samples++;
+		k_spin_unlock(&lock, key);
+
+		if (deeper) {
+			LOG_DBG("%s stack %u of %u bytes", m->name, used,
+				(uint32_t)m->thread->stack_info.size);
+		}
+		/* Heartbeats clear the metrics, so report on every sample */
+		set_metric(i, used);
+	}
+}
+
+int lcz_ble_gw_dm_stack_exercise(const char *script)
+{
+	int ret = 0;
+#if defined(CONFIG_LCZ_SHELL_SCRIPT_RUNNER)
+	struct script_work sw;
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	/* The memfault thread only runs once per report period */
+	ret = lcz_ble_gw_dm_memfault_post_data_sync();
+	if (ret < 0) {
+		LOG_WRN("Memfault post did not complete: %d", ret);
+	}
+#endif
+
+	if (script != NULL) {
+#if defined(CONFIG_LCZ_SHELL_SCRIPT_RUNNER)
+		/* Same path as a script executed through the file rules */
+		k_work_init(&sw.work, script_work_handler);
+		k_sem_init(&sw.done, 0, 1);
+		sw.path = script;
+		k_work_submit(&sw.work);
+		k_sem_take(&sw.done, K_FOREVER);
+		if (sw.result < 0) {
+			ret = sw.result;
+		}
+#else
+		ret = -ENOTSUP;
+#endif
+	}
+
+	lcz_ble_gw_dm_stack_sample();
+	return ret;
+}
+
+/**************************************************************************************************/
+/* SYS INIT                                                                                       */
+/**************************************************************************************************/
+SYS_INIT(lcz_ble_gw_dm_stack_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+static int lcz_ble_gw_dm_stack_init(const struct device *device)
+{
+	ARG_UNUSED(device);
+
+	monitors[STACK_GW_DM].thread = ble_gw_dm;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	monitors[STACK_MEMFAULT].thread = memfault;
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+	monitors[STACK_MEMFAULT_CHUNK].thread = memfault_chunk;
+#endif
+	monitors[STACK_SYSWORKQ].thread = &k_sys_work_q.thread;
+
+	lcz_ble_gw_dm_timer_start(&stack_sample_timer,
+				  CONFIG_LCZ_BLE_GW_DM_STACK_MONITOR_PERIOD * MSEC_PER_SEC,
+				  CONFIG_LCZ_BLE_GW_DM_STACK_MONITOR_PERIOD * MSEC_PER_SEC);
+	return 0;
+}
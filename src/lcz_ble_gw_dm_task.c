@@ -14,7 +14,7 @@ LOG_MODULE_REGISTER(lcz_ble_gw_dm, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 /**************************************************************************************************/
 #include <zephyr/zephyr.h>
 #include <zephyr/random/rand32.h>
-#include <zephyr/posix/time.h>
+#include <zephyr/sys/math_extras.h>
 #include <date_time.h>
 #if defined(CONFIG_MODEM_HL7800)
 #include <zephyr/drivers/modem/hl7800.h>
@@ -32,10 +32,22 @@ LOG_MODULE_REGISTER(lcz_ble_gw_dm, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 #include <lcz_network_monitor.h>
 
 #include "lcz_ble_gw_dm_task.h"
+#include "lcz_ble_gw_dm_backoff.h"
+#include "lcz_ble_gw_dm_timer.h"
+#include "lcz_ble_gw_dm_time.h"
+#include "lcz_ble_gw_dm_trace.h"
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+#include "lcz_ble_gw_dm_dtls.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+#include "lcz_ble_gw_dm_creds.h"
+#endif
 #include "lwm2m_telemetry.h"
 #include "memfault_task.h"
 #include "ble_gw_dm_ble.h"
+#if defined(CONFIG_LCZ_BLE_GW_DM_LED_CONTROL)
 #include "led_config.h"
+#endif
 #include "lcz_pki_auth.h"
 
 /**************************************************************************************************/
@@ -46,7 +58,8 @@ LOG_MODULE_REGISTER(lcz_ble_gw_dm, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 #define DM_CONNECTION_DELAY_MIN_RAND 30
 #define DM_CNX_RETRIES_FALLBACK 3
 #define DM_CNX_BACKOFF_RETRIES_FALLBACK 5
-#define RAND_RANGE(min, max) ((sys_rand32_get() % (max - min + 1)) + min)
+#define DM_CNX_BACKOFF_POLICY_FALLBACK LCZ_BLE_GW_DM_BACKOFF_DECORRELATED_JITTER
+#define DM_CNX_BACKOFF_MAX_FALLBACK 3600
 
 #define CONNECTION_WATCHDOG_REBOOT_DELAY_MS 1000
 #define CONNECTION_WATCHDOG_TIMEOUT_MULTIPLIER 2
@@ -54,11 +67,84 @@ LOG_MODULE_REGISTER(lcz_ble_gw_dm, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 #define CONNECTION_WATCHDOG_REBOOT_TIMER_TIMEOUT_MINUTES 60
 #define NETWORK_SEARCH_TIMER_PERIOD_SECONDS 3
 
+/* Upper bound on back-to-back state transitions processed for a single event. If the limit is
+ * reached the FSM is kicked again so the messages already queued are serviced first.
+ */
+#define FSM_MAX_STEPS_PER_RUN 16
+#define FSM_RETRY_DELAY_SECONDS 1
+
 #if defined(CONFIG_LCZ_MODEM_HL7800)
 #define LTE_RSRP_BAD_THRESHOLD -115
 #define LTE_SINR_BAD_THRESHOLD -3
 #endif
 
+/* Attributes handled by attr_broadcast_msg_handler and the handler of each one. The handler
+ * returns true if the FSM configuration needs to be refreshed. The broadcast filter bitmap and
+ * the attr_changed switch are generated from this list at build time.
+ */
+#if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES)
+#define GW_DM_ATTR_LIST_LWM2M(X, arg) X(ATTR_ID_lwm2m_endpoint, attr_config_changed, arg)
+#else
+#define GW_DM_ATTR_LIST_LWM2M(X, arg)
+#endif
+#if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES) && defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+#define GW_DM_ATTR_LIST_TELEM(X, arg)                                                              \
+	X(ATTR_ID_lwm2m_telem_endpoint, attr_config_changed, arg)                                  \
+	X(ATTR_ID_lwm2m_telem_enable, attr_config_changed, arg)
+#else
+#define GW_DM_ATTR_LIST_TELEM(X, arg)
+#endif
+#if defined(CONFIG_LCZ_MODEM_HL7800)
+#define GW_DM_ATTR_LIST_HL7800(X, arg)                                                             \
+	X(ATTR_ID_lte_rsrp, attr_rsrp_changed, arg) X(ATTR_ID_lte_sinr, attr_sinr_changed, arg)
+#else
+#define GW_DM_ATTR_LIST_HL7800(X, arg)
+#endif
+#if defined(CONFIG_LCZ_MODEM_HL7800) && defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+#define GW_DM_ATTR_LIST_DRAIN(X, arg) X(ATTR_ID_lte_rat, attr_rat_changed, arg)
+#else
+#define GW_DM_ATTR_LIST_DRAIN(X, arg)
+#endif
+#define GW_DM_ATTR_CHANGED_LIST(X, arg)                                                            \
+	X(ATTR_ID_dm_cnx_delay, attr_delay_changed, arg)                                           \
+	X(ATTR_ID_dm_cnx_delay_max, attr_config_changed, arg)                                      \
+	X(ATTR_ID_dm_cnx_retries, attr_config_changed, arg)                                        \
+	X(ATTR_ID_dm_cnx_backoff_retries, attr_config_changed, arg)                                \
+	X(ATTR_ID_dm_cnx_backoff_multi, attr_config_changed, arg)                                  \
+	X(ATTR_ID_dm_cnx_backoff_policy, attr_config_changed, arg)                                 \
+	X(ATTR_ID_dm_cnx_backoff_max, attr_config_changed, arg)                                    \
+	GW_DM_ATTR_LIST_LWM2M(X, arg)                                                              \
+	GW_DM_ATTR_LIST_TELEM(X, arg)                                                              \
+	GW_DM_ATTR_LIST_HL7800(X, arg)                                                             \
+	GW_DM_ATTR_LIST_DRAIN(X, arg)
+
+/* One bit per attribute ID, the literal is required by LISTIFY */
+#define ATTR_FILTER_WORDS 16
+#define ATTR_FILTER_BIT(id, handler, word) | ((((id) / 32) == (word)) ? BIT((id) % 32) : 0)
+#define ATTR_FILTER_WORD(word, _) (0 GW_DM_ATTR_CHANGED_LIST(ATTR_FILTER_BIT, word))
+#define ATTR_CHANGED_CASE(id, handler, _)                                                          \
+	case id:                                                                                   \
+		return handler();
+
+/* Broadcasts where only the most recent copy matters. The payload of a new broadcast is merged
+ * into its slot and at most one message per slot is in the queue.
+ */
+enum coalesce_slot {
+	COALESCE_ATTR_CHANGED = 0,
+#if defined(CONFIG_LCZ_POWER)
+	COALESCE_SENSOR_MEASURED,
+#if defined(CONFIG_BOARD_MG100)
+	COALESCE_BATTERY_STATE,
+#endif
+#endif
+#if defined(CONFIG_LCZ_LWM2M_UTIL_FWK_BROADCAST_ON_CREATE)
+	COALESCE_OBJ_CREATED,
+#endif
+	COALESCE_SLOT__NUM
+};
+#define COALESCE_NONE -1
+#define COALESCE_REJECT -2
+
 enum gw_dm_state {
 	GW_DM_STATE_WAIT_FOR_NETWORK = 0,
 	GW_DM_STATE_GET_NETWORK_TIME,
@@ -74,12 +160,66 @@ enum gw_dm_state {
 	GW_DM_STATE_IDLE,
 	GW_DM_STATE_IDLE_STAY,
 	GW_DM_STATE_DISCONNECT_DM,
+	GW_DM_STATE__NUM
+};
+
+typedef void (*gw_dm_state_handler_t)(void);
+
+/* Entry and exit run once per transition, tick runs each time the FSM is run in that state.
+ * Only tick handlers may change state.
+ */
+struct gw_dm_state_desc {
+	const char *name;
+	gw_dm_state_handler_t entry;
+	gw_dm_state_handler_t tick;
+	gw_dm_state_handler_t exit;
+};
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+/* Telemetry connection sub-state used when it is brought up alongside the DM connection */
+enum telem_session_state {
+	TELEM_SESSION_STOPPED = 0,
+	TELEM_SESSION_CONNECT,
+	TELEM_SESSION_WAIT_FOR_CONNECTION,
+	TELEM_SESSION_CONNECTED,
+	TELEM_SESSION_RETRY_DELAY,
+};
+
+struct telem_session {
+	enum telem_session_state state;
+	int64_t deadline;
+	/* Set while the DM side of the FSM wants the telemetry connection up */
+	bool requested;
+};
+#endif
+
+/* Attribute values used by the FSM. Read once and refreshed only when one of them changes so
+ * the FSM doesn't take the attribute lock on every run.
+ */
+struct gw_dm_config {
+	uint32_t version;
+	uint32_t cnx_delay;
+	uint32_t cnx_delay_max;
+	uint32_t cnx_retries;
+	uint32_t cnx_backoff_retries;
+	float cnx_backoff_multi;
+	uint32_t cnx_backoff_policy;
+	uint32_t cnx_backoff_max;
+#if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES)
+	char *endpoint;
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+	char *telem_endpoint;
+	bool telem_enable;
+#endif
+#endif
 };
 
 typedef struct gw_dm_task_obj {
 	FwkMsgTask_t msgTask;
+	struct gw_dm_config cfg;
 	enum gw_dm_state state;
-	uint32_t timer;
+	int64_t state_entered;
+	int64_t deadline;
 	bool network_ready;
 	uint32_t dm_connection_delay_seconds;
 	uint32_t dm_connection_timeout_seconds;
@@ -88,12 +228,83 @@ typedef struct gw_dm_task_obj {
 #if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
 	bool telem_enabled;
 	bool lwm2m_telem_connected;
+	bool lwm2m_telem_connection_err;
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+	struct telem_session telem;
 #endif
 	uint32_t time;
-	int32_t time_offset;
 	uint16_t cnx_tries;
+	/* What ran the FSM and the last DM client event, for the transition trace */
+	uint8_t cause;
+	uint8_t lwm2m_event;
+	struct lcz_ble_gw_dm_backoff backoff;
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+	struct lcz_ble_gw_dm_state_stats state_stats[GW_DM_STATE__NUM];
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	/* The connection sequence reached the upload stage */
+	bool memfault_upload_wanted;
+	bool memfault_uploading;
+#endif
 } gw_dm_task_obj_t;
 
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+struct psm {
+	struct k_spinlock lock;
+	/* Uptime when the radio turned on, 0 while it is off */
+	int64_t radio_on_start;
+	uint64_t radio_on_ms;
+	uint32_t wakes;
+	uint32_t aligned_updates;
+	/* Uptime of the last registration or update and the lifetime (s) it was done with */
+	int64_t last_update;
+	uint32_t lifetime;
+	/* Set when the modem wakes up, consumed by the task */
+	atomic_t wake_pending;
+};
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+struct recovery {
+	/* enum lcz_ble_gw_dm_recovery_step */
+	atomic_t step;
+	/* Set by the timers when the task needs to run the current step */
+	atomic_t pending;
+	int64_t start;
+	uint32_t last_recovery_ms;
+	uint32_t attempts[LCZ_BLE_GW_DM_RECOVERY_STEP__NUM];
+	uint32_t recovered[LCZ_BLE_GW_DM_RECOVERY_STEP__NUM];
+};
+#endif
+
+/* Uptimes (ms) of the start of each measured interval, 0 when not measuring */
+struct cnx_timing {
+	int64_t network_up;
+	int64_t connect_start;
+	int64_t update_start;
+	int64_t session_start;
+};
+
+/* Written by the broadcaster (filter) and consumed by the task */
+struct gw_dm_queue {
+	atomic_t pending;
+	/* Pending slots whose message didn't fit in the queue, delivered by the next FSM kick */
+	atomic_t undelivered;
+	atomic_t attr_ids[ATOMIC_BITMAP_SIZE(ATTR_FILTER_WORDS * 32)];
+#if defined(CONFIG_LCZ_POWER)
+	atomic_t pwr_src_mv;
+#if defined(CONFIG_BOARD_MG100)
+	atomic_t battery_state;
+#endif
+#endif
+	atomic_t accepted;
+	atomic_t coalesced;
+	atomic_t filtered;
+	atomic_t dropped;
+	atomic_t high_water;
+};
+
 #if defined(CONFIG_LCZ_POWER)
 #define PWR_SRC_VOLTAGE_NOINIT -1
 #endif
@@ -103,16 +314,85 @@ typedef struct gw_dm_task_obj {
 /**************************************************************************************************/
 static void nm_event_callback(enum lcz_nm_event event);
 static FwkMsgHandler_t *gw_dm_task_msg_dispatcher(FwkMsgCode_t MsgCode);
-static DispatchResult_t gateway_fsm_tick_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
-static bool attribute_changed_filter(const FwkMsg_t *pMsg);
+static FwkMsgHandler_t *gw_dm_task_msg_handler(FwkMsgCode_t MsgCode);
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+static int dispatch_index(FwkMsgCode_t MsgCode);
+static void dispatch_enqueued(FwkMsgCode_t MsgCode);
+static void dispatch_timing_add(struct lcz_ble_gw_dm_dispatch_timing *timing, uint32_t us,
+				bool first);
+static DispatchResult_t profiled_msg_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
+#endif
+static DispatchResult_t gateway_fsm_event_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
+static bool broadcast_filter(const FwkMsg_t *pMsg);
+static int coalesce_prepare(const FwkMsg_t *pMsg);
+static void coalesce_deliver_undelivered(void);
+static void queue_high_water_update(uint32_t used);
+static bool attr_changed(attr_id_t id);
+static void config_refresh(void);
 static void gw_dm_fsm(void);
+static void gw_dm_fsm_run(void);
+static void gw_dm_fsm_kick(enum lcz_ble_gw_dm_trace_cause cause);
+static void fsm_kick_send(void);
+static bool send_to_self(FwkMsgCode_t code);
+static void arm_deadline(uint32_t seconds);
+static void clear_deadline(void);
+static void rearm_deadline_timer(void);
 static bool timer_expired(void);
 static void set_state(enum gw_dm_state next_state);
-static char *state_to_string(enum gw_dm_state state);
+static void record_state_exit(enum gw_dm_state state);
+static void record_state_entry(enum gw_dm_state state);
+static void wait_for_network_tick(void);
+static void get_network_time_tick(void);
+static void post_memfault_data_tick(void);
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+static void memfault_upload_start(void);
+static void memfault_posted_callback(int result);
+static void memfault_posted_process(void);
+static DispatchResult_t memfault_posted_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
+#endif
+static void wait_before_dm_connection_entry(void);
+static void wait_before_dm_connection_tick(void);
+static int dm_load_certs(struct lwm2m_ctx *client_ctx);
+static void connect_to_dm_tick(void);
+static void wait_for_connection_entry(void);
+static void wait_for_connection_tick(void);
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+static bool telem_enable_get(void);
+static int telem_connect(void);
+static void connect_telem_tick(void);
+static void wait_for_telem_connection_tick(void);
+static void disconnect_telem_tick(void);
+#endif
+static void idle_tick(void);
+static void disconnect_dm_tick(void);
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+static void telem_session_fsm(void);
+#endif
 static void lwm2m_client_connected_event(struct lwm2m_ctx *client, int lwm2m_client_index,
 					 bool connected, enum lwm2m_rd_client_event client_event);
-static void connection_watchdog_timer_callback(struct k_timer *timer_id);
+static void connection_watchdog_timer_callback(struct lcz_ble_gw_dm_timer *timer);
+static void connection_watchdog_reboot_timer_callback(struct k_timer *timer_id);
+static void network_search_timer_callback(struct lcz_ble_gw_dm_timer *timer);
+static void fsm_deadline_timer_callback(struct lcz_ble_gw_dm_timer *timer);
+static void fsm_kick_retry_timer_callback(struct lcz_ble_gw_dm_timer *timer);
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+static void recovery_escalate(void);
+static void recovery_run_pending(void);
+static void recovery_complete(void);
+static void recovery_timer_callback(struct lcz_ble_gw_dm_timer *timer);
+#endif
 static void pet_connection_watchdog(bool in_connection, int srv_obj_inst);
+static void cnx_timing_lwm2m_event(enum lwm2m_rd_client_event client_event, bool was_connected,
+				   bool connected);
+static void reg_update_request(void);
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+static void psm_radio_set(bool on);
+static void psm_lwm2m_event(enum lwm2m_rd_client_event client_event, int srv_obj_inst);
+static void psm_align_update(void);
+#if defined(CONFIG_MODEM_HL7800)
+static void modem_event_callback(enum mdm_hl7800_event event, void *event_data);
+#endif
+#endif
 static void *current_time_read_cb(uint16_t obj_inst_id, uint16_t res_id, uint16_t res_inst_id,
 				  size_t *data_len);
 static void *current_time_pre_write_cb(uint16_t obj_inst_id, uint16_t res_id, uint16_t res_inst_id,
@@ -121,7 +401,6 @@ static int current_time_post_write_cb(uint16_t obj_inst_id, uint16_t res_id, uin
 				      uint8_t *data, uint16_t data_len, bool last_block,
 				      size_t total_size);
 static void date_time_event_handler(const struct date_time_evt *evt);
-static void disconnect_work_cb(struct k_work *work);
 static int factory_default_callback(uint16_t obj_inst_id, uint8_t *args, uint16_t args_len);
 static void set_network_ready(bool ready);
 #if defined(CONFIG_LCZ_POWER)
@@ -139,12 +418,128 @@ static struct lcz_nm_event_agent event_agent;
 static gw_dm_task_obj_t gwto;
 K_MSGQ_DEFINE(gw_dm_task_queue, FWK_QUEUE_ENTRY_SIZE, GW_DM_TASK_QUEUE_DEPTH, FWK_QUEUE_ALIGNMENT);
 static struct lcz_lwm2m_client_event_callback_agent lwm2m_event_agent;
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+static struct psm psm;
+#if defined(CONFIG_MODEM_HL7800)
+static struct mdm_hl7800_callback_agent modem_event_agent;
+#endif
+#endif
 static DispatchResult_t attr_broadcast_msg_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
 static void random_connect_handler(void);
-static struct k_timer connection_watchdog_timer;
+static LCZ_BLE_GW_DM_TIMER_DEFINE(connection_watchdog_timer, connection_watchdog_timer_callback);
+/* Last resort, this stays a kernel timer so that it doesn't depend on the system work queue */
 static struct k_timer connection_watchdog_reboot_timer;
-static struct k_timer network_search_timer;
-static K_WORK_DEFINE(disconnect_work, disconnect_work_cb);
+static LCZ_BLE_GW_DM_TIMER_DEFINE(network_search_timer, network_search_timer_callback);
+static LCZ_BLE_GW_DM_TIMER_DEFINE(fsm_deadline_timer, fsm_deadline_timer_callback);
+static LCZ_BLE_GW_DM_TIMER_DEFINE(fsm_kick_retry_timer, fsm_kick_retry_timer_callback);
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+static LCZ_BLE_GW_DM_TIMER_DEFINE(recovery_timer, recovery_timer_callback);
+static struct recovery recovery;
+
+/* Time in seconds to wait for a connection after each step, 0 skips the step */
+static const uint32_t RECOVERY_TIMEOUTS[LCZ_BLE_GW_DM_RECOVERY_STEP__NUM] = {
+	[LCZ_BLE_GW_DM_RECOVERY_REREGISTER] = CONFIG_LCZ_BLE_GW_DM_RECOVERY_REREGISTER_TIMEOUT,
+	[LCZ_BLE_GW_DM_RECOVERY_RECREATE_CONTEXT] = CONFIG_LCZ_BLE_GW_DM_RECOVERY_RECREATE_TIMEOUT,
+};
+
+static const char *const RECOVERY_STEP_NAMES[LCZ_BLE_GW_DM_RECOVERY_STEP__NUM] = {
+	[LCZ_BLE_GW_DM_RECOVERY_NONE] = "None",
+	[LCZ_BLE_GW_DM_RECOVERY_REREGISTER] = "Re-register",
+	[LCZ_BLE_GW_DM_RECOVERY_RECREATE_CONTEXT] = "Recreate LwM2M context",
+	[LCZ_BLE_GW_DM_RECOVERY_REBOOT] = "Reboot",
+};
+#endif
+static atomic_t fsm_kick_pending;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+static atomic_t memfault_result;
+/* Set when an upload completes, cleared by the task when it handles the result */
+static atomic_t memfault_done;
+#endif
+static struct cnx_timing cnx_timing;
+/* Bit per enum lcz_ble_gw_dm_trace_cause since the last FSM run */
+static atomic_t kick_causes;
+static struct gw_dm_queue queue;
+
+/* Each coalesced broadcast, an FSM kick and a Memfault completion can be queued at the same time */
+BUILD_ASSERT(GW_DM_TASK_QUEUE_DEPTH >=
+		     (COALESCE_SLOT__NUM + 1 + IS_ENABLED(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)),
+	     "Task queue is too small");
+
+/* Message of each slot, used to deliver a slot whose message was dropped */
+static const FwkMsgCode_t COALESCE_MSG_CODE[COALESCE_SLOT__NUM] = {
+	[COALESCE_ATTR_CHANGED] = FMC_ATTR_CHANGED,
+#if defined(CONFIG_LCZ_POWER)
+	[COALESCE_SENSOR_MEASURED] = FMC_LCZ_SENSOR_MEASURED,
+#if defined(CONFIG_BOARD_MG100)
+	[COALESCE_BATTERY_STATE] = FMC_LCZ_POWER_BATTERY_STATE,
+#endif
+#endif
+#if defined(CONFIG_LCZ_LWM2M_UTIL_FWK_BROADCAST_ON_CREATE)
+	[COALESCE_OBJ_CREATED] = FMC_LWM2M_OBJ_CREATED,
+#endif
+};
+
+BUILD_ASSERT(ATTR_TABLE_SIZE <= (ATTR_FILTER_WORDS * 32), "Attribute filter is too small");
+static const uint32_t ATTR_CHANGED_FILTER[ATTR_FILTER_WORDS] = {
+	LISTIFY(ATTR_FILTER_WORDS, ATTR_FILTER_WORD, (, ))
+};
+
+/* clang-format off */
+static const struct gw_dm_state_desc STATE_TABLE[GW_DM_STATE__NUM] = {
+	[GW_DM_STATE_WAIT_FOR_NETWORK] = {
+		"Wait for network", NULL, wait_for_network_tick, NULL },
+	[GW_DM_STATE_GET_NETWORK_TIME] = {
+		"Get network time", NULL, get_network_time_tick, NULL },
+	[GW_DM_STATE_POST_MEMFAULT_DATA] = {
+		"Post Memfault data", NULL, post_memfault_data_tick, NULL },
+	[GW_DM_STATE_WAIT_BEFORE_DM_CONNECTION] = {
+		"Delay before DM connection", wait_before_dm_connection_entry,
+		wait_before_dm_connection_tick, NULL },
+	[GW_DM_STATE_CONNECT_TO_DM] = {
+		"Connect to DM", NULL, connect_to_dm_tick, NULL },
+	[GW_DM_STATE_WAIT_FOR_CONNECTION] = {
+		"Wait for connection", wait_for_connection_entry, wait_for_connection_tick, NULL },
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+	[GW_DM_STATE_CONNECT_TELEM] = {
+		"Connect to telemetry server", NULL, connect_telem_tick, NULL },
+	[GW_DM_STATE_WAIT_FOR_TELEM_CONNECTION] = {
+		"Wait for telemetry connection", wait_for_connection_entry,
+		wait_for_telem_connection_tick, NULL },
+	[GW_DM_STATE_DISCONNECT_TELEM] = {
+		"Disconnect telemetry", NULL, disconnect_telem_tick, NULL },
+#endif
+	[GW_DM_STATE_IDLE] = {
+		"Idle", NULL, idle_tick, NULL },
+	[GW_DM_STATE_IDLE_STAY] = {
+		/* wait here until reboot watchdog fires */
+		"Idle Stay", NULL, NULL, NULL },
+	[GW_DM_STATE_DISCONNECT_DM] = {
+		"Disconnect DM", NULL, disconnect_dm_tick, NULL },
+};
+/* clang-format on */
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+static const uint32_t STATE_HIST_EDGES_S[] = LCZ_BLE_GW_DM_STATE_HIST_EDGES_S;
+BUILD_ASSERT(ARRAY_SIZE(STATE_HIST_EDGES_S) + 1 == LCZ_BLE_GW_DM_STATE_HIST_BUCKETS,
+	     "State histogram edges don't match the bucket count");
+static struct k_spinlock state_stats_lock;
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+static const char *const DISPATCH_MSG_NAMES[LCZ_BLE_GW_DM_DISPATCH_MSG__NUM] = {
+	[LCZ_BLE_GW_DM_DISPATCH_FSM_KICK] = "FSM kick",
+	[LCZ_BLE_GW_DM_DISPATCH_ATTR_CHANGED] = "Attribute changed",
+	[LCZ_BLE_GW_DM_DISPATCH_SENSOR_MEASURED] = "Sensor measured",
+	[LCZ_BLE_GW_DM_DISPATCH_BATTERY_STATE] = "Battery state",
+	[LCZ_BLE_GW_DM_DISPATCH_OBJ_CREATED] = "LwM2M object created",
+	[LCZ_BLE_GW_DM_DISPATCH_MEMFAULT_POSTED] = "Memfault posted",
+};
+static struct k_spinlock dispatch_lock;
+static struct lcz_ble_gw_dm_dispatch_stats dispatch_stats[LCZ_BLE_GW_DM_DISPATCH_MSG__NUM];
+/* Uptime (ticks) each message was queued. There is at most one of each in the queue. */
+static int64_t dispatch_queued[LCZ_BLE_GW_DM_DISPATCH_MSG__NUM];
+static uint32_t dispatch_exec_max_us;
+static uint32_t dispatch_wait_max_us;
+#endif
 #if defined(CONFIG_LCZ_POWER)
 static int pwr_src_mv = PWR_SRC_VOLTAGE_NOINIT;
 #endif
@@ -154,10 +549,15 @@ static int pwr_src_mv = PWR_SRC_VOLTAGE_NOINIT;
 /**************************************************************************************************/
 static void set_network_ready(bool ready)
 {
+	if (ready && !gwto.network_ready) {
+		cnx_timing.network_up = k_uptime_get();
+	} else if (!ready) {
+		cnx_timing.network_up = 0;
+	}
 	gwto.network_ready = ready;
 
 	if (gwto.network_ready) {
-		k_timer_stop(&network_search_timer);
+		lcz_ble_gw_dm_timer_stop(&network_search_timer);
 #if defined(CONFIG_LCZ_BLE_GW_DM_NETWORK_STATUS_LED)
 		(void)lcz_led_turn_on(NETWORK_LED);
 #endif
@@ -168,98 +568,221 @@ static void set_network_ready(bool ready)
 #if defined(CONFIG_LCZ_BLE_GW_DM_DEVICE_MANAGEMENT_STATUS_LED)
 		(void)lcz_led_turn_off(DM_LED);
 #endif
-		k_timer_start(&network_search_timer, K_SECONDS(NETWORK_SEARCH_TIMER_PERIOD_SECONDS),
-			      K_SECONDS(NETWORK_SEARCH_TIMER_PERIOD_SECONDS));
+		lcz_ble_gw_dm_timer_start(&network_search_timer,
+					  NETWORK_SEARCH_TIMER_PERIOD_SECONDS * MSEC_PER_SEC,
+					  NETWORK_SEARCH_TIMER_PERIOD_SECONDS * MSEC_PER_SEC);
 	}
 }
 
-static DispatchResult_t attr_broadcast_msg_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+static bool attr_config_changed(void)
 {
-	int i;
-	attr_changed_msg_t *pb = (attr_changed_msg_t *)pMsg;
+	return true;
+}
+
+static bool attr_delay_changed(void)
+{
+	random_connect_handler();
+	return true;
+}
+
 #if defined(CONFIG_LCZ_MODEM_HL7800)
-	int signal;
+static bool attr_rsrp_changed(void)
+{
+	if (attr_get_signed32(ATTR_ID_lte_rsrp, 0) <= LTE_RSRP_BAD_THRESHOLD) {
+		(void)lcz_lwm2m_client_device_set_err(LWM2M_DEVICE_ERROR_LOW_SIGNAL_STRENGTH);
+	}
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+	lcz_ble_gw_dm_memfault_link_changed();
 #endif
+	return false;
+}
 
-	for (i = 0; i < pb->count; i++) {
-		switch (pb->list[i]) {
-		case ATTR_ID_dm_cnx_delay:
-			random_connect_handler();
-			break;
-#if defined(CONFIG_LCZ_MODEM_HL7800)
-		case ATTR_ID_lte_rsrp:
-			signal = attr_get_signed32(ATTR_ID_lte_rsrp, 0);
-			if (signal <= LTE_RSRP_BAD_THRESHOLD) {
-				(void)lcz_lwm2m_client_device_set_err(
-					LWM2M_DEVICE_ERROR_LOW_SIGNAL_STRENGTH);
-			}
-			break;
-		case ATTR_ID_lte_sinr:
-			signal = attr_get_signed32(ATTR_ID_lte_sinr, 0);
-			if (signal <= LTE_SINR_BAD_THRESHOLD) {
-				(void)lcz_lwm2m_client_device_set_err(
-					LWM2M_DEVICE_ERROR_LOW_SIGNAL_STRENGTH);
-			}
-			break;
+static bool attr_sinr_changed(void)
+{
+	if (attr_get_signed32(ATTR_ID_lte_sinr, 0) <= LTE_SINR_BAD_THRESHOLD) {
+		(void)lcz_lwm2m_client_device_set_err(LWM2M_DEVICE_ERROR_LOW_SIGNAL_STRENGTH);
+	}
+	return false;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+static bool attr_rat_changed(void)
+{
+	lcz_ble_gw_dm_memfault_link_changed();
+	return false;
+}
 #endif
-		default:
-			LOG_WRN("Adjust Gateway management attribute changed filter");
-			break;
+#endif
+
+/* Returns true if the FSM configuration needs to be refreshed */
+static bool attr_changed(attr_id_t id)
+{
+	switch (id) {
+	GW_DM_ATTR_CHANGED_LIST(ATTR_CHANGED_CASE, _)
+	default:
+		LOG_WRN("Adjust Gateway management attribute changed filter");
+		return false;
+	}
+}
+
+/* The message itself is ignored, changes merged since it was queued are in the pending set */
+static DispatchResult_t attr_broadcast_msg_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+{
+	atomic_val_t ids;
+	bool refresh = false;
+	int w;
+	int b;
+
+	atomic_clear_bit(&queue.pending, COALESCE_ATTR_CHANGED);
+
+	for (w = 0; w < ARRAY_SIZE(queue.attr_ids); w++) {
+		ids = atomic_set(&queue.attr_ids[w], 0);
+		for (b = 0; (b < ATOMIC_BITS) && (ids != 0); b++) {
+			if (ids & ATOMIC_MASK(b)) {
+				ids &= ~ATOMIC_MASK(b);
+				refresh |= attr_changed((w * ATOMIC_BITS) + b);
+			}
 		}
 	}
 
+	if (refresh) {
+		config_refresh();
+	}
+
+	gwto.cause = LCZ_BLE_GW_DM_TRACE_CAUSE_ATTR;
+	gw_dm_fsm_run();
+
 	return DISPATCH_OK;
 }
 
-/* Don't accept attribute changed broadcasts that this task doesn't care about.
- * This is done to prevent a queue overflow when this task blocks for long periods.
+static inline bool attribute_is_accepted(attr_id_t id)
+{
+	return (id < (ATTR_FILTER_WORDS * 32)) &&
+	       ((ATTR_CHANGED_FILTER[id / 32] & BIT(id % 32)) != 0);
+}
+
+static void queue_high_water_update(uint32_t used)
+{
+	atomic_val_t high_water;
+
+	do {
+		high_water = atomic_get(&queue.high_water);
+		if (used <= high_water) {
+			return;
+		}
+	} while (!atomic_cas(&queue.high_water, high_water, used));
+
+	MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_queue_high_water, used);
+}
+
+/* Merge the payload of a broadcast into its slot.
+ * Returns the slot, COALESCE_NONE if the message isn't coalesced or
+ * COALESCE_REJECT if it isn't of interest.
  */
-static bool attribute_changed_filter(const FwkMsg_t *pMsg)
+static int coalesce_prepare(const FwkMsg_t *pMsg)
 {
+	const attr_changed_msg_t *pb;
+	bool accepted = false;
+#if defined(CONFIG_LCZ_POWER)
+	const lcz_power_measure_msg_t *pwr_msg;
+#endif
 	int i;
-	int j;
-	attr_changed_msg_t *pb;
-	const FwkMsgCode_t ACCEPTED_CODES[] = {
-		ATTR_ID_dm_cnx_delay,
-#if defined(CONFIG_LCZ_MODEM_HL7800)
-		ATTR_ID_lte_rsrp,
-		ATTR_ID_lte_sinr,
+
+	switch (pMsg->header.msgCode) {
+	case FMC_ATTR_CHANGED:
+		pb = (const attr_changed_msg_t *)pMsg;
+		for (i = 0; i < pb->count; i++) {
+			if (attribute_is_accepted(pb->list[i])) {
+				atomic_set_bit(queue.attr_ids, pb->list[i]);
+				accepted = true;
+			}
+		}
+		return accepted ? COALESCE_ATTR_CHANGED : COALESCE_REJECT;
+#if defined(CONFIG_LCZ_POWER)
+	case FMC_LCZ_SENSOR_MEASURED:
+		pwr_msg = (const lcz_power_measure_msg_t *)pMsg;
+		if (pwr_msg->header.txId != FWK_ID_LCZ_POWER) {
+			return COALESCE_REJECT;
+		}
+		atomic_set(&queue.pwr_src_mv, (atomic_val_t)(pwr_msg->voltage * 1000.0));
+		return COALESCE_SENSOR_MEASURED;
+#if defined(CONFIG_BOARD_MG100)
+	case FMC_LCZ_POWER_BATTERY_STATE:
+		atomic_set(&queue.battery_state,
+			   ((const lcz_power_battery_msg_t *)pMsg)->battery_state);
+		return COALESCE_BATTERY_STATE;
+#endif
+#endif
+#if defined(CONFIG_LCZ_LWM2M_UTIL_FWK_BROADCAST_ON_CREATE)
+	case FMC_LWM2M_OBJ_CREATED:
+		return COALESCE_OBJ_CREATED;
 #endif
-	};
+	default:
+		return COALESCE_NONE;
+	}
+}
+
+/* Only accept broadcasts this task handles and keep a single copy of those where only the latest
+ * value matters. This is done to prevent a queue overflow when this task blocks for long periods.
+ * This runs in the context of the broadcaster.
+ */
+static bool broadcast_filter(const FwkMsg_t *pMsg)
+{
+	int slot;
+
+	if (gw_dm_task_msg_dispatcher(pMsg->header.msgCode) == NULL) {
+		atomic_inc(&queue.filtered);
+		return false;
+	}
 
-	if (pMsg->header.msgCode != FMC_ATTR_CHANGED) {
-		return true;
+	slot = coalesce_prepare(pMsg);
+	if (slot == COALESCE_REJECT) {
+		atomic_inc(&queue.filtered);
+		return false;
 	}
 
-	pb = (attr_changed_msg_t *)pMsg;
-	for (i = 0; i < pb->count; i++) {
-		for (j = 0; j < ARRAY_SIZE(ACCEPTED_CODES); j++) {
-			if (pb->list[i] == ACCEPTED_CODES[j]) {
-				return true;
-			}
+	if (slot != COALESCE_NONE && atomic_test_and_set_bit(&queue.pending, slot)) {
+		atomic_inc(&queue.coalesced);
+		return false;
+	}
+
+	if (k_msgq_num_free_get(&gw_dm_task_queue) == 0) {
+		/* The slot stays pending so later broadcasts merge into it until the kick delivers it.
+		 * The kick is retried if it doesn't fit either.
+		 */
+		if (slot != COALESCE_NONE) {
+			atomic_set_bit(&queue.undelivered, slot);
+			gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_ATTR);
 		}
+		atomic_inc(&queue.dropped);
+		return false;
 	}
 
-	return false;
+	queue_high_water_update(k_msgq_num_used_get(&gw_dm_task_queue) + 1);
+	atomic_inc(&queue.accepted);
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+	dispatch_enqueued(pMsg->header.msgCode);
+#endif
+	return true;
 }
 
 #if defined(CONFIG_LCZ_POWER)
 static DispatchResult_t lcz_sensor_msg_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
 {
 	int ret;
-	lcz_power_measure_msg_t *pwr_msg = (lcz_power_measure_msg_t *)pMsg;
-	if (pwr_msg->header.txId == FWK_ID_LCZ_POWER) {
-		pwr_src_mv = (int)(pwr_msg->voltage * 1000.0);
-		if (pwr_src_mv > PWR_SRC_OFF_THRESHOLD) {
-			ret = lcz_lwm2m_client_set_power_source_voltage(0, &pwr_src_mv);
-			if (ret < 0) {
-				LOG_ERR("Could not set power source voltage [%d]", ret);
-			}
+
+	/* Use the latest measurement, the filter only queues messages from the power module */
+	atomic_clear_bit(&queue.pending, COALESCE_SENSOR_MEASURED);
+	pwr_src_mv = (int)atomic_get(&queue.pwr_src_mv);
+	if (pwr_src_mv > PWR_SRC_OFF_THRESHOLD) {
+		ret = lcz_lwm2m_client_set_power_source_voltage(0, &pwr_src_mv);
+		if (ret < 0) {
+			LOG_ERR("Could not set power source voltage [%d]", ret);
 		}
+	}
 #if defined(CONFIG_BOARD_MG100)
-		(void)process_battery_state(lcz_power_get_battery_state(), pwr_src_mv);
+	(void)process_battery_state(lcz_power_get_battery_state(), pwr_src_mv);
 #endif
-	}
 
 	return DISPATCH_OK;
 }
@@ -320,14 +843,37 @@ int process_battery_state(uint8_t state, int mv)
 
 static DispatchResult_t lcz_battery_msg_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
 {
-	lcz_power_battery_msg_t *msg = (lcz_power_battery_msg_t *)pMsg;
-
-	(void)process_battery_state(msg->battery_state, pwr_src_mv);
+	atomic_clear_bit(&queue.pending, COALESCE_BATTERY_STATE);
+	(void)process_battery_state((uint8_t)atomic_get(&queue.battery_state), pwr_src_mv);
 	return DISPATCH_OK;
 }
 #endif
 #endif
 
+static void config_refresh(void)
+{
+	gwto.cfg.cnx_delay = attr_get_uint32(ATTR_ID_dm_cnx_delay, DM_CONNECTION_DELAY_FALLBACK);
+	gwto.cfg.cnx_delay_max =
+		attr_get_uint32(ATTR_ID_dm_cnx_delay_max, CONNECTION_WATCHDOG_MAX_FALLBACK);
+	gwto.cfg.cnx_retries = attr_get_uint32(ATTR_ID_dm_cnx_retries, DM_CNX_RETRIES_FALLBACK);
+	gwto.cfg.cnx_backoff_retries =
+		attr_get_uint32(ATTR_ID_dm_cnx_backoff_retries, DM_CNX_BACKOFF_RETRIES_FALLBACK);
+	gwto.cfg.cnx_backoff_multi = *(float *)attr_get_quasi_static(ATTR_ID_dm_cnx_backoff_multi);
+	gwto.cfg.cnx_backoff_policy =
+		attr_get_uint32(ATTR_ID_dm_cnx_backoff_policy, DM_CNX_BACKOFF_POLICY_FALLBACK);
+	gwto.cfg.cnx_backoff_max =
+		attr_get_uint32(ATTR_ID_dm_cnx_backoff_max, DM_CNX_BACKOFF_MAX_FALLBACK);
+#if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES)
+	gwto.cfg.endpoint = (char *)attr_get_quasi_static(ATTR_ID_lwm2m_endpoint);
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+	gwto.cfg.telem_endpoint = (char *)attr_get_quasi_static(ATTR_ID_lwm2m_telem_endpoint);
+	gwto.cfg.telem_enable = *(bool *)attr_get_quasi_static(ATTR_ID_lwm2m_telem_enable);
+#endif
+#endif
+	gwto.cfg.version++;
+	LOG_DBG("Configuration version %u", gwto.cfg.version);
+}
+
 static void random_connect_handler(void)
 {
 	uint32_t delay = attr_get_uint32(ATTR_ID_dm_cnx_delay, 1);
@@ -337,71 +883,124 @@ static void random_connect_handler(void)
 	LOG_DBG("min: %u max: %u delay: %u", min, max, delay);
 
 	if (delay == 0) {
-		delay = RAND_RANGE(DM_CONNECTION_DELAY_MIN_RAND, max);
+		delay = lcz_ble_gw_dm_backoff_rand_range(sys_rand32_get,
+							 DM_CONNECTION_DELAY_MIN_RAND, max);
 		(void)attr_set_uint32(ATTR_ID_dm_cnx_delay, delay);
 	}
 }
 
-static char *state_to_string(enum gw_dm_state state)
-{
-	switch (state) {
-	case GW_DM_STATE_WAIT_FOR_NETWORK:
-		return "Wait for network";
-	case GW_DM_STATE_GET_NETWORK_TIME:
-		return "Get network time";
-	case GW_DM_STATE_POST_MEMFAULT_DATA:
-		return "Post Memfault data";
-	case GW_DM_STATE_WAIT_BEFORE_DM_CONNECTION:
-		return "Delay before DM connection";
-	case GW_DM_STATE_CONNECT_TO_DM:
-		return "Connect to DM";
-	case GW_DM_STATE_WAIT_FOR_CONNECTION:
-		return "Wait for connection";
-	case GW_DM_STATE_IDLE:
-		return "Idle";
-	case GW_DM_STATE_IDLE_STAY:
-		return "Idle Stay";
-	case GW_DM_STATE_DISCONNECT_DM:
-		return "Disconnect DM";
-#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
-	case GW_DM_STATE_CONNECT_TELEM:
-		return "Connect to telemetry server";
-	case GW_DM_STATE_WAIT_FOR_TELEM_CONNECTION:
-		return "Wait for telemetry connection";
-	case GW_DM_STATE_DISCONNECT_TELEM:
-		return "Disconnect telemetry";
-#endif
-	default:
-		return "Unknown";
+static void record_state_exit(enum gw_dm_state state)
+{
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+	struct lcz_ble_gw_dm_state_stats *s = &gwto.state_stats[state];
+	uint32_t ms = (uint32_t)(k_uptime_get() - gwto.state_entered);
+	k_spinlock_key_t key;
+	int b;
+
+	for (b = 0; b < ARRAY_SIZE(STATE_HIST_EDGES_S); b++) {
+		if (ms < (STATE_HIST_EDGES_S[b] * MSEC_PER_SEC)) {
+			break;
+		}
 	}
+
+	key = k_spin_lock(&state_stats_lock);
+	s->total_ms += ms;
+	s->max_ms = MAX(s->max_ms, ms);
+	s->hist[b]++;
+	k_spin_unlock(&state_stats_lock, key);
+#endif
+}
+
+static void record_state_entry(enum gw_dm_state state)
+{
+	gwto.state_entered = k_uptime_get();
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+	k_spinlock_key_t key = k_spin_lock(&state_stats_lock);
+
+	gwto.state_stats[state].transitions++;
+	k_spin_unlock(&state_stats_lock, key);
+#endif
 }
 
 static void set_state(enum gw_dm_state next_state)
 {
+	enum gw_dm_state prev_state = gwto.state;
+
 	if (next_state != gwto.state) {
+		if (STATE_TABLE[gwto.state].exit != NULL) {
+			STATE_TABLE[gwto.state].exit();
+		}
+		record_state_exit(prev_state);
+
 		gwto.state = next_state;
-		LOG_INF("%s", state_to_string(next_state));
+		/* Each state arms its own deadline if it needs one */
+		clear_deadline();
+		record_state_entry(next_state);
+#if defined(CONFIG_LCZ_BLE_GW_DM_TRACE)
+		lcz_ble_gw_dm_trace_add(prev_state, next_state, gwto.cause, gwto.lwm2m_event,
+					gwto.cnx_tries);
+#endif
+		LOG_INF("%s", STATE_TABLE[next_state].name);
+
+		if (STATE_TABLE[next_state].entry != NULL) {
+			STATE_TABLE[next_state].entry();
+		}
 	}
 }
 
-static bool timer_expired(void)
+/* Run the deadline timer to the earliest pending deadline. Expiration kicks the FSM. */
+static void rearm_deadline_timer(void)
 {
-	if (gwto.timer > 0) {
-		gwto.timer -= 1;
+	int64_t now = k_uptime_get();
+	int64_t next = (gwto.deadline > now) ? gwto.deadline : 0;
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+	if (gwto.telem.deadline > now && (next == 0 || gwto.telem.deadline < next)) {
+		next = gwto.telem.deadline;
 	}
+#endif
 
-	if (gwto.timer == 0) {
-		return true;
+	if (next == 0) {
+		lcz_ble_gw_dm_timer_stop(&fsm_deadline_timer);
 	} else {
-		return false;
+		lcz_ble_gw_dm_timer_start(&fsm_deadline_timer, (uint32_t)(next - now), 0);
 	}
 }
 
+/* Arm a one-shot deadline for the current state */
+static void arm_deadline(uint32_t seconds)
+{
+	gwto.deadline = k_uptime_get() + ((int64_t)seconds * MSEC_PER_SEC);
+	rearm_deadline_timer();
+}
+
+static void clear_deadline(void)
+{
+	gwto.deadline = 0;
+	rearm_deadline_timer();
+}
+
+static bool timer_expired(void)
+{
+	return (k_uptime_get() >= gwto.deadline);
+}
+
 static void date_time_event_handler(const struct date_time_evt *evt)
 {
+	enum lcz_ble_gw_dm_time_source source = LCZ_BLE_GW_DM_TIME_SOURCE_NONE;
+	int64_t unix_time_ms;
+
 	switch (evt->type) {
+	case DATE_TIME_OBTAINED_MODEM:
+		LOG_DBG("Got time from modem");
+		source = LCZ_BLE_GW_DM_TIME_SOURCE_MODEM;
+		break;
 	case DATE_TIME_OBTAINED_NTP:
 		LOG_DBG("Got time from NTP");
+		source = LCZ_BLE_GW_DM_TIME_SOURCE_NTP;
+		break;
+	case DATE_TIME_OBTAINED_EXT:
+		source = LCZ_BLE_GW_DM_TIME_SOURCE_EXTERNAL;
 		break;
 	case DATE_TIME_NOT_OBTAINED:
 		LOG_DBG("No time from NTP");
@@ -409,232 +1008,576 @@ static void date_time_event_handler(const struct date_time_evt *evt)
 	default:
 		break;
 	}
+
+	if (source != LCZ_BLE_GW_DM_TIME_SOURCE_NONE && date_time_now(&unix_time_ms) == 0) {
+		lcz_ble_gw_dm_time_update(source, unix_time_ms);
+	}
 }
 
 int lcz_lwm2m_dm_load_certs(struct lwm2m_ctx *client_ctx)
 {
+#if defined(CONFIG_LCZ_BLE_GW_DM_CREDENTIAL_CACHE)
+	return lcz_ble_gw_dm_creds_load(LCZ_PKI_AUTH_STORE_DEVICE_MANAGEMENT, client_ctx->tls_tag);
+#else
 	return lcz_pki_auth_tls_credential_load(LCZ_PKI_AUTH_STORE_DEVICE_MANAGEMENT,
 						client_ctx->tls_tag, false);
+#endif
 }
 
-static void gw_dm_fsm(void)
+/* Telemetry loads the same credentials, only the DM connection reuses sessions */
+static int dm_load_certs(struct lwm2m_ctx *client_ctx)
 {
-	int ret;
-	char *ep_name;
-
-#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
-	//LOG_INF("BLE_GW Power Save mode, deactivating lwm2m bootstrap and heartbeat");
-	set_state(GW_DM_STATE_IDLE_STAY);
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+	/* Called before the socket is opened */
+	client_ctx->set_socketoptions = lcz_ble_gw_dm_dtls_set_socketoptions;
 #endif
+	return lcz_lwm2m_dm_load_certs(client_ctx);
+}
 
-	switch (gwto.state) {
-	case GW_DM_STATE_WAIT_FOR_NETWORK:
+static void wait_for_network_tick(void)
+{
+	if (gwto.network_ready) {
+		set_state(GW_DM_STATE_GET_NETWORK_TIME);
+	} else if (timer_expired()) {
+		set_network_ready(lcz_nm_network_ready());
+		LOG_DBG("Re-checking network ready: %s", gwto.network_ready ? "true" : "false");
 		if (gwto.network_ready) {
 			set_state(GW_DM_STATE_GET_NETWORK_TIME);
-		} else if (timer_expired()) {
-			set_network_ready(lcz_nm_network_ready());
-			LOG_DBG("Re-checking network ready: %s",
-				gwto.network_ready ? "true" : "false");
-			gwto.timer = CONFIG_LCZ_BLE_GW_DM_WAIT_FOR_NETWORK_TIMEOUT;
-		}
-		break;
-	case GW_DM_STATE_GET_NETWORK_TIME:
-		if (!gwto.network_ready) {
-			set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
 		} else {
+			arm_deadline(CONFIG_LCZ_BLE_GW_DM_WAIT_FOR_NETWORK_TIMEOUT);
+		}
+	}
+}
+
+static void get_network_time_tick(void)
+{
+	if (!gwto.network_ready) {
+		set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
+	} else {
+		/* Skip the query on reconnects while the clock is still accurate enough */
+		if (lcz_ble_gw_dm_time_query_needed()) {
 			(void)date_time_update_async(date_time_event_handler);
-			set_state(GW_DM_STATE_POST_MEMFAULT_DATA);
 		}
-		break;
-	case GW_DM_STATE_POST_MEMFAULT_DATA:
-		if (!gwto.network_ready) {
-			set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
+		set_state(GW_DM_STATE_POST_MEMFAULT_DATA);
+	}
+}
+
+static void post_memfault_data_tick(void)
+{
+	if (!gwto.network_ready) {
+		set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
+		return;
+	}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	/* The upload runs in the Memfault thread, the connection doesn't wait for it */
+	gwto.memfault_upload_wanted = true;
+#if !defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_UPLOAD_AFTER_REGISTRATION)
+	memfault_upload_start();
+#endif
+#endif
+	if (gwto.cnx_tries >= gwto.cfg.cnx_retries + gwto.cfg.cnx_backoff_retries) {
+		/* We have exhausted our the number of times to retry the connection. */
+		LOG_WRN("Connection retry limit reached (%d), wait in idle.", gwto.cnx_tries);
+		set_state(GW_DM_STATE_IDLE_STAY);
+		return;
+	} else if (gwto.cnx_tries >= gwto.cfg.cnx_retries) {
+		/* Parameters are applied each time so that changes take effect while backing off */
+		lcz_ble_gw_dm_backoff_configure(&gwto.backoff, gwto.cfg.cnx_backoff_policy,
+						gwto.cfg.cnx_delay, gwto.cfg.cnx_backoff_max,
+						gwto.cfg.cnx_backoff_multi);
+		gwto.dm_connection_delay_seconds = lcz_ble_gw_dm_backoff_next(&gwto.backoff);
+	}
+	set_state(GW_DM_STATE_WAIT_BEFORE_DM_CONNECTION);
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+static void memfault_upload_start(void)
+{
+	if (!gwto.memfault_upload_wanted || gwto.memfault_uploading) {
+		return;
+	}
+
+	if (lcz_ble_gw_dm_memfault_post_data_async(memfault_posted_callback) == 0) {
+		gwto.memfault_upload_wanted = false;
+		gwto.memfault_uploading = true;
+	}
+}
+
+/* Runs in the Memfault thread */
+static void memfault_posted_callback(int result)
+{
+	atomic_set(&memfault_result, result);
+	atomic_set(&memfault_done, 1);
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+	dispatch_enqueued(FMC_GW_DM_MEMFAULT_POSTED);
+#endif
+	if (!send_to_self(FMC_GW_DM_MEMFAULT_POSTED)) {
+		/* The kick retries until it is queued and the FSM run handles the result */
+		gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_MEMFAULT);
+	}
+}
+
+/* Called from both the posted message and FSM kicks, whichever runs first */
+static void memfault_posted_process(void)
+{
+	int result;
+
+	if (!atomic_cas(&memfault_done, 1, 0)) {
+		return;
+	}
+
+	result = (int)atomic_get(&memfault_result);
+	gwto.memfault_uploading = false;
+	if (result < 0) {
+		LOG_WRN("Memfault upload failed: %d", result);
+	}
+}
+
+static DispatchResult_t memfault_posted_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+{
+	memfault_posted_process();
+	gwto.cause = LCZ_BLE_GW_DM_TRACE_CAUSE_MEMFAULT;
+	gw_dm_fsm_run();
+	return DISPATCH_OK;
+}
+#endif
+
+static void wait_before_dm_connection_entry(void)
+{
+	arm_deadline(gwto.dm_connection_delay_seconds);
+	LOG_INF("Waiting %d seconds to connect to server", gwto.dm_connection_delay_seconds);
+}
+
+static void wait_before_dm_connection_tick(void)
+{
+	if (timer_expired()) {
+		if (gwto.network_ready) {
+			set_state(GW_DM_STATE_CONNECT_TO_DM);
 		} else {
-			LCZ_BLE_GW_DM_MEMFAULT_POST_DATA_SYNC();
-			if (gwto.cnx_tries >=
-			    attr_get_uint32(ATTR_ID_dm_cnx_retries, DM_CNX_RETRIES_FALLBACK) +
-				    attr_get_uint32(ATTR_ID_dm_cnx_backoff_retries,
-						    DM_CNX_BACKOFF_RETRIES_FALLBACK)) {
-				/* We have exhausted our the number of times to retry the connection. */
-				LOG_WRN("Connection retry limit reached (%d), wait in idle.",
-					gwto.cnx_tries);
-				set_state(GW_DM_STATE_IDLE_STAY);
-				break;
-			} else if (gwto.cnx_tries >=
-				   *(uint8_t *)attr_get_quasi_static(ATTR_ID_dm_cnx_retries)) {
-				gwto.dm_connection_delay_seconds *= *(float *)attr_get_quasi_static(
-					ATTR_ID_dm_cnx_backoff_multi);
-			}
-			gwto.timer = gwto.dm_connection_delay_seconds;
-			set_state(GW_DM_STATE_WAIT_BEFORE_DM_CONNECTION);
-			LOG_INF("Waiting %d seconds to connect to server",
-				gwto.dm_connection_delay_seconds);
-		}
-		break;
-	case GW_DM_STATE_WAIT_BEFORE_DM_CONNECTION:
-		if (timer_expired()) {
-			if (gwto.network_ready) {
-				set_state(GW_DM_STATE_CONNECT_TO_DM);
-			} else {
-				set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
-			}
-		}
-		break;
-	case GW_DM_STATE_CONNECT_TO_DM:
-		if (!gwto.network_ready) {
 			set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
-		} else {
-			gwto.lwm2m_connection_err = false;
-			gwto.timer = gwto.dm_connection_timeout_seconds;
+		}
+	}
+}
+
+static void connect_to_dm_tick(void)
+{
+	int ret;
+	char *ep_name;
+
+	if (!gwto.network_ready) {
+		set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
+		return;
+	}
+
+	gwto.lwm2m_connection_err = false;
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+	/* Start the telemetry handshake alongside the DM handshake */
+	gwto.telem.requested = true;
+#endif
 #if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES)
-			ep_name = (char *)attr_get_quasi_static(ATTR_ID_lwm2m_endpoint);
+	ep_name = gwto.cfg.endpoint;
 #else
-			ep_name = CONFIG_LCZ_LWM2M_CLIENT_ENDPOINT_NAME;
-#endif
-			ret = lcz_lwm2m_client_connect(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX,
-						       CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX,
-						       CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX, ep_name,
-						       LCZ_LWM2M_CLIENT_TRANSPORT_UDP,
-						       CONFIG_LCZ_LWM2M_TLS_TAG, lcz_lwm2m_dm_load_certs);
-			if (ret < 0) {
-				set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
-				gwto.cnx_tries++;
-				MFLT_METRICS_ADD(lwm2m_dm_connect_fail, 1);
-			} else {
-				set_state(GW_DM_STATE_WAIT_FOR_CONNECTION);
-			}
-		}
-		break;
-	case GW_DM_STATE_WAIT_FOR_CONNECTION:
-		if (!gwto.network_ready) {
-			set_state(GW_DM_STATE_DISCONNECT_DM);
-		} else if (gwto.lwm2m_connection_err) {
-			gwto.cnx_tries++;
-			MFLT_METRICS_ADD(lwm2m_dm_connect_fail, 1);
-			set_state(GW_DM_STATE_DISCONNECT_DM);
+	ep_name = CONFIG_LCZ_LWM2M_CLIENT_ENDPOINT_NAME;
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+	lcz_ble_gw_dm_dtls_handshake_start();
+#endif
+	cnx_timing.connect_start = k_uptime_get();
+	ret = lcz_lwm2m_client_connect(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX,
+				       CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX,
+				       CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX, ep_name,
+				       LCZ_LWM2M_CLIENT_TRANSPORT_UDP, CONFIG_LCZ_LWM2M_TLS_TAG,
+				       dm_load_certs);
+	if (ret < 0) {
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+		lcz_ble_gw_dm_dtls_handshake_done(false);
+#endif
+		set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
+		gwto.cnx_tries++;
+		MFLT_METRICS_ADD(lwm2m_dm_connect_fail, 1);
+	} else {
+		set_state(GW_DM_STATE_WAIT_FOR_CONNECTION);
+	}
+}
+
+static void wait_for_connection_entry(void)
+{
+	arm_deadline(gwto.dm_connection_timeout_seconds);
+}
+
+static void wait_for_connection_tick(void)
+{
+	if (!gwto.network_ready) {
+		set_state(GW_DM_STATE_DISCONNECT_DM);
+	} else if (gwto.lwm2m_connection_err) {
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+		lcz_ble_gw_dm_dtls_handshake_done(false);
+#endif
+		gwto.cnx_tries++;
+		MFLT_METRICS_ADD(lwm2m_dm_connect_fail, 1);
+		set_state(GW_DM_STATE_DISCONNECT_DM);
+	} else if (gwto.lwm2m_connected) {
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+		lcz_ble_gw_dm_dtls_handshake_done(true);
+#endif
+		gwto.cnx_tries = 0;
+		gwto.dm_connection_delay_seconds = gwto.cfg.cnx_delay;
+		lcz_ble_gw_dm_backoff_reset(&gwto.backoff);
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_UPLOAD_AFTER_REGISTRATION)
+		memfault_upload_start();
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+		/* Telemetry is managed by its own session */
+		set_state(GW_DM_STATE_IDLE);
+#elif defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+		gwto.telem_enabled = telem_enable_get();
+		if (gwto.telem_enabled) {
+			set_state(GW_DM_STATE_CONNECT_TELEM);
 		} else {
-			if (gwto.lwm2m_connected) {
-				gwto.cnx_tries = 0;
-				gwto.dm_connection_delay_seconds = attr_get_uint32(
-					ATTR_ID_dm_cnx_delay, DM_CONNECTION_DELAY_FALLBACK);
+			set_state(GW_DM_STATE_IDLE);
+		}
+#else
+		set_state(GW_DM_STATE_IDLE);
+#endif
+	} else if (timer_expired()) {
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+		lcz_ble_gw_dm_dtls_handshake_done(false);
+#endif
+		gwto.cnx_tries++;
+		MFLT_METRICS_ADD(lwm2m_dm_connect_fail, 1);
+		set_state(GW_DM_STATE_DISCONNECT_DM);
+	}
+}
+
 #if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+static bool telem_enable_get(void)
+{
 #if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES)
-				gwto.telem_enabled =
-					*(bool *)attr_get_quasi_static(ATTR_ID_lwm2m_telem_enable);
-				if (gwto.telem_enabled) {
-					set_state(GW_DM_STATE_CONNECT_TELEM);
-				} else {
-					set_state(GW_DM_STATE_IDLE);
-				}
+	return gwto.cfg.telem_enable;
 #else
-				set_state(GW_DM_STATE_CONNECT_TELEM);
+	return true;
 #endif
+}
+
+static int telem_connect(void)
+{
+	int ret;
+	char *ep_name;
+
+	gwto.lwm2m_telem_connection_err = false;
+#if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES)
+	ep_name = gwto.cfg.telem_endpoint;
 #else
-				set_state(GW_DM_STATE_IDLE);
+	ep_name = LCZ_BLE_GW_DM_TELEM_LWM2M_ENDPOINT_NAME;
 #endif
-			} else if (timer_expired()) {
-				gwto.cnx_tries++;
-				MFLT_METRICS_ADD(lwm2m_dm_connect_fail, 1);
-				set_state(GW_DM_STATE_DISCONNECT_DM);
-			}
+	ret = lwm2m_telemetry_init();
+	if (ret < 0) {
+		return ret;
+	}
+
+	return lcz_lwm2m_client_connect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX,
+					CONFIG_LCZ_BLE_GW_DM_TELEMETRY_SERVER_INST,
+					CONFIG_LCZ_BLE_GW_DM_TELEMETRY_SERVER_INST, ep_name,
+					LCZ_LWM2M_CLIENT_TRANSPORT_UDP,
+					CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_TLS_TAG,
+					lcz_lwm2m_dm_load_certs);
+}
+
+static void connect_telem_tick(void)
+{
+	if (!gwto.network_ready) {
+		set_state(GW_DM_STATE_DISCONNECT_DM);
+		return;
+	}
+
+	if (telem_connect() < 0) {
+		if (!lcz_lwm2m_client_is_connected(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX)) {
+			set_state(GW_DM_STATE_DISCONNECT_DM);
+		} else {
+			arm_deadline(FSM_RETRY_DELAY_SECONDS);
 		}
-		break;
-#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
-	case GW_DM_STATE_CONNECT_TELEM:
-		if (!gwto.network_ready) {
+	} else {
+		set_state(GW_DM_STATE_WAIT_FOR_TELEM_CONNECTION);
+	}
+}
+
+static void wait_for_telem_connection_tick(void)
+{
+	if (!gwto.network_ready) {
+		set_state(GW_DM_STATE_DISCONNECT_DM);
+	} else if (gwto.lwm2m_telem_connection_err) {
+		if (!lcz_lwm2m_client_is_connected(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX)) {
 			set_state(GW_DM_STATE_DISCONNECT_DM);
 		} else {
-			gwto.lwm2m_connection_err = false;
-			gwto.timer = gwto.dm_connection_timeout_seconds;
-#if defined(CONFIG_LCZ_LWM2M_CLIENT_ENABLE_ATTRIBUTES)
-			ep_name = (char *)attr_get_quasi_static(ATTR_ID_lwm2m_telem_endpoint);
-#else
-			ep_name = LCZ_BLE_GW_DM_TELEM_LWM2M_ENDPOINT_NAME;
+			set_state(GW_DM_STATE_DISCONNECT_TELEM);
+		}
+	} else if (gwto.lwm2m_telem_connected) {
+		set_state(GW_DM_STATE_IDLE);
+	} else if (timer_expired()) {
+		set_state(GW_DM_STATE_DISCONNECT_TELEM);
+	}
+}
+
+static void disconnect_telem_tick(void)
+{
+	if (!lcz_lwm2m_client_is_connected(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX)) {
+		set_state(GW_DM_STATE_DISCONNECT_DM);
+	} else {
+		lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
+		set_state(GW_DM_STATE_CONNECT_TELEM);
+	}
+}
+#endif /* CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M */
+
+static void idle_tick(void)
+{
+	if (!gwto.network_ready || !gwto.lwm2m_connected) {
+		set_state(GW_DM_STATE_DISCONNECT_DM);
+	}
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M) && !defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+	else if (gwto.telem_enabled && !gwto.lwm2m_telem_connected) {
+		set_state(GW_DM_STATE_DISCONNECT_TELEM);
+	}
 #endif
-			ret = lwm2m_telemetry_init();
-			if (ret < 0) {
-				break;
-			}
+}
 
-			ret = lcz_lwm2m_client_connect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX,
-						       CONFIG_LCZ_BLE_GW_DM_TELEMETRY_SERVER_INST,
-						       CONFIG_LCZ_BLE_GW_DM_TELEMETRY_SERVER_INST,
-						       ep_name, LCZ_LWM2M_CLIENT_TRANSPORT_UDP,
-						       CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_TLS_TAG, lcz_lwm2m_dm_load_certs);
-			if (ret < 0) {
-				if (!lcz_lwm2m_client_is_connected(
-					    CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX)) {
-					set_state(GW_DM_STATE_DISCONNECT_DM);
-				}
-			} else {
-				set_state(GW_DM_STATE_WAIT_FOR_TELEM_CONNECTION);
-			}
+static void disconnect_dm_tick(void)
+{
+	lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX, false);
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+	/* The telemetry session tears itself down when it is no longer requested */
+	if (!IS_ENABLED(CONFIG_LCZ_BLE_GW_DM_TELEM_INDEPENDENT) || !gwto.network_ready) {
+		gwto.telem.requested = false;
+	}
+#elif defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+	lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
+#endif
+	set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+static void set_telem_session_state(enum telem_session_state next_state)
+{
+	if (next_state != gwto.telem.state) {
+		LOG_DBG("Telemetry session %d -> %d", gwto.telem.state, next_state);
+		gwto.telem.state = next_state;
+		gwto.telem.deadline = 0;
+		rearm_deadline_timer();
+	}
+}
+
+static void arm_telem_session_deadline(uint32_t seconds)
+{
+	gwto.telem.deadline = k_uptime_get() + ((int64_t)seconds * MSEC_PER_SEC);
+	rearm_deadline_timer();
+}
+
+static bool telem_session_allowed(void)
+{
+	if (!gwto.network_ready) {
+		gwto.telem.requested = false;
+	}
+
+	return gwto.telem.requested && telem_enable_get();
+}
+
+/* Telemetry counterpart of gw_dm_fsm(). A telemetry failure only restarts this session, the DM
+ * connection is not touched.
+ */
+static void telem_session_fsm(void)
+{
+	bool allowed = telem_session_allowed();
+
+	switch (gwto.telem.state) {
+	case TELEM_SESSION_STOPPED:
+		if (allowed) {
+			set_telem_session_state(TELEM_SESSION_CONNECT);
 		}
 		break;
-	case GW_DM_STATE_WAIT_FOR_TELEM_CONNECTION:
-		if (!gwto.network_ready) {
-			set_state(GW_DM_STATE_DISCONNECT_DM);
-		} else if (gwto.lwm2m_connection_err) {
-			if (!lcz_lwm2m_client_is_connected(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX)) {
-				set_state(GW_DM_STATE_DISCONNECT_DM);
-			} else {
-				set_state(GW_DM_STATE_DISCONNECT_TELEM);
-			}
+	case TELEM_SESSION_CONNECT:
+		if (!allowed) {
+			set_telem_session_state(TELEM_SESSION_STOPPED);
+		} else if (telem_connect() < 0) {
+			set_telem_session_state(TELEM_SESSION_RETRY_DELAY);
+			arm_telem_session_deadline(CONFIG_LCZ_BLE_GW_DM_TELEM_RETRY_DELAY);
 		} else {
-			if (gwto.lwm2m_telem_connected) {
-				set_state(GW_DM_STATE_IDLE);
-			} else if (timer_expired()) {
-				set_state(GW_DM_STATE_DISCONNECT_TELEM);
-			}
+			set_telem_session_state(TELEM_SESSION_WAIT_FOR_CONNECTION);
+			arm_telem_session_deadline(CONFIG_LCZ_BLE_GW_DM_TELEM_CONNECTION_TIMEOUT);
 		}
 		break;
-	case GW_DM_STATE_DISCONNECT_TELEM:
-		if (!lcz_lwm2m_client_is_connected(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX)) {
-			set_state(GW_DM_STATE_DISCONNECT_DM);
-		} else {
+	case TELEM_SESSION_WAIT_FOR_CONNECTION:
+		if (!allowed) {
 			lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
-			set_state(GW_DM_STATE_CONNECT_TELEM);
+			set_telem_session_state(TELEM_SESSION_STOPPED);
+		} else if (gwto.lwm2m_telem_connected) {
+			set_telem_session_state(TELEM_SESSION_CONNECTED);
+		} else if (gwto.lwm2m_telem_connection_err ||
+			   k_uptime_get() >= gwto.telem.deadline) {
+			lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
+			set_telem_session_state(TELEM_SESSION_RETRY_DELAY);
+			arm_telem_session_deadline(CONFIG_LCZ_BLE_GW_DM_TELEM_RETRY_DELAY);
 		}
 		break;
-#endif /* CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M */
-	case GW_DM_STATE_IDLE:
-		if (!gwto.network_ready || !gwto.lwm2m_connected) {
-			set_state(GW_DM_STATE_DISCONNECT_DM);
+	case TELEM_SESSION_CONNECTED:
+		if (!allowed) {
+			lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
+			set_telem_session_state(TELEM_SESSION_STOPPED);
+		} else if (!gwto.lwm2m_telem_connected) {
+			/* Reconnect right away, failures of the reconnect are delayed */
+			lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
+			set_telem_session_state(TELEM_SESSION_CONNECT);
 		}
-#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
-		else if (gwto.telem_enabled && !gwto.lwm2m_telem_connected) {
-			set_state(GW_DM_STATE_DISCONNECT_TELEM);
+		break;
+	case TELEM_SESSION_RETRY_DELAY:
+		if (!allowed) {
+			set_telem_session_state(TELEM_SESSION_STOPPED);
+		} else if (k_uptime_get() >= gwto.telem.deadline) {
+			set_telem_session_state(TELEM_SESSION_CONNECT);
 		}
-#endif
 		break;
-	case GW_DM_STATE_IDLE_STAY:
-		/* wait here until reboot watchdog fires */
+	default:
 		break;
-	case GW_DM_STATE_DISCONNECT_DM:
-		lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX, false);
-#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
-		lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
+	}
+}
+#endif /* CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL */
+
+static void gw_dm_fsm(void)
+{
+	if (STATE_TABLE[gwto.state].tick != NULL) {
+		STATE_TABLE[gwto.state].tick();
+	}
+}
+
+/* Run the FSM until it settles in a state that is waiting on an event or a deadline */
+static void gw_dm_fsm_run(void)
+{
+	enum gw_dm_state prev;
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+	enum telem_session_state telem_prev;
+#endif
+	int steps = 0;
+
+	do {
+		prev = gwto.state;
+		gw_dm_fsm();
+		steps++;
+	} while (gwto.state != prev && steps < FSM_MAX_STEPS_PER_RUN);
+
+	if (gwto.state != prev) {
+		/* Still transitioning, continue after the other queued messages. The deadline
+		 * belongs to the new state and is left alone.
+		 */
+		gw_dm_fsm_kick((enum lcz_ble_gw_dm_trace_cause)gwto.cause);
+	}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_PARALLEL)
+	steps = 0;
+	do {
+		telem_prev = gwto.telem.state;
+		telem_session_fsm();
+		steps++;
+	} while (gwto.telem.state != telem_prev && steps < FSM_MAX_STEPS_PER_RUN);
+#endif
+}
+
+/* Returns false if the message couldn't be allocated or queued */
+static bool send_to_self(FwkMsgCode_t code)
+{
+	FwkMsg_t *pMsg = (FwkMsg_t *)BufferPool_Take(sizeof(FwkMsg_t));
+
+	if (pMsg == NULL) {
+		return false;
+	}
+
+	pMsg->header.msgCode = code;
+	pMsg->header.txId = FWK_ID_BLE_GW_DM;
+	pMsg->header.rxId = FWK_ID_BLE_GW_DM;
+	if (Framework_Send(FWK_ID_BLE_GW_DM, pMsg) != FWK_SUCCESS) {
+		BufferPool_Free(pMsg);
+		return false;
+	}
+
+	return true;
+}
+
+/* Request an FSM run from outside of the task context. Only one request is queued at a time. */
+static void gw_dm_fsm_kick(enum lcz_ble_gw_dm_trace_cause cause)
+{
+	atomic_set_bit(&kick_causes, cause);
+	fsm_kick_send();
+}
+
+static void fsm_kick_send(void)
+{
+	if (atomic_cas(&fsm_kick_pending, 0, 1)) {
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+		dispatch_enqueued(FMC_GW_DM_FSM_KICK);
 #endif
-		set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
-		break;
-	default:
-		break;
+		if (!send_to_self(FMC_GW_DM_FSM_KICK)) {
+			/* The causes stay set and are delivered with the retry */
+			LOG_WRN("Unable to queue FSM kick");
+			atomic_clear(&fsm_kick_pending);
+			lcz_ble_gw_dm_timer_start(&fsm_kick_retry_timer,
+						  FSM_RETRY_DELAY_SECONDS * MSEC_PER_SEC, 0);
+		}
+	}
+}
+
+/* Run the handler of each slot whose message was dropped, the handlers only use the slot */
+static void coalesce_deliver_undelivered(void)
+{
+	atomic_val_t slots = atomic_clear(&queue.undelivered);
+	FwkMsgHandler_t *handler;
+	int slot;
+
+	for (slot = 0; (slot < COALESCE_SLOT__NUM) && (slots != 0); slot++) {
+		if (slots & ATOMIC_MASK(slot)) {
+			slots &= ~ATOMIC_MASK(slot);
+			handler = gw_dm_task_msg_handler(COALESCE_MSG_CODE[slot]);
+			(void)handler(NULL, NULL);
+		}
 	}
 }
 
-static DispatchResult_t gateway_fsm_tick_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+/* Handles FSM kicks, including those from state deadline expiration */
+static DispatchResult_t gateway_fsm_event_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
 {
-	gw_dm_fsm();
-	Framework_StartTimer(&gwto.msgTask);
+	atomic_val_t causes;
+
+	/* Include this message, it has already been removed from the queue */
+	queue_high_water_update(k_msgq_num_used_get(&gw_dm_task_queue) + 1);
+
+	atomic_clear(&fsm_kick_pending);
+	coalesce_deliver_undelivered();
+	causes = atomic_clear(&kick_causes);
+	/* The lowest set bit has priority when several kicks were merged */
+	gwto.cause = (causes != 0) ? (uint8_t)u32_count_trailing_zeros((uint32_t)causes) :
+				     LCZ_BLE_GW_DM_TRACE_CAUSE_DEADLINE;
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+	recovery_run_pending();
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+	psm_align_update();
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	memfault_posted_process();
+#endif
+	gw_dm_fsm_run();
 	return DISPATCH_OK;
 }
 
 #if defined(CONFIG_LCZ_LWM2M_UTIL_FWK_BROADCAST_ON_CREATE)
 static DispatchResult_t lwm2m_telem_reregister(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
 {
+	atomic_clear_bit(&queue.pending, COALESCE_OBJ_CREATED);
 #if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+	/* The created object may be a security or server instance */
+	lwm2m_telemetry_invalidate();
 	if (lcz_lwm2m_client_is_connected(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX)) {
 		lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX, false);
+		gwto.cause = LCZ_BLE_GW_DM_TRACE_CAUSE_OBJ_CREATED;
+		gw_dm_fsm_run();
 	}
 #endif
 	return DISPATCH_OK;
@@ -642,12 +1585,27 @@ static DispatchResult_t lwm2m_telem_reregister(FwkMsgReceiver_t *pMsgRxer, FwkMs
 #endif
 
 static FwkMsgHandler_t *gw_dm_task_msg_dispatcher(FwkMsgCode_t MsgCode)
+{
+	FwkMsgHandler_t *handler = gw_dm_task_msg_handler(MsgCode);
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+	if (handler != NULL && dispatch_index(MsgCode) >= 0) {
+		return profiled_msg_handler;
+	}
+#endif
+	return handler;
+}
+
+static FwkMsgHandler_t *gw_dm_task_msg_handler(FwkMsgCode_t MsgCode)
 {
 	/* clang-format off */
     switch (MsgCode) {
     case FMC_INVALID:                    return Framework_UnknownMsgHandler;
-    case FMC_PERIODIC:                   return gateway_fsm_tick_handler;
+    case FMC_GW_DM_FSM_KICK:             return gateway_fsm_event_handler;
     case FMC_ATTR_CHANGED:               return attr_broadcast_msg_handler;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+    case FMC_GW_DM_MEMFAULT_POSTED:      return memfault_posted_handler;
+#endif
 #if defined(CONFIG_LCZ_POWER)
     case FMC_LCZ_SENSOR_MEASURED:	     return lcz_sensor_msg_handler;
 #if defined(CONFIG_BOARD_MG100)
@@ -662,6 +1620,103 @@ static FwkMsgHandler_t *gw_dm_task_msg_dispatcher(FwkMsgCode_t MsgCode)
 	/* clang-format on */
 }
 
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+static int dispatch_index(FwkMsgCode_t MsgCode)
+{
+	switch (MsgCode) {
+	case FMC_GW_DM_FSM_KICK:
+		return LCZ_BLE_GW_DM_DISPATCH_FSM_KICK;
+	case FMC_ATTR_CHANGED:
+		return LCZ_BLE_GW_DM_DISPATCH_ATTR_CHANGED;
+#if defined(CONFIG_LCZ_POWER)
+	case FMC_LCZ_SENSOR_MEASURED:
+		return LCZ_BLE_GW_DM_DISPATCH_SENSOR_MEASURED;
+#if defined(CONFIG_BOARD_MG100)
+	case FMC_LCZ_POWER_BATTERY_STATE:
+		return LCZ_BLE_GW_DM_DISPATCH_BATTERY_STATE;
+#endif
+#endif
+#if defined(CONFIG_LCZ_LWM2M_UTIL_FWK_BROADCAST_ON_CREATE)
+	case FMC_LWM2M_OBJ_CREATED:
+		return LCZ_BLE_GW_DM_DISPATCH_OBJ_CREATED;
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT)
+	case FMC_GW_DM_MEMFAULT_POSTED:
+		return LCZ_BLE_GW_DM_DISPATCH_MEMFAULT_POSTED;
+#endif
+	default:
+		return -1;
+	}
+}
+
+static void dispatch_enqueued(FwkMsgCode_t MsgCode)
+{
+	int msg = dispatch_index(MsgCode);
+	k_spinlock_key_t key;
+
+	if (msg >= 0) {
+		key = k_spin_lock(&dispatch_lock);
+		dispatch_queued[msg] = k_uptime_ticks();
+		k_spin_unlock(&dispatch_lock, key);
+	}
+}
+
+/* Lock must be held */
+static void dispatch_timing_add(struct lcz_ble_gw_dm_dispatch_timing *timing, uint32_t us,
+				bool first)
+{
+	int b = (us < 2) ? 0 : (31 - u32_count_leading_zeros(us));
+
+	timing->min_us = first ? us : MIN(timing->min_us, us);
+	timing->max_us = MAX(timing->max_us, us);
+	timing->total_us += us;
+	timing->hist[MIN(b, LCZ_BLE_GW_DM_DISPATCH_HIST_BUCKETS - 1)]++;
+}
+
+/* Wraps every handler when profiling is enabled */
+static DispatchResult_t profiled_msg_handler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+{
+	int msg = dispatch_index(pMsg->header.msgCode);
+	struct lcz_ble_gw_dm_dispatch_stats *s = &dispatch_stats[msg];
+	DispatchResult_t result;
+	k_spinlock_key_t key;
+	int64_t start = k_uptime_ticks();
+	uint32_t start_cycles = k_cycle_get_32();
+	uint32_t exec_us;
+	uint32_t wait_us;
+	uint32_t exec_max_us;
+	uint32_t wait_max_us;
+	bool new_max;
+
+	result = gw_dm_task_msg_handler(pMsg->header.msgCode)(pMsgRxer, pMsg);
+	exec_us = k_cyc_to_us_floor32(k_cycle_get_32() - start_cycles);
+
+	key = k_spin_lock(&dispatch_lock);
+	wait_us = (dispatch_queued[msg] != 0) ?
+			  (uint32_t)k_ticks_to_us_floor64(start - dispatch_queued[msg]) :
+			  0;
+	s->count++;
+	dispatch_timing_add(&s->exec, exec_us, s->count == 1);
+	dispatch_timing_add(&s->wait, wait_us, s->count == 1);
+	new_max = (exec_us > dispatch_exec_max_us) || (wait_us > dispatch_wait_max_us);
+	dispatch_exec_max_us = MAX(dispatch_exec_max_us, exec_us);
+	dispatch_wait_max_us = MAX(dispatch_wait_max_us, wait_us);
+	exec_max_us = dispatch_exec_max_us;
+	wait_max_us = dispatch_wait_max_us;
+	k_spin_unlock(&dispatch_lock, key);
+
+	if (new_max) {
+		MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_dispatch_exec_max_us, exec_max_us);
+		MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_dispatch_wait_max_us, wait_max_us);
+		if (exec_us == exec_max_us) {
+			MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_dispatch_slowest_msg, msg);
+		}
+	}
+
+	return result;
+}
+#endif
+
 static void nm_event_callback(enum lcz_nm_event event)
 {
 	LOG_DBG("Network monitor event %d", event);
@@ -669,10 +1724,12 @@ static void nm_event_callback(enum lcz_nm_event event)
 	case LCZ_NM_EVENT_IFACE_DOWN:
 		set_network_ready(false);
 		FRAMEWORK_MSG_CREATE_AND_BROADCAST(FWK_ID_BLE_GW_DM, FMC_NETWORK_DISCONNECTED);
+		gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_NETWORK);
 		break;
 	case LCZ_NM_EVENT_IFACE_DNS_ADDED:
 		set_network_ready(true);
 		FRAMEWORK_MSG_CREATE_AND_BROADCAST(FWK_ID_BLE_GW_DM, FMC_NETWORK_CONNECTED);
+		gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_NETWORK);
 		break;
 	default:
 		break;
@@ -682,9 +1739,17 @@ static void nm_event_callback(enum lcz_nm_event event)
 static void lwm2m_client_connected_event(struct lwm2m_ctx *client, int lwm2m_client_index,
 					 bool connected, enum lwm2m_rd_client_event client_event)
 {
-	gwto.lwm2m_connection_err = false;
 	bool pet_disconnect_watchdog = false;
 
+	if (lwm2m_client_index == CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX) {
+		gwto.lwm2m_connection_err = false;
+	}
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+	else {
+		gwto.lwm2m_telem_connection_err = false;
+	}
+#endif
+
 	if (gwto.lwm2m_connected && !connected) {
 		pet_disconnect_watchdog = true;
 	}
@@ -693,6 +1758,7 @@ static void lwm2m_client_connected_event(struct lwm2m_ctx *client, int lwm2m_cli
 		if (gwto.lwm2m_connected && !connected) {
 			MFLT_METRICS_ADD(lwm2m_dm_disconnect, 1);
 		}
+		cnx_timing_lwm2m_event(client_event, gwto.lwm2m_connected, connected);
 		gwto.lwm2m_connected = connected;
 #if defined(CONFIG_LCZ_BLE_GW_DM_DEVICE_MANAGEMENT_STATUS_LED)
 		gwto.lwm2m_connected ? (void)lcz_led_turn_on(DM_LED) :
@@ -706,6 +1772,10 @@ static void lwm2m_client_connected_event(struct lwm2m_ctx *client, int lwm2m_cli
 #endif
 
 	if (lwm2m_client_index == CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX) {
+		gwto.lwm2m_event = (uint8_t)client_event;
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+		psm_lwm2m_event(client_event, client->srv_obj_inst);
+#endif
 		switch (client_event) {
 		case LWM2M_RD_CLIENT_EVENT_REGISTRATION_COMPLETE:
 		case LWM2M_RD_CLIENT_EVENT_REG_UPDATE_COMPLETE:
@@ -731,42 +1801,214 @@ static void lwm2m_client_connected_event(struct lwm2m_ctx *client, int lwm2m_cli
 		case LWM2M_RD_CLIENT_EVENT_BOOTSTRAP_REG_FAILURE:
 		case LWM2M_RD_CLIENT_EVENT_REGISTRATION_FAILURE:
 		case LWM2M_RD_CLIENT_EVENT_NETWORK_ERROR:
-			gwto.lwm2m_connection_err = true;
+			gwto.lwm2m_telem_connection_err = true;
 			break;
 		default:
 			break;
 		}
 	}
 #endif
+
+	gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_LWM2M);
 }
 
-static void disconnect_work_cb(struct k_work *work)
+/* Runs in the LwM2M client context for DM client events */
+static void cnx_timing_lwm2m_event(enum lwm2m_rd_client_event client_event, bool was_connected,
+				   bool connected)
 {
-	ARG_UNUSED(work);
-	lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX, false);
+	int64_t now = k_uptime_get();
+
+	switch (client_event) {
+	case LWM2M_RD_CLIENT_EVENT_REGISTRATION_COMPLETE:
+		/* Connect call to registration, the DTLS handshake is most of this */
+		if (cnx_timing.connect_start != 0) {
+			MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_handshake_ms,
+						  (uint32_t)(now - cnx_timing.connect_start));
+			cnx_timing.connect_start = 0;
+		}
+		if (cnx_timing.network_up != 0) {
+			MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_time_to_online_ms,
+						  (uint32_t)(now - cnx_timing.network_up));
+			cnx_timing.network_up = 0;
+		}
+		cnx_timing.session_start = now;
+		break;
+	case LWM2M_RD_CLIENT_EVENT_REG_UPDATE_COMPLETE:
+		if (cnx_timing.update_start != 0) {
+			MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_reg_update_rtt_ms,
+						  (uint32_t)(now - cnx_timing.update_start));
+			cnx_timing.update_start = 0;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (was_connected && !connected) {
+		if (cnx_timing.session_start != 0) {
+			MFLT_METRICS_SET_UNSIGNED(
+				lwm2m_dm_session_s,
+				(uint32_t)((now - cnx_timing.session_start) / MSEC_PER_SEC));
+		}
+		cnx_timing.session_start = 0;
+		cnx_timing.update_start = 0;
+	}
+}
+
+/* Only updates requested here are timed, the engine doesn't report when it starts its own */
+static void reg_update_request(void)
+{
+	cnx_timing.update_start = k_uptime_get();
+	lwm2m_rd_client_update();
 }
 
-static void network_search_timer_callback(struct k_timer *timer_id)
+static void network_search_timer_callback(struct lcz_ble_gw_dm_timer *timer)
 {
 #if defined(CONFIG_LCZ_BLE_GW_DM_NETWORK_STATUS_LED)
 	lcz_led_blink(NETWORK_LED, &NETWORK_SEARCH_LED_PATTERN, true);
 #endif
 }
 
-/* This is an ISR, no time consuming calls can take place in this context */
-static void connection_watchdog_timer_callback(struct k_timer *timer_id)
+static void fsm_deadline_timer_callback(struct lcz_ble_gw_dm_timer *timer)
 {
-	if (timer_id == &connection_watchdog_timer) {
+	gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_DEADLINE);
+}
+
+static void fsm_kick_retry_timer_callback(struct lcz_ble_gw_dm_timer *timer)
+{
+	fsm_kick_send();
+}
+
+/* Runs on the system work queue */
+static void connection_watchdog_timer_callback(struct lcz_ble_gw_dm_timer *timer)
+{
+	if (timer == &connection_watchdog_timer) {
 		LOG_WRN("Connection watchdog expired!");
 		MFLT_METRICS_ADD(lwm2m_dm_watchdog, 1);
-		k_work_submit(&disconnect_work);
-	} else if (timer_id == &connection_watchdog_reboot_timer) {
-		LOG_WRN("Connection reboot watchdog expired!");
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+		/* Once started, the ladder is driven by its own timer */
+		if (atomic_get(&recovery.step) == LCZ_BLE_GW_DM_RECOVERY_NONE) {
+			recovery_escalate();
+		}
+#else
+		lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX, false);
+#endif
+	}
+}
+
+static void connection_watchdog_reboot_timer_callback(struct k_timer *timer_id)
+{
+	LOG_WRN("Connection reboot watchdog expired!");
+	/* This is a blocking call, but we don't care, we want to reboot */
+	lcz_software_reset_after_assert(CONNECTION_WATCHDOG_REBOOT_DELAY_MS);
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+/* Move to the next enabled step. Runs on the system work queue so that a blocked task
+ * can't prevent the reboot.
+ */
+static void recovery_escalate(void)
+{
+	atomic_val_t step = atomic_get(&recovery.step);
+
+	do {
+		step++;
+	} while (step < LCZ_BLE_GW_DM_RECOVERY_REBOOT && RECOVERY_TIMEOUTS[step] == 0);
+
+	if (step == LCZ_BLE_GW_DM_RECOVERY_REBOOT &&
+	    !IS_ENABLED(CONFIG_LCZ_BLE_GW_DM_RECOVERY_REBOOT)) {
+		/* Leave the reboot to the connection reboot watchdog */
+		LOG_WRN("Connection recovery steps exhausted");
+		return;
+	}
+
+	if (atomic_get(&recovery.step) == LCZ_BLE_GW_DM_RECOVERY_NONE) {
+		recovery.start = k_uptime_get();
+	}
+	atomic_set(&recovery.step, step);
+	recovery.attempts[step]++;
+	LOG_WRN("Connection recovery: %s", RECOVERY_STEP_NAMES[step]);
+
+	switch (step) {
+	case LCZ_BLE_GW_DM_RECOVERY_REREGISTER:
+		MFLT_METRICS_ADD(lwm2m_dm_recovery_reregister, 1);
+		break;
+	case LCZ_BLE_GW_DM_RECOVERY_RECREATE_CONTEXT:
+		MFLT_METRICS_ADD(lwm2m_dm_recovery_recreate, 1);
+		break;
+	default:
+		MFLT_METRICS_ADD(lwm2m_dm_recovery_reboot, 1);
 		/* This is a blocking call, but we don't care, we want to reboot */
 		lcz_software_reset_after_assert(CONNECTION_WATCHDOG_REBOOT_DELAY_MS);
+		return;
+	}
+
+	lcz_ble_gw_dm_timer_start(&recovery_timer, RECOVERY_TIMEOUTS[step] * MSEC_PER_SEC, 0);
+	atomic_set(&recovery.pending, 1);
+	gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_RECOVERY);
+}
+
+/* Steps other than reboot change FSM and LwM2M client state so they run in the task */
+static void recovery_run_pending(void)
+{
+	if (!atomic_cas(&recovery.pending, 1, 0)) {
+		return;
+	}
+
+	switch (atomic_get(&recovery.step)) {
+	case LCZ_BLE_GW_DM_RECOVERY_REREGISTER:
+		if (gwto.lwm2m_connected) {
+			reg_update_request();
+			return;
+		}
+		break;
+	case LCZ_BLE_GW_DM_RECOVERY_RECREATE_CONTEXT:
+#if defined(CONFIG_LCZ_BLE_GW_DM_DTLS_SESSION_CACHE)
+		/* Don't reuse a session the server may have dropped */
+		lcz_ble_gw_dm_dtls_session_invalidate();
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+		lwm2m_telemetry_invalidate();
+#endif
+		lcz_lwm2m_client_disconnect(CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX, false);
+		break;
+	default:
+		return;
+	}
+
+	/* Start over with a fresh retry budget, even if retries were exhausted */
+	gwto.cnx_tries = 0;
+	gwto.dm_connection_delay_seconds = gwto.cfg.cnx_delay;
+	lcz_ble_gw_dm_backoff_reset(&gwto.backoff);
+	if (gwto.state == GW_DM_STATE_IDLE_STAY) {
+		set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
+	}
+}
+
+static void recovery_complete(void)
+{
+	atomic_val_t step = atomic_set(&recovery.step, LCZ_BLE_GW_DM_RECOVERY_NONE);
+
+	if (step == LCZ_BLE_GW_DM_RECOVERY_NONE) {
+		return;
 	}
+
+	lcz_ble_gw_dm_timer_stop(&recovery_timer);
+	atomic_clear(&recovery.pending);
+	recovery.recovered[step]++;
+	recovery.last_recovery_ms = (uint32_t)(k_uptime_get() - recovery.start);
+	MFLT_METRICS_ADD(lwm2m_dm_recovered, 1);
+	MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_recovery_ms, recovery.last_recovery_ms);
+	LOG_INF("Connection recovered after '%s' in %u ms", RECOVERY_STEP_NAMES[step],
+		recovery.last_recovery_ms);
 }
 
+static void recovery_timer_callback(struct lcz_ble_gw_dm_timer *timer)
+{
+	recovery_escalate();
+}
+#endif
+
 static void pet_connection_watchdog(bool in_connection, int srv_obj_inst)
 {
 	int ret;
@@ -786,26 +2028,134 @@ static void pet_connection_watchdog(bool in_connection, int srv_obj_inst)
 		k_timer_start(&connection_watchdog_reboot_timer,
 			      K_MINUTES(CONNECTION_WATCHDOG_REBOOT_TIMER_TIMEOUT_MINUTES),
 			      K_NO_WAIT);
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+		recovery_complete();
+#endif
 	} else {
-		timeout =
-			attr_get_uint32(ATTR_ID_dm_cnx_delay_max, CONNECTION_WATCHDOG_MAX_FALLBACK);
+		timeout = gwto.cfg.cnx_delay_max;
 		timeout *= CONNECTION_WATCHDOG_TIMEOUT_MULTIPLIER;
 	}
 	LOG_DBG("Connection watchdog set to %d seconds", timeout);
-	k_timer_start(&connection_watchdog_timer, K_SECONDS(timeout), K_NO_WAIT);
+	lcz_ble_gw_dm_timer_start(&connection_watchdog_timer, timeout * MSEC_PER_SEC, 0);
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+static void psm_radio_set(bool on)
+{
+	k_spinlock_key_t key = k_spin_lock(&psm.lock);
+	int64_t now = k_uptime_get();
+	bool changed = false;
+
+	if (on && psm.radio_on_start == 0) {
+		psm.radio_on_start = now;
+		psm.wakes++;
+	} else if (!on && psm.radio_on_start != 0) {
+		psm.radio_on_ms += now - psm.radio_on_start;
+		psm.radio_on_start = 0;
+		changed = true;
+	}
+	k_spin_unlock(&psm.lock, key);
+
+	if (changed) {
+		MFLT_METRICS_SET_UNSIGNED(lwm2m_dm_radio_on_s_day,
+					  lcz_ble_gw_dm_psm_radio_on_per_day());
+	}
+}
+
+/* Runs in the LwM2M engine context */
+static void psm_lwm2m_event(enum lwm2m_rd_client_event client_event, int srv_obj_inst)
+{
+	char obj_path[LWM2M_MAX_PATH_STR_LEN];
+	uint32_t lifetime = 0;
+	k_spinlock_key_t key;
+
+	switch (client_event) {
+	case LWM2M_RD_CLIENT_EVENT_REGISTRATION_COMPLETE:
+	case LWM2M_RD_CLIENT_EVENT_REG_UPDATE_COMPLETE:
+		snprintk(obj_path, sizeof(obj_path), "1/%d/1", srv_obj_inst);
+		(void)lwm2m_engine_get_u32(obj_path, &lifetime);
+		key = k_spin_lock(&psm.lock);
+		psm.last_update = k_uptime_get();
+		psm.lifetime = lifetime;
+		k_spin_unlock(&psm.lock, key);
+		__fallthrough;
+	case LWM2M_RD_CLIENT_EVENT_REG_UPDATE:
+		/* The modem sleep state is used instead when it is available */
+		if (!IS_ENABLED(CONFIG_MODEM_HL7800)) {
+			psm_radio_set(true);
+		}
+		break;
+	case LWM2M_RD_CLIENT_EVENT_QUEUE_MODE_RX_OFF:
+	case LWM2M_RD_CLIENT_EVENT_DISCONNECT:
+		if (!IS_ENABLED(CONFIG_MODEM_HL7800)) {
+			psm_radio_set(false);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* When the modem wakes up for another reason (network timers, a paging message or data) and
+ * the registration update is due soon, send it now instead of waking the modem again. The
+ * update also flushes notifications queued while the client was in queue mode.
+ */
+static void psm_align_update(void)
+{
+	k_spinlock_key_t key;
+	uint32_t lifetime;
+	int64_t due;
+
+	if (!atomic_cas(&psm.wake_pending, 1, 0) || !gwto.lwm2m_connected) {
+		return;
+	}
+
+	key = k_spin_lock(&psm.lock);
+	lifetime = psm.lifetime;
+	due = psm.last_update + ((int64_t)lifetime * MSEC_PER_SEC);
+	k_spin_unlock(&psm.lock, key);
+
+	if (lifetime != 0 &&
+	    (due - k_uptime_get()) <= (CONFIG_LCZ_BLE_GW_DM_PSM_UPDATE_WINDOW * MSEC_PER_SEC)) {
+		LOG_DBG("Sending registration update during modem wake");
+		reg_update_request();
+		key = k_spin_lock(&psm.lock);
+		psm.aligned_updates++;
+		/* Don't send another one if the modem wakes again before the update completes */
+		psm.last_update = k_uptime_get();
+		k_spin_unlock(&psm.lock, key);
+	}
+}
+
+#if defined(CONFIG_MODEM_HL7800)
+static void modem_event_callback(enum mdm_hl7800_event event, void *event_data)
+{
+	uint8_t sleep_state;
+
+	if (event != HL7800_EVENT_SLEEP_STATE_CHANGE) {
+		return;
+	}
+
+	sleep_state = *((uint8_t *)event_data);
+	if (sleep_state == HL7800_SLEEP_AWAKE) {
+		psm_radio_set(true);
+		atomic_set(&psm.wake_pending, 1);
+		gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_MODEM_WAKE);
+	} else {
+		psm_radio_set(false);
+	}
 }
+#endif
+#endif /* CONFIG_LCZ_BLE_GW_DM_PSM */
 
 static void *current_time_read_cb(uint16_t obj_inst_id, uint16_t res_id, uint16_t res_inst_id,
 				  size_t *data_len)
 {
-	struct timespec tp;
-
 	ARG_UNUSED(obj_inst_id);
 	ARG_UNUSED(res_id);
 	ARG_UNUSED(res_inst_id);
 
-	clock_gettime(CLOCK_REALTIME, &tp);
-	gwto.time = gwto.time_offset + tp.tv_sec;
+	gwto.time = lcz_ble_gw_dm_time_get();
 	*data_len = 4;
 	LOG_DBG("Device time: %d", gwto.time);
 
@@ -827,12 +2177,8 @@ static int current_time_post_write_cb(uint16_t obj_inst_id, uint16_t res_id, uin
 				      uint8_t *data, uint16_t data_len, bool last_block,
 				      size_t total_size)
 {
-	struct timespec tp;
-
 	if (data_len == 4U) {
-		clock_gettime(CLOCK_REALTIME, &tp);
-
-		gwto.time_offset = *(int32_t *)data - (int32_t)(tp.tv_sec);
+		lcz_ble_gw_dm_time_set(*(int32_t *)data);
 		return 0;
 	}
 
@@ -848,6 +2194,9 @@ static int factory_default_callback(uint16_t obj_inst_id, uint8_t *args, uint16_
 	ARG_UNUSED(args);
 	ARG_UNUSED(args_len);
 
+#if defined(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M)
+	lwm2m_telemetry_invalidate();
+#endif
 #if defined(CONFIG_ATTR)
 	ret = attr_load((const char *)attr_get_quasi_static(ATTR_ID_factory_load_path), NULL);
 	if (ret < 0) {
@@ -869,12 +2218,13 @@ static void ble_gw_dm_thread(void *arg1, void *arg2, void *arg3)
 	gwto.msgTask.rxer.rxBlockTicks = K_FOREVER;
 	gwto.msgTask.rxer.pMsgDispatcher = gw_dm_task_msg_dispatcher;
 	gwto.msgTask.rxer.pQueue = &gw_dm_task_queue;
-	gwto.msgTask.rxer.acceptBroadcast = attribute_changed_filter;
-	gwto.msgTask.timerDurationTicks = K_SECONDS(1);
-	gwto.msgTask.timerPeriodTicks = K_MSEC(0);
+	gwto.msgTask.rxer.acceptBroadcast = broadcast_filter;
 	gwto.cnx_tries = 0;
+	lcz_ble_gw_dm_backoff_init(&gwto.backoff, sys_rand32_get);
+	record_state_entry(gwto.state);
 	Framework_RegisterTask(&gwto.msgTask);
 
+#if defined(CONFIG_LCZ_BLE_GW_DM_LED_CONTROL)
 	/* clang-format off */
 #if defined(CONFIG_BOARD_MG100)
     struct lcz_led_configuration c[] = {
@@ -906,10 +2256,10 @@ static void ble_gw_dm_thread(void *arg1, void *arg2, void *arg3)
 #endif
 	/* clang-format on */
 	lcz_led_init(c, ARRAY_SIZE(c));
+#endif
 
-	k_timer_init(&connection_watchdog_timer, connection_watchdog_timer_callback, NULL);
-	k_timer_init(&connection_watchdog_reboot_timer, connection_watchdog_timer_callback, NULL);
-	k_timer_init(&network_search_timer, network_search_timer_callback, NULL);
+	k_timer_init(&connection_watchdog_reboot_timer, connection_watchdog_reboot_timer_callback,
+		     NULL);
 	/* Start the reboot watchdog to reboot the system if we never connect to the server. */
 	k_timer_start(&connection_watchdog_reboot_timer,
 		      K_MINUTES(CONNECTION_WATCHDOG_REBOOT_TIMER_TIMEOUT_MINUTES), K_NO_WAIT);
@@ -919,7 +2269,6 @@ static void ble_gw_dm_thread(void *arg1, void *arg2, void *arg3)
 	lcz_nm_register_event_callback(&event_agent);
 
 	set_state(GW_DM_STATE_WAIT_FOR_NETWORK);
-	gwto.timer = CONFIG_LCZ_BLE_GW_DM_WAIT_FOR_NETWORK_TIMEOUT;
 	gwto.dm_connection_timeout_seconds = CONFIG_LCZ_BLE_GW_DM_CONNECTION_TIMEOUT;
 
 #if defined(CONFIG_LCZ_BLE_GW_DM_INIT_KCONFIG)
@@ -927,18 +2276,25 @@ static void ble_gw_dm_thread(void *arg1, void *arg2, void *arg3)
 #else
 	/* generate random connect time if value is 0 */
 	random_connect_handler();
-	gwto.dm_connection_delay_seconds =
-		attr_get_uint32(ATTR_ID_dm_cnx_delay, DM_CONNECTION_DELAY_FALLBACK);
+#endif
+	config_refresh();
+#if !defined(CONFIG_LCZ_BLE_GW_DM_INIT_KCONFIG)
+	gwto.dm_connection_delay_seconds = gwto.cfg.cnx_delay;
 #endif
 
 	lwm2m_event_agent.connected_callback = lwm2m_client_connected_event;
 	(void)lcz_lwm2m_client_register_event_callback(&lwm2m_event_agent);
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM) && defined(CONFIG_MODEM_HL7800)
+	modem_event_agent.event_callback = modem_event_callback;
+	mdm_hl7800_register_event_callback(&modem_event_agent);
+#endif
 	lcz_lwm2m_client_register_get_time_callback(current_time_read_cb);
 	lcz_lwm2m_client_register_pre_write_set_time_callback(current_time_pre_write_cb);
 	lcz_lwm2m_client_register_post_write_set_time_callback(current_time_post_write_cb);
 	lcz_lwm2m_client_register_factory_default_callback(factory_default_callback);
 
-	Framework_StartTimer(&gwto.msgTask);
+	/* The FSM is event driven, start it once to check the network state */
+	gw_dm_fsm_kick(LCZ_BLE_GW_DM_TRACE_CAUSE_START);
 
 	while (true) {
 		Framework_MsgReceiver(&gwto.msgTask.rxer);
@@ -950,5 +2306,174 @@ static void ble_gw_dm_thread(void *arg1, void *arg2, void *arg3)
 /**************************************************************************************************/
 /* Global Function Definitions                                                                    */
 /**************************************************************************************************/
+int lcz_ble_gw_dm_state_count(void)
+{
+	return GW_DM_STATE__NUM;
+}
+
+const char *lcz_ble_gw_dm_state_name(int state)
+{
+	if (state < 0 || state >= GW_DM_STATE__NUM) {
+		return NULL;
+	}
+
+	return STATE_TABLE[state].name;
+}
+
+int lcz_ble_gw_dm_state_get(uint32_t *time_in_state_ms)
+{
+	if (time_in_state_ms != NULL) {
+		*time_in_state_ms = (uint32_t)(k_uptime_get() - gwto.state_entered);
+	}
+
+	return gwto.state;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_STATE_STATS)
+int lcz_ble_gw_dm_state_stats_get(int state, struct lcz_ble_gw_dm_state_stats *stats)
+{
+	k_spinlock_key_t key;
+
+	if (state < 0 || state >= GW_DM_STATE__NUM || stats == NULL) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&state_stats_lock);
+	*stats = gwto.state_stats[state];
+	k_spin_unlock(&state_stats_lock, key);
+
+	return 0;
+}
+
+void lcz_ble_gw_dm_state_stats_clear(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&state_stats_lock);
+
+	memset(gwto.state_stats, 0, sizeof(gwto.state_stats));
+	k_spin_unlock(&state_stats_lock, key);
+}
+#endif
+
 K_THREAD_DEFINE(ble_gw_dm, CONFIG_LCZ_BLE_GW_DM_THREAD_STACK_SIZE, ble_gw_dm_thread, NULL, NULL,
 		NULL, K_PRIO_PREEMPT(CONFIG_LCZ_BLE_GW_DM_THREAD_PRIORITY), 0, 0);
+
+void lcz_ble_gw_dm_queue_stats_get(struct lcz_ble_gw_dm_queue_stats *stats)
+{
+	stats->accepted = (uint32_t)atomic_get(&queue.accepted);
+	stats->coalesced = (uint32_t)atomic_get(&queue.coalesced);
+	stats->filtered = (uint32_t)atomic_get(&queue.filtered);
+	stats->dropped = (uint32_t)atomic_get(&queue.dropped);
+	stats->high_water = (uint32_t)atomic_get(&queue.high_water);
+	stats->used = k_msgq_num_used_get(&gw_dm_task_queue);
+	stats->depth = GW_DM_TASK_QUEUE_DEPTH;
+}
+
+void lcz_ble_gw_dm_queue_stats_clear(void)
+{
+	atomic_clear(&queue.accepted);
+	atomic_clear(&queue.coalesced);
+	atomic_clear(&queue.filtered);
+	atomic_clear(&queue.dropped);
+	atomic_clear(&queue.high_water);
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_DISPATCH_PROFILE)
+const char *lcz_ble_gw_dm_dispatch_msg_name(int msg)
+{
+	if (msg < 0 || msg >= LCZ_BLE_GW_DM_DISPATCH_MSG__NUM) {
+		return NULL;
+	}
+
+	return DISPATCH_MSG_NAMES[msg];
+}
+
+int lcz_ble_gw_dm_dispatch_stats_get(int msg, struct lcz_ble_gw_dm_dispatch_stats *stats)
+{
+	k_spinlock_key_t key;
+
+	if (msg < 0 || msg >= LCZ_BLE_GW_DM_DISPATCH_MSG__NUM) {
+		return -EINVAL;
+	}
+
+	key = k_spin_lock(&dispatch_lock);
+	*stats = dispatch_stats[msg];
+	k_spin_unlock(&dispatch_lock, key);
+	return 0;
+}
+
+void lcz_ble_gw_dm_dispatch_stats_clear(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&dispatch_lock);
+
+	memset(dispatch_stats, 0, sizeof(dispatch_stats));
+	dispatch_exec_max_us = 0;
+	dispatch_wait_max_us = 0;
+	k_spin_unlock(&dispatch_lock, key);
+}
+
+uint32_t lcz_ble_gw_dm_dispatch_percentile(const struct lcz_ble_gw_dm_dispatch_timing *timing,
+					   uint32_t count, uint32_t percent)
+{
+	/* Rank of the sample at the percentile, rounded up */
+	uint64_t rank = (((uint64_t)count * percent) + 99) / 100;
+	uint64_t seen = 0;
+	int b;
+
+	for (b = 0; b < LCZ_BLE_GW_DM_DISPATCH_HIST_BUCKETS - 1; b++) {
+		seen += timing->hist[b];
+		if (seen >= rank) {
+			return MIN(BIT(b + 1), timing->max_us);
+		}
+	}
+
+	return timing->max_us;
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_RECOVERY_LADDER)
+const char *lcz_ble_gw_dm_recovery_step_name(int step)
+{
+	if (step < 0 || step >= LCZ_BLE_GW_DM_RECOVERY_STEP__NUM) {
+		return NULL;
+	}
+
+	return RECOVERY_STEP_NAMES[step];
+}
+
+void lcz_ble_gw_dm_recovery_stats_get(struct lcz_ble_gw_dm_recovery_stats *stats)
+{
+	stats->step = (int)atomic_get(&recovery.step);
+	stats->last_recovery_ms = recovery.last_recovery_ms;
+	memcpy(stats->attempts, recovery.attempts, sizeof(stats->attempts));
+	memcpy(stats->recovered, recovery.recovered, sizeof(stats->recovered));
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_PSM)
+uint32_t lcz_ble_gw_dm_psm_radio_on_per_day(void)
+{
+	struct lcz_ble_gw_dm_psm_stats stats;
+
+	lcz_ble_gw_dm_psm_stats_get(&stats);
+	return stats.radio_on_per_day;
+}
+
+void lcz_ble_gw_dm_psm_stats_get(struct lcz_ble_gw_dm_psm_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&psm.lock);
+	int64_t now = k_uptime_get();
+	uint64_t on_ms = psm.radio_on_ms;
+
+	if (psm.radio_on_start != 0) {
+		on_ms += now - psm.radio_on_start;
+	}
+	stats->radio_on = (psm.radio_on_start != 0);
+	stats->radio_on_s = (uint32_t)(on_ms / MSEC_PER_SEC);
+	stats->radio_on_per_day =
+		(now > 0) ? (uint32_t)((on_ms * SEC_PER_MIN * MIN_PER_HOUR * HOUR_PER_DAY) / now) :
+			    0;
+	stats->wakes = psm.wakes;
+	stats->aligned_updates = psm.aligned_updates;
+	k_spin_unlock(&psm.lock, key);
+}
+#endif
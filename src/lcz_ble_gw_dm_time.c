@@ -0,0 +1,199 @@
+/**
+ * @file lcz_ble_gw_dm_time.c
+ * @brief Time service of the gateway device manager
+ *
+ * Each update is recorded against the uptime, which only depends on the local oscillator. The
+ * error of the clock is estimated as the accuracy of the last source plus the drift of the
+ * oscillator over the time since the update. The drift is measured between updates that are
+ * far enough apart for the accuracy of the sources not to dominate, and the larger of the
+ * measured and the configured drift is used.
+ *
+ * A write of the device time by the LwM2M server only offsets the time reported back to it. The
+ * system clock isn't set, so the write isn't an update and doesn't take part in the estimate.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lcz_ble_gw_dm_time, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/posix/time.h>
+#include <stdlib.h>
+
+#include "lcz_ble_gw_dm_time.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define PPM 1000000LL
+
+struct time_sync {
+	enum lcz_ble_gw_dm_time_source source;
+	int64_t uptime;
+	int64_t unix_time_ms;
+};
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static uint32_t drift_ppm_get(void);
+static uint32_t error_ms_get(int64_t now);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+/* Accuracy of the time obtained from each source */
+static const uint32_t SOURCE_ACCURACY_MS[LCZ_BLE_GW_DM_TIME_SOURCE__NUM] = {
+	[LCZ_BLE_GW_DM_TIME_SOURCE_MODEM] = 1000,
+	[LCZ_BLE_GW_DM_TIME_SOURCE_NTP] = 250,
+	[LCZ_BLE_GW_DM_TIME_SOURCE_EXTERNAL] = 1000,
+};
+
+static const char *const SOURCE_NAMES[LCZ_BLE_GW_DM_TIME_SOURCE__NUM] = {
+	[LCZ_BLE_GW_DM_TIME_SOURCE_NONE] = "None",
+	[LCZ_BLE_GW_DM_TIME_SOURCE_MODEM] = "Modem",
+	[LCZ_BLE_GW_DM_TIME_SOURCE_NTP] = "NTP",
+	[LCZ_BLE_GW_DM_TIME_SOURCE_EXTERNAL] = "External",
+};
+
+static struct k_spinlock lock;
+static struct time_sync last;
+static uint32_t measured_drift_ppm;
+static uint32_t updates;
+static uint32_t queries;
+static uint32_t queries_skipped;
+/* Offset of the LwM2M device time from the system time */
+static int32_t time_offset;
+static uint32_t lwm2m_writes;
+static int64_t lwm2m_write_uptime;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+/* Lock must be held */
+static uint32_t drift_ppm_get(void)
+{
+	return MAX(measured_drift_ppm, CONFIG_LCZ_BLE_GW_DM_TIME_DRIFT_PPM);
+}
+
+/* Lock must be held */
+static uint32_t error_ms_get(int64_t now)
+{
+	int64_t error;
+
+	if (last.source == LCZ_BLE_GW_DM_TIME_SOURCE_NONE) {
+		return UINT32_MAX;
+	}
+
+	error = SOURCE_ACCURACY_MS[last.source] + (((now - last.uptime) * drift_ppm_get()) / PPM);
+	return (uint32_t)MIN(error, UINT32_MAX);
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+void lcz_ble_gw_dm_time_update(enum lcz_ble_gw_dm_time_source source, int64_t unix_time_ms)
+{
+	k_spinlock_key_t key;
+	int64_t now;
+	int64_t elapsed;
+	int64_t offset;
+	uint32_t accuracy;
+
+	if (source <= LCZ_BLE_GW_DM_TIME_SOURCE_NONE || source >= LCZ_BLE_GW_DM_TIME_SOURCE__NUM) {
+		return;
+	}
+
+	key = k_spin_lock(&lock);
+	now = k_uptime_get();
+	if (last.source != LCZ_BLE_GW_DM_TIME_SOURCE_NONE) {
+		elapsed = now - last.uptime;
+		accuracy = SOURCE_ACCURACY_MS[last.source] + SOURCE_ACCURACY_MS[source];
+		/* Only measure when the source errors are small compared to the expected drift */
+		if (elapsed > 0 &&
+		    (elapsed * CONFIG_LCZ_BLE_GW_DM_TIME_DRIFT_PPM) >= (accuracy * PPM)) {
+			offset = unix_time_ms - (last.unix_time_ms + elapsed);
+			measured_drift_ppm = (uint32_t)((llabs(offset) * PPM) / elapsed);
+		}
+	}
+	last.source = source;
+	last.uptime = now;
+	last.unix_time_ms = unix_time_ms;
+	updates++;
+	k_spin_unlock(&lock, key);
+
+	LOG_DBG("Time from %s, drift %u ppm", SOURCE_NAMES[source], measured_drift_ppm);
+}
+
+bool lcz_ble_gw_dm_time_query_needed(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	bool needed = (error_ms_get(k_uptime_get()) > CONFIG_LCZ_BLE_GW_DM_TIME_MAX_ERROR);
+
+	if (needed) {
+		queries++;
+	} else {
+		queries_skipped++;
+	}
+	k_spin_unlock(&lock, key);
+
+	return needed;
+}
+
+int32_t lcz_ble_gw_dm_time_get(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_REALTIME, &tp);
+	return time_offset + (int32_t)tp.tv_sec;
+}
+
+void lcz_ble_gw_dm_time_set(int32_t unix_time)
+{
+	struct timespec tp;
+	k_spinlock_key_t key;
+
+	clock_gettime(CLOCK_REALTIME, &tp);
+
+	key = k_spin_lock(&lock);
+	time_offset = unix_time - (int32_t)tp.tv_sec;
+	lwm2m_writes++;
+	lwm2m_write_uptime = k_uptime_get();
+	k_spin_unlock(&lock, key);
+
+	LOG_DBG("LwM2M time offset %d s", time_offset);
+}
+
+const char *lcz_ble_gw_dm_time_source_name(enum lcz_ble_gw_dm_time_source source)
+{
+	if (source < 0 || source >= LCZ_BLE_GW_DM_TIME_SOURCE__NUM) {
+		return NULL;
+	}
+
+	return SOURCE_NAMES[source];
+}
+
+void lcz_ble_gw_dm_time_stats_get(struct lcz_ble_gw_dm_time_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	int64_t now = k_uptime_get();
+
+	stats->source = last.source;
+	stats->age_ms = (last.source == LCZ_BLE_GW_DM_TIME_SOURCE_NONE) ? -1 : (now - last.uptime);
+	stats->error_ms = error_ms_get(now);
+	stats->drift_ppm = drift_ppm_get();
+	stats->measured_drift_ppm = measured_drift_ppm;
+	stats->updates = updates;
+	stats->queries = queries;
+	stats->queries_skipped = queries_skipped;
+	stats->lwm2m_writes = lwm2m_writes;
+	stats->lwm2m_offset_s = time_offset;
+	stats->lwm2m_write_age_ms = (lwm2m_writes == 0) ? -1 : (now - lwm2m_write_uptime);
+	k_spin_unlock(&lock, key);
+}
@@ -0,0 +1,260 @@
+/**
+ * @file lcz_ble_gw_dm_timer.c
+ * @brief Timer service shared by the gateway device manager
+ *
+ * Running timers are kept in a list sorted by expiration tick. Stopping a timer and finding the
+ * next deadline are O(1), starting one walks the list, which only holds the few module timers.
+ * The work item is only scheduled for the earliest deadline, there is no periodic tick.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(lcz_ble_gw_dm_timer, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+
+#include "lcz_ble_gw_dm_timer.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define RESOLUTION_MS CONFIG_LCZ_BLE_GW_DM_TIMER_RESOLUTION_MS
+#define MSEC_PER_HOUR (MSEC_PER_SEC * SEC_PER_MIN * MIN_PER_HOUR)
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static int64_t ms_to_tick_ceil(int64_t ms);
+static void insert(struct lcz_ble_gw_dm_timer *timer, int64_t tick);
+static int64_t next_tick(void);
+static void reschedule(void);
+static void count_expiration(int64_t now);
+static void wheel_work_handler(struct k_work *work);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static sys_dlist_t active = SYS_DLIST_STATIC_INIT(&active);
+static sys_dlist_t expired = SYS_DLIST_STATIC_INIT(&expired);
+static sys_slist_t timers = SYS_SLIST_STATIC_INIT(&timers);
+static struct k_spinlock lock;
+static K_WORK_DELAYABLE_DEFINE(wheel_work, wheel_work_handler);
+
+/* Tick the work item is scheduled for, -1 if idle */
+static int64_t scheduled_tick = -1;
+
+static uint32_t expirations;
+static uint32_t wakeups;
+static uint32_t hour_expirations;
+static uint32_t last_hour_expirations;
+static int64_t hour_start;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static int64_t ms_to_tick_ceil(int64_t ms)
+{
+	return (ms + RESOLUTION_MS - 1) / RESOLUTION_MS;
+}
+
+/* Lock must be held. Timers with the same tick expire in the order they were started. */
+static void insert(struct lcz_ble_gw_dm_timer *timer, int64_t tick)
+{
+	struct lcz_ble_gw_dm_timer *t;
+
+	timer->expiry_tick = tick;
+	SYS_DLIST_FOR_EACH_CONTAINER (&active, t, node) {
+		if (t->expiry_tick > tick) {
+			sys_dlist_insert(&t->node, &timer->node);
+			return;
+		}
+	}
+	sys_dlist_append(&active, &timer->node);
+}
+
+/* Lock must be held. Returns -1 if no timer is running. */
+static int64_t next_tick(void)
+{
+	struct lcz_ble_gw_dm_timer *timer;
+
+	timer = SYS_DLIST_PEEK_HEAD_CONTAINER(&active, timer, node);
+	return (timer != NULL) ? timer->expiry_tick : -1;
+}
+
+/* Lock must be held */
+static void reschedule(void)
+{
+	int64_t next = next_tick();
+	int64_t delay;
+
+	if (next == scheduled_tick) {
+		return;
+	}
+
+	scheduled_tick = next;
+	if (next < 0) {
+		(void)k_work_cancel_delayable(&wheel_work);
+	} else {
+		delay = (next * RESOLUTION_MS) - k_uptime_get();
+		(void)k_work_reschedule(&wheel_work, K_MSEC(MAX(delay, 0)));
+	}
+}
+
+/* Lock must be held */
+static void count_expiration(int64_t now)
+{
+	if ((now - hour_start) >= MSEC_PER_HOUR) {
+		/* If more than an hour passed without an expiration the last hour was empty */
+		last_hour_expirations = ((now - hour_start) < (2 * MSEC_PER_HOUR)) ?
+						hour_expirations :
+						0;
+		hour_expirations = 0;
+		hour_start = now - ((now - hour_start) % MSEC_PER_HOUR);
+	}
+	hour_expirations++;
+	expirations++;
+}
+
+static void wheel_work_handler(struct k_work *work)
+{
+	struct lcz_ble_gw_dm_timer *timer;
+	struct lcz_ble_gw_dm_timer *tmp;
+	lcz_ble_gw_dm_timer_handler_t handler;
+	sys_dnode_t *node;
+	k_spinlock_key_t key;
+	int64_t now_ms;
+	int64_t now;
+
+	ARG_UNUSED(work);
+
+	key = k_spin_lock(&lock);
+	wakeups++;
+	scheduled_tick = -1;
+	now_ms = k_uptime_get();
+	now = now_ms / RESOLUTION_MS;
+
+	SYS_DLIST_FOR_EACH_CONTAINER_SAFE (&active, timer, tmp, node) {
+		if (timer->expiry_tick > now) {
+			break;
+		}
+		sys_dlist_remove(&timer->node);
+		sys_dlist_append(&expired, &timer->node);
+	}
+
+	/* Handlers run without the lock, so a handler (or another thread) may restart or stop
+	 * any timer, including one that is still on the expired list.
+	 */
+	while ((node = sys_dlist_get(&expired)) != NULL) {
+		timer = CONTAINER_OF(node, struct lcz_ble_gw_dm_timer, node);
+		if (timer->period_ticks != 0) {
+			insert(timer, timer->expiry_tick + timer->period_ticks);
+		}
+		timer->expirations++;
+		count_expiration(now_ms);
+		handler = timer->handler;
+		k_spin_unlock(&lock, key);
+
+		if (handler != NULL) {
+			handler(timer);
+		}
+
+		key = k_spin_lock(&lock);
+	}
+
+	reschedule();
+	k_spin_unlock(&lock, key);
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+void lcz_ble_gw_dm_timer_start(struct lcz_ble_gw_dm_timer *timer, uint32_t delay_ms,
+			       uint32_t period_ms)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (!timer->registered) {
+		timer->registered = true;
+		sys_slist_append(&timers, &timer->reg_node);
+	}
+
+	if (sys_dnode_is_linked(&timer->node)) {
+		sys_dlist_remove(&timer->node);
+	}
+
+	timer->period_ticks = (uint32_t)ms_to_tick_ceil(period_ms);
+	insert(timer, ms_to_tick_ceil(k_uptime_get() + delay_ms));
+	reschedule();
+
+	k_spin_unlock(&lock, key);
+}
+
+void lcz_ble_gw_dm_timer_stop(struct lcz_ble_gw_dm_timer *timer)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (sys_dnode_is_linked(&timer->node)) {
+		sys_dlist_remove(&timer->node);
+		reschedule();
+	}
+
+	k_spin_unlock(&lock, key);
+}
+
+bool lcz_ble_gw_dm_timer_is_pending(struct lcz_ble_gw_dm_timer *timer)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	bool pending = sys_dnode_is_linked(&timer->node);
+
+	k_spin_unlock(&lock, key);
+	return pending;
+}
+
+int64_t lcz_ble_gw_dm_timer_next_deadline(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	int64_t next = next_tick();
+
+	k_spin_unlock(&lock, key);
+	return (next < 0) ? -1 : (next * RESOLUTION_MS);
+}
+
+void lcz_ble_gw_dm_timer_stats_get(struct lcz_ble_gw_dm_timer_stats *stats)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	int64_t uptime = k_uptime_get();
+	int64_t next = next_tick();
+
+	stats->expirations = expirations;
+	stats->wakeups = wakeups;
+	stats->expirations_last_hour =
+		((uptime - hour_start) < (2 * MSEC_PER_HOUR)) ? last_hour_expirations : 0;
+	stats->expirations_per_hour =
+		(uptime > 0) ? (uint32_t)(((int64_t)expirations * MSEC_PER_HOUR) / uptime) : 0;
+	stats->next_deadline = (next < 0) ? -1 : (next * RESOLUTION_MS);
+
+	k_spin_unlock(&lock, key);
+}
+
+void lcz_ble_gw_dm_timer_foreach(lcz_ble_gw_dm_timer_foreach_cb_t cb, void *user_data)
+{
+	struct lcz_ble_gw_dm_timer *timer;
+	k_spinlock_key_t key;
+	int64_t remaining;
+
+	/* Timers are never removed from the registry so it can be walked without the lock */
+	SYS_SLIST_FOR_EACH_CONTAINER (&timers, timer, reg_node) {
+		key = k_spin_lock(&lock);
+		remaining = sys_dnode_is_linked(&timer->node) ?
+				    MAX((timer->expiry_tick * RESOLUTION_MS) - k_uptime_get(), 0) :
+				    -1;
+		k_spin_unlock(&lock, key);
+		cb(timer, remaining, user_data);
+	}
+}
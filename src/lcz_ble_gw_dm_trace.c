@@ -0,0 +1,174 @@
+/**
+ * @file lcz_ble_gw_dm_trace.c
+ * @brief Binary trace of the gateway state transitions
+ *
+ * Adding a record is a copy into a ring under a spinlock, nothing is formatted until the trace
+ * is dumped or printed.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <string.h>
+
+#include "lcz_ble_gw_dm_task.h"
+#include "lcz_ble_gw_dm_trace.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define TRACE_ENTRIES CONFIG_LCZ_BLE_GW_DM_TRACE_ENTRIES
+#define TRACE_MASK (TRACE_ENTRIES - 1)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(TRACE_ENTRIES), "Trace size must be a power of two");
+BUILD_ASSERT(sizeof(struct lcz_ble_gw_dm_trace_record) == 12, "Trace record layout changed");
+
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static size_t names_size(void);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static const char *const CAUSE_NAMES[LCZ_BLE_GW_DM_TRACE_CAUSE__NUM] = {
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_START] = "Start",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_RECOVERY] = "Recovery",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_NETWORK] = "Network",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_LWM2M] = "LwM2M",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_MODEM_WAKE] = "Modem wake",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_DEADLINE] = "Deadline",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_ATTR] = "Attribute",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_OBJ_CREATED] = "Object created",
+	[LCZ_BLE_GW_DM_TRACE_CAUSE_MEMFAULT] = "Memfault posted",
+};
+
+static struct k_spinlock lock;
+static struct lcz_ble_gw_dm_trace_record ring[TRACE_ENTRIES];
+/* Sequence number of the next record, also the write index */
+static uint32_t next_seq;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static size_t names_size(void)
+{
+	size_t size = 0;
+	int state;
+
+	for (state = 0; state < lcz_ble_gw_dm_state_count(); state++) {
+		size += strlen(lcz_ble_gw_dm_state_name(state)) + 1;
+	}
+
+	return size;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+void lcz_ble_gw_dm_trace_add(uint8_t from, uint8_t to, uint8_t cause, uint8_t lwm2m_event,
+			     uint16_t cnx_tries)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+	struct lcz_ble_gw_dm_trace_record *record = &ring[next_seq & TRACE_MASK];
+
+	record->timestamp_ms = k_uptime_get_32();
+	record->from = from;
+	record->to = to;
+	record->cause = cause;
+	record->lwm2m_event = lwm2m_event;
+	record->cnx_tries = cnx_tries;
+	record->seq = (uint16_t)next_seq;
+	next_seq++;
+
+	k_spin_unlock(&lock, key);
+}
+
+size_t lcz_ble_gw_dm_trace_dump_size(void)
+{
+	return sizeof(struct lcz_ble_gw_dm_trace_header) + names_size() +
+	       (MIN(next_seq, TRACE_ENTRIES) * sizeof(struct lcz_ble_gw_dm_trace_record));
+}
+
+int lcz_ble_gw_dm_trace_dump(uint8_t *buf, size_t size)
+{
+	struct lcz_ble_gw_dm_trace_header header;
+	k_spinlock_key_t key;
+	size_t offset;
+	size_t len;
+	uint32_t count;
+	uint32_t seq;
+	int state;
+
+	offset = sizeof(header) + names_size();
+	if (size < offset) {
+		return -ENOMEM;
+	}
+
+	for (state = 0, len = sizeof(header); state < lcz_ble_gw_dm_state_count(); state++) {
+		strcpy((char *)&buf[len], lcz_ble_gw_dm_state_name(state));
+		len += strlen(lcz_ble_gw_dm_state_name(state)) + 1;
+	}
+
+	key = k_spin_lock(&lock);
+	count = MIN(MIN(next_seq, TRACE_ENTRIES),
+		    (size - offset) / sizeof(struct lcz_ble_gw_dm_trace_record));
+	/* Keep the newest records if they don't all fit */
+	for (seq = next_seq - count; seq != next_seq; seq++) {
+		memcpy(&buf[offset], &ring[seq & TRACE_MASK], sizeof(ring[0]));
+		offset += sizeof(ring[0]);
+	}
+	header.next_seq = (uint16_t)next_seq;
+	k_spin_unlock(&lock, key);
+
+	header.magic = LCZ_BLE_GW_DM_TRACE_MAGIC;
+	header.version = LCZ_BLE_GW_DM_TRACE_VERSION;
+	header.record_size = sizeof(struct lcz_ble_gw_dm_trace_record);
+	header.state_count = (uint8_t)lcz_ble_gw_dm_state_count();
+	header.reserved = 0;
+	header.records = (uint16_t)count;
+	header.uptime_ms = k_uptime_get_32();
+	memcpy(buf, &header, sizeof(header));
+
+	return (int)offset;
+}
+
+void lcz_ble_gw_dm_trace_foreach(lcz_ble_gw_dm_trace_foreach_cb_t cb, void *user_data)
+{
+	struct lcz_ble_gw_dm_trace_record record;
+	k_spinlock_key_t key;
+	uint32_t end;
+	uint32_t seq;
+
+	key = k_spin_lock(&lock);
+	end = next_seq;
+	seq = end - MIN(end, TRACE_ENTRIES);
+	k_spin_unlock(&lock, key);
+
+	/* Copy each record under the lock, the callback may block */
+	for (; seq != end; seq++) {
+		key = k_spin_lock(&lock);
+		if ((next_seq - seq) > TRACE_ENTRIES) {
+			/* Overwritten since the walk started */
+			k_spin_unlock(&lock, key);
+			continue;
+		}
+		record = ring[seq & TRACE_MASK];
+		k_spin_unlock(&lock, key);
+		cb(&record, user_data);
+	}
+}
+
+const char *lcz_ble_gw_dm_trace_cause_name(uint8_t cause)
+{
+	if (cause >= LCZ_BLE_GW_DM_TRACE_CAUSE__NUM) {
+		return NULL;
+	}
+
+	return CAUSE_NAMES[cause];
+}
@@ -13,12 +13,48 @@ LOG_MODULE_REGISTER(lwm2m_telemetry, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 /* Includes                                                                                       */
 /**************************************************************************************************/
 #include <zephyr/zephyr.h>
+#include <zephyr/sys/crc.h>
 #include <lcz_lwm2m_client.h>
 
 #if defined(CONFIG_ATTR)
 #include <attr.h>
 #endif
 
+/**************************************************************************************************/
+/* Local Function Prototypes                                                                      */
+/**************************************************************************************************/
+static uint32_t fingerprint(const char *server_url, lcz_lwm2m_client_security_mode_t sec_mode,
+			    const char *psk_id, const uint8_t *psk, uint16_t short_server_id);
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+#if defined(CONFIG_LCZ_BLE_GW_DM_INIT_KCONFIG)
+static uint8_t psk_bin[CONFIG_LCZ_LWM2M_SECURITY_KEY_SIZE];
+static bool psk_converted;
+#endif
+
+/* Fingerprint of the configuration written to the client, valid if applied is set */
+static uint32_t applied_fingerprint;
+static atomic_t applied;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static uint32_t fingerprint(const char *server_url, lcz_lwm2m_client_security_mode_t sec_mode,
+			    const char *psk_id, const uint8_t *psk, uint16_t short_server_id)
+{
+	uint32_t crc;
+
+	crc = crc32_ieee((const uint8_t *)server_url, strlen(server_url) + 1);
+	crc = crc32_ieee_update(crc, (const uint8_t *)&sec_mode, sizeof(sec_mode));
+	if (sec_mode == LCZ_LWM2M_CLIENT_SECURITY_MODE_PSK) {
+		crc = crc32_ieee_update(crc, (const uint8_t *)psk_id, strlen(psk_id) + 1);
+		crc = crc32_ieee_update(crc, psk, CONFIG_LWM2M_SECURITY_KEY_SIZE);
+	}
+	return crc32_ieee_update(crc, (const uint8_t *)&short_server_id, sizeof(short_server_id));
+}
+
 /**************************************************************************************************/
 /* Global Function Definitions                                                                    */
 /**************************************************************************************************/
@@ -29,20 +65,22 @@ int lwm2m_telemetry_init(void)
 	lcz_lwm2m_client_security_mode_t sec_mode;
 	char *psk_id;
 	uint8_t *psk;
-#if defined(CONFIG_LCZ_BLE_GW_DM_INIT_KCONFIG)
-	uint8_t psk_bin[CONFIG_LCZ_LWM2M_SECURITY_KEY_SIZE];
-#endif
 	uint16_t short_server_id;
+	uint32_t config_fingerprint;
 
 #if defined(CONFIG_LCZ_BLE_GW_DM_INIT_KCONFIG)
 	server_url = CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_SERVER_URL;
 	sec_mode = (lcz_lwm2m_client_security_mode_t)CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_SECURITY_MODE;
 	psk_id = CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_PSK_ID;
-	ret = hex2bin(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_PSK,
-		      strlen(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_PSK), psk_bin, sizeof(psk_bin));
-	if (ret == 0 || ret != sizeof(psk_bin)) {
-		LOG_ERR("Could not convert PSK to binary");
-		goto exit;
+	if (!psk_converted) {
+		ret = hex2bin(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_PSK,
+			      strlen(CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_PSK), psk_bin,
+			      sizeof(psk_bin));
+		if (ret == 0 || ret != sizeof(psk_bin)) {
+			LOG_ERR("Could not convert PSK to binary");
+			goto exit;
+		}
+		psk_converted = true;
 	}
 	psk = psk_bin;
 #else
@@ -55,6 +93,22 @@ int lwm2m_telemetry_init(void)
 	psk = (uint8_t *)attr_get_quasi_static(ATTR_ID_lwm2m_telem_psk);
 #endif
 
+#if defined(CONFIG_LCZ_BLE_GW_DM_INIT_KCONFIG)
+	short_server_id = CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_SHORT_SERVER_ID;
+#else
+	ret = attr_get(ATTR_ID_lwm2m_telem_short_id, &short_server_id, sizeof(short_server_id));
+	if (ret < 0) {
+		goto exit;
+	}
+#endif
+
+	/* Some of the client settings are persisted, only write them when they change */
+	config_fingerprint = fingerprint(server_url, sec_mode, psk_id, psk, short_server_id);
+	if (atomic_get(&applied) && config_fingerprint == applied_fingerprint) {
+		return 0;
+	}
+	atomic_clear(&applied);
+
 	ret = lcz_lwm2m_client_set_server_url(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_SERVER_INST,
 					      server_url, strlen(server_url));
 	if (ret < 0) {
@@ -81,14 +135,6 @@ int lwm2m_telemetry_init(void)
 		}
 	}
 
-#if defined(CONFIG_LCZ_BLE_GW_DM_INIT_KCONFIG)
-	short_server_id = CONFIG_LCZ_BLE_GW_DM_TELEM_LWM2M_SHORT_SERVER_ID;
-#else
-	ret = attr_get(ATTR_ID_lwm2m_telem_short_id, &short_server_id, sizeof(short_server_id));
-	if (ret < 0) {
-		goto exit;
-	}
-#endif
 	ret = lcz_lwm2m_client_set_bootstrap(CONFIG_LCZ_BLE_GW_DM_TELEMETRY_INDEX,
 					     CONFIG_LCZ_BLE_GW_DM_TELEMETRY_SERVER_INST, false,
 					     short_server_id);
@@ -96,7 +142,14 @@ int lwm2m_telemetry_init(void)
 		goto exit;
 	}
 
+	applied_fingerprint = config_fingerprint;
+	atomic_set(&applied, 1);
 	LOG_DBG("LwM2M telemetry client initialized");
 exit:
 	return ret;
 }
+
+void lwm2m_telemetry_invalidate(void)
+{
+	atomic_clear(&applied);
+}
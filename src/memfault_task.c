@@ -21,34 +21,88 @@ LOG_MODULE_REGISTER(memfault_task, CONFIG_LCZ_BLE_GW_DM_LOG_LEVEL);
 #endif
 #include <lcz_memfault.h>
 #include <file_system_utilities.h>
+#include <zephyr/sys/slist.h>
+#include <memfault/core/data_packetizer.h>
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_HTTP_CHUNKS)
+#include <memfault/ports/zephyr/http.h>
+#endif
 
 #include "memfault_task.h"
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+#include "lcz_ble_gw_dm_chunk.h"
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE)
+#include "lcz_ble_gw_dm_mflt_store.h"
+#endif
 
 /**************************************************************************************************/
 /* Local Constant, Macro and Type Definitions                                                     */
 /**************************************************************************************************/
 #define MEMFAULT_DATA_FILE_PATH CONFIG_FSU_MOUNT_POINT "/" CONFIG_LCZ_BLE_GW_DM_MEMFAULT_FILE_NAME
 #define SEND_SYNC_TIMEOUT_MINUTES 10
+#define REPORT_PERIOD K_SECONDS(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_REPORT_PERIOD_SECONDS)
+
+/* A caller of the sync post waiting for an upload */
+struct post_waiter {
+	sys_snode_t node;
+	/* Upload that will include the caller's data */
+	uint32_t upload;
+	int result;
+	struct k_sem done;
+};
 
 /**************************************************************************************************/
 /* Local Data Definitions                                                                         */
 /**************************************************************************************************/
 static struct k_timer report_data_timer;
 static uint8_t chunk_buf[CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_BUF_SIZE];
-/* Semaphore for API thread safety */
-static K_SEM_DEFINE(send_lock_sem, 1, 1);
-/* Semaphore for data sent sync */
-static K_SEM_DEFINE(send_wait_sem, 0, 1);
-
-/**************************************************************************************************/
-/* Global Data Definitions                                                                        */
-/**************************************************************************************************/
-extern const k_tid_t memfault;
+/* Given for each request. Requests made during an upload merge into one follow-up upload. */
+static K_SEM_DEFINE(request_sem, 0, 1);
+static struct k_spinlock lock;
+static sys_slist_t waiters = SYS_SLIST_STATIC_INIT(&waiters);
+/* Callback of the pending async post and the upload it waits for */
+static lcz_ble_gw_dm_memfault_done_cb_t done_cb;
+static uint32_t done_cb_upload;
+/* Number of uploads started */
+static uint32_t uploads_started;
+/* Requests since the last upload started */
+static uint32_t requests_queued;
+static struct lcz_ble_gw_dm_memfault_stats stats;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+static struct k_timer drain_timer;
+static bool drain_requested;
+static bool link_was_ok;
+#endif
 
 /**************************************************************************************************/
 /* Local Function Prototypes                                                                      */
 /**************************************************************************************************/
 static void report_data_timer_expired(struct k_timer *timer_id);
+static uint32_t request_upload(void);
+static size_t chunk_size(void);
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_HTTP_CHUNKS)
+static int http_send_chunk(const void *buf, size_t len, void *user_data);
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+static int http_post_pipelined(void);
+static void held_chunks_discard(void);
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE)
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+static int store_send_chunk(const void *buf, size_t len, void *user_data);
+#endif
+#endif
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+static void drain_timer_expired(struct k_timer *timer_id);
+static bool drain_transport_ok(void);
+static bool link_ok(void);
+static uint32_t backlog_update(void);
+static void drain_batch(void);
+#endif
+static int post_or_publish(void);
+static int save_to_file(void);
+static int upload(void);
+static void complete_upload(uint32_t id, int result, uint32_t duration_ms);
 static bool save_data(void);
 static char *get_mflt_transport_str(enum memfault_transport type);
 
@@ -60,6 +114,335 @@ static void report_data_timer_expired(struct k_timer *timer_id)
 	(void)lcz_ble_gw_dm_memfault_post_data();
 }
 
+/* Lock must be held. Returns the upload that will include data available now.
+ * The caller gives the request semaphore after releasing the lock.
+ */
+static uint32_t request_upload(void)
+{
+	requests_queued++;
+	stats.requests++;
+	return uploads_started + 1;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE)
+/* Coredump chunks are stored separately so that they are evicted last */
+static int save_to_file(void)
+{
+	static const struct {
+		uint32_t sources;
+		enum lcz_ble_gw_dm_mflt_store_class cls;
+	} passes[] = {
+		{ kMfltDataSourceMask_Coredump, LCZ_BLE_GW_DM_MFLT_STORE_COREDUMP },
+		{ kMfltDataSourceMask_All, LCZ_BLE_GW_DM_MFLT_STORE_DATA },
+	};
+	size_t size = chunk_size();
+	size_t len = size;
+	int ret = 0;
+	int i;
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+	/* Chunks kept from a failed post go ahead of newer data */
+	ret = lcz_ble_gw_dm_chunk_held_send(store_send_chunk, NULL);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+	for (i = 0; i < ARRAY_SIZE(passes) && ret == 0; i++) {
+		memfault_packetizer_set_active_sources(passes[i].sources);
+		while (ret == 0 && memfault_packetizer_get_chunk(chunk_buf, &len)) {
+			ret = lcz_ble_gw_dm_mflt_store_append(passes[i].cls, chunk_buf, len);
+			len = size;
+		}
+	}
+
+	if (ret < 0) {
+		memfault_packetizer_abort();
+	}
+	memfault_packetizer_set_active_sources(kMfltDataSourceMask_All);
+	return ret;
+}
+#else
+static int save_to_file(void)
+{
+	size_t file_size;
+	bool has_coredump;
+	bool delete_file;
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+	held_chunks_discard();
+#endif
+	if (fsu_get_file_size_abs(MEMFAULT_DATA_FILE_PATH) >=
+	    CONFIG_LCZ_BLE_GW_DM_MEMFAULT_FILE_MAX_SIZE_BYTES) {
+		delete_file = true;
+	} else {
+		delete_file = false;
+	}
+	return lcz_memfault_save_data_to_file(MEMFAULT_DATA_FILE_PATH, chunk_buf, chunk_size(),
+					      delete_file, true, &file_size, &has_coredump);
+}
+#endif
+
+static int upload(void)
+{
+	bool save = save_data();
+	int ret;
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+	/* Keep the data in order while there is a backlog, it is drained after the save */
+	if (!save && stats.drain_backlog > 0 && drain_transport_ok()) {
+		save = true;
+		lcz_ble_gw_dm_memfault_drain();
+	}
+#endif
+
+	if (save) {
+		LOG_DBG("Saving Memfault data...");
+		ret = save_to_file();
+		if (ret == 0) {
+			LOG_DBG("Memfault data saved!");
+		}
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+		(void)backlog_update();
+#endif
+	} else {
+		ret = post_or_publish();
+	}
+
+	return ret;
+}
+
+/* Wake every sync caller the upload was for and run the async callback */
+static void complete_upload(uint32_t id, int result, uint32_t duration_ms)
+{
+	sys_slist_t done = SYS_SLIST_STATIC_INIT(&done);
+	lcz_ble_gw_dm_memfault_done_cb_t cb = NULL;
+	struct post_waiter *w;
+	sys_snode_t *node;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&lock);
+	/* Waiters are appended in upload order */
+	while ((w = SYS_SLIST_PEEK_HEAD_CONTAINER(&waiters, w, node)) != NULL &&
+	       (int32_t)(id - w->upload) >= 0) {
+		(void)sys_slist_get(&waiters);
+		w->result = result;
+		sys_slist_append(&done, &w->node);
+	}
+	if (done_cb != NULL && (int32_t)(id - done_cb_upload) >= 0) {
+		cb = done_cb;
+		done_cb = NULL;
+	}
+	stats.uploads++;
+	stats.last_result = result;
+	stats.last_ms = duration_ms;
+	stats.max_ms = MAX(stats.max_ms, duration_ms);
+	k_spin_unlock(&lock, key);
+
+	/* A waiter is on its caller's stack, don't touch it after giving the semaphore */
+	while ((node = sys_slist_get(&done)) != NULL) {
+		w = CONTAINER_OF(node, struct post_waiter, node);
+		k_sem_give(&w->done);
+	}
+	if (cb != NULL) {
+		cb(result);
+	}
+}
+
+/* Chunk size can be lowered at runtime, e.g. to fit the MTU of the link */
+static size_t chunk_size(void)
+{
+	size_t size = sizeof(chunk_buf);
+
+#if defined(ATTR_ID_memfault_chunk_size)
+	uint32_t attr_size = attr_get_uint32(ATTR_ID_memfault_chunk_size, 0);
+
+	if (attr_size != 0 && attr_size < size) {
+		size = attr_size;
+	}
+#endif
+	return size;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_HTTP_CHUNKS)
+static int http_send_chunk(const void *buf, size_t len, void *user_data)
+{
+	return memfault_zephyr_port_http_post_chunk((sMemfaultHttpContext *)user_data, (void *)buf,
+						    len);
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+static int http_post_pipelined(void)
+{
+	sMemfaultHttpContext ctx = { 0 };
+	int ret;
+
+	if (lcz_ble_gw_dm_chunk_held_count() == 0 && !memfault_packetizer_data_available()) {
+		return 0;
+	}
+
+	ret = memfault_zephyr_port_http_open_socket(&ctx);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* After an error the unsent chunks are kept and posted first next time, the packetizer
+	 * isn't aborted because it can't give back chunks it has already returned.
+	 */
+	ret = lcz_ble_gw_dm_chunk_stream(memfault_packetizer_get_chunk, http_send_chunk, &ctx,
+					 chunk_size());
+	memfault_zephyr_port_http_close_socket(&ctx);
+	return ret;
+}
+
+/* lcz_memfault reads the packetizer itself on the other paths, kept chunks can't go first */
+static void held_chunks_discard(void)
+{
+	int count = lcz_ble_gw_dm_chunk_held_discard();
+
+	if (count > 0) {
+		LOG_WRN("Dropped %d unsent Memfault chunks", count);
+		/* Start the interrupted message over */
+		memfault_packetizer_abort();
+	}
+}
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_STORE)
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+static int store_send_chunk(const void *buf, size_t len, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	return lcz_ble_gw_dm_mflt_store_append(LCZ_BLE_GW_DM_MFLT_STORE_DATA, buf, len);
+}
+#endif
+#endif
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+static void drain_timer_expired(struct k_timer *timer_id)
+{
+	lcz_ble_gw_dm_memfault_drain();
+}
+
+/* lcz_memfault has no per-chunk send for MQTT and CoAP, so only HTTP uploads drain the store.
+ * Same choice of transport as post_or_publish() after the first report.
+ */
+static bool drain_transport_ok(void)
+{
+	return !LCZ_MEMFAULT_MQTT_ENABLED() && !LCZ_MEMFAULT_COAP_ENABLED();
+}
+
+/* Stored data is only drained over a link that would post it */
+static bool link_ok(void)
+{
+	if (attr_get_uint32(ATTR_ID_memfault_transport, 0) == MEMFAULT_TRANSPORT_NONE ||
+	    !drain_transport_ok()) {
+		return false;
+	}
+#if defined(CONFIG_MODEM_HL7800) && defined(CONFIG_ATTR)
+	if (attr_get_uint32(ATTR_ID_lte_rat, 0) == MDM_RAT_CAT_NB1 ||
+	    attr_get_signed32(ATTR_ID_lte_rsrp, 0) < CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN_RSRP_MIN) {
+		return false;
+	}
+#endif
+	return true;
+}
+
+static uint32_t backlog_update(void)
+{
+	struct lcz_ble_gw_dm_mflt_store_stats store;
+	k_spinlock_key_t key;
+
+	lcz_ble_gw_dm_mflt_store_stats_get(&store);
+	key = k_spin_lock(&lock);
+	stats.drain_backlog = store.backlog;
+	k_spin_unlock(&lock, key);
+	MFLT_METRICS_SET_UNSIGNED(memfault_drain_backlog, store.backlog);
+	return store.backlog;
+}
+
+/* Upload stored chunks from the commit position until the batch size is reached. The position
+ * is committed after the batch, so a dropped link only resends the chunk that failed. Another
+ * batch is requested if data remains, which lets live uploads run in between.
+ */
+static void drain_batch(void)
+{
+	struct lcz_ble_gw_dm_mflt_store_pos pos;
+	struct lcz_ble_gw_dm_mflt_store_pos next;
+	sMemfaultHttpContext ctx = { 0 };
+	k_spinlock_key_t key;
+	uint32_t bytes = 0;
+	uint32_t duration;
+	uint32_t rate;
+	int64_t start;
+	size_t len;
+	bool more = false;
+	int ret;
+
+	if (!link_ok()) {
+		LOG_DBG("Link not suitable for drain");
+		return;
+	}
+
+	lcz_ble_gw_dm_mflt_store_committed(&pos);
+	next = pos;
+	ret = lcz_ble_gw_dm_mflt_store_read(&next, chunk_buf, sizeof(chunk_buf), &len);
+	if (ret < 0) {
+		if (ret != -ENODATA) {
+			/* A chunk larger than the buffer stays until it is evicted */
+			LOG_ERR("Unable to read stored data: %d", ret);
+		}
+		(void)backlog_update();
+		return;
+	}
+
+	start = k_uptime_get();
+	ret = memfault_zephyr_port_http_open_socket(&ctx);
+	if (ret == 0) {
+		while (ret == 0) {
+			ret = http_send_chunk(chunk_buf, len, &ctx);
+			if (ret < 0) {
+				break;
+			}
+			pos = next;
+			bytes += len;
+			if (bytes >= CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN_BATCH_BYTES) {
+				more = true;
+				break;
+			}
+			ret = lcz_ble_gw_dm_mflt_store_read(&next, chunk_buf, sizeof(chunk_buf),
+							    &len);
+		}
+		memfault_zephyr_port_http_close_socket(&ctx);
+	}
+	duration = (uint32_t)k_uptime_delta(&start);
+	if (ret < 0 && ret != -ENODATA) {
+		LOG_WRN("Drain stopped after %u bytes: %d", bytes, ret);
+	}
+
+	if (bytes > 0) {
+		ret = lcz_ble_gw_dm_mflt_store_commit(&pos);
+		if (ret < 0) {
+			LOG_ERR("Unable to save drain position: %d", ret);
+		}
+	}
+
+	rate = (duration > 0) ? (uint32_t)(((uint64_t)bytes * MSEC_PER_SEC) / duration) : bytes;
+	key = k_spin_lock(&lock);
+	stats.drain_batches++;
+	stats.drain_bytes += bytes;
+	stats.drain_bytes_per_s = rate;
+	k_spin_unlock(&lock, key);
+	MFLT_METRICS_ADD(memfault_drain_bytes, bytes);
+	MFLT_METRICS_SET_UNSIGNED(memfault_drain_bytes_per_s, rate);
+
+	if (backlog_update() > 0 && more) {
+		lcz_ble_gw_dm_memfault_drain();
+	}
+}
+#endif
+
 static int post_or_publish(void)
 {
 	/* Always use HTTP for the first report. */
@@ -71,12 +454,21 @@ static int post_or_publish(void)
 	if(transport_attr != MEMFAULT_TRANSPORT_NONE) {
 		LOG_DBG("Posting Memfault data...");
 
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+		if (mflt_transport != MEMFAULT_TRANSPORT_HTTP) {
+			held_chunks_discard();
+		}
+#endif
 		if (mflt_transport == MEMFAULT_TRANSPORT_MQTT) {
-			ret = LCZ_MEMFAULT_PUBLISH_DATA(chunk_buf, sizeof(chunk_buf), K_FOREVER);
+			ret = LCZ_MEMFAULT_PUBLISH_DATA(chunk_buf, chunk_size(), K_FOREVER);
 		} else if (mflt_transport == MEMFAULT_TRANSPORT_COAP) {
-			ret = LCZ_MEMFAULT_COAP_PUBLISH_DATA(chunk_buf, sizeof(chunk_buf), K_FOREVER);
+			ret = LCZ_MEMFAULT_COAP_PUBLISH_DATA(chunk_buf, chunk_size(), K_FOREVER);
 		} else {
-			ret = LCZ_MEMFAULT_POST_DATA_V2(chunk_buf, sizeof(chunk_buf));
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_CHUNK_PIPELINE)
+			ret = http_post_pipelined();
+#else
+			ret = LCZ_MEMFAULT_POST_DATA_V2(chunk_buf, chunk_size());
+#endif
 		}
 
 		LOG_DBG("Memfault data sent (%s): %d", get_mflt_transport_str(mflt_transport), ret);
@@ -121,9 +513,15 @@ static bool save_data(void)
 static void memfault_thread(void *arg1, void *arg2, void *arg3)
 {
 	char *dev_id;
-	size_t file_size;
-	bool has_coredump;
-	bool delete_file;
+	k_spinlock_key_t key;
+	uint32_t duration;
+	uint32_t queued;
+	uint32_t merged;
+	uint32_t id;
+	int64_t start;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+	bool drain;
+#endif
 	int ret;
 
 	ARG_UNUSED(arg1);
@@ -137,37 +535,53 @@ static void memfault_thread(void *arg1, void *arg2, void *arg3)
 	LCZ_MEMFAULT_HTTP_INIT();
 	k_timer_init(&report_data_timer, report_data_timer_expired, NULL);
 
-	k_timer_start(&report_data_timer,
-		      K_SECONDS(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_REPORT_PERIOD_SECONDS),
-		      K_SECONDS(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_REPORT_PERIOD_SECONDS));
+	k_timer_start(&report_data_timer, REPORT_PERIOD, REPORT_PERIOD);
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+	link_was_ok = link_ok();
+	(void)backlog_update();
+	k_timer_init(&drain_timer, drain_timer_expired, NULL);
+	if (CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN_PERIOD_SECONDS > 0) {
+		k_timer_start(&drain_timer,
+			      K_SECONDS(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN_PERIOD_SECONDS),
+			      K_SECONDS(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN_PERIOD_SECONDS));
+	}
+#endif
 
 	while (true) {
-		k_thread_suspend(memfault);
-
-		if (save_data()) {
-			LOG_DBG("Saving Memfault data...");
-			if (fsu_get_file_size_abs(MEMFAULT_DATA_FILE_PATH) >=
-			    CONFIG_LCZ_BLE_GW_DM_MEMFAULT_FILE_MAX_SIZE_BYTES) {
-				delete_file = true;
-			} else {
-				delete_file = false;
-			}
-			ret = lcz_memfault_save_data_to_file(MEMFAULT_DATA_FILE_PATH, chunk_buf,
-							     sizeof(chunk_buf), delete_file, true,
-							     &file_size, &has_coredump);
-			if (ret == 0) {
-				LOG_DBG("Memfault data saved!");
-			}
-		} else {
-			post_or_publish();
+		k_sem_take(&request_sem, K_FOREVER);
+
+		key = k_spin_lock(&lock);
+		queued = requests_queued;
+		requests_queued = 0;
+		id = (queued > 0) ? ++uploads_started : 0;
+		merged = (queued > 1) ? (queued - 1) : 0;
+		stats.merged += merged;
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+		drain = drain_requested;
+		drain_requested = false;
+#endif
+		k_spin_unlock(&lock, key);
+		if (merged > 0) {
+			MFLT_METRICS_ADD(memfault_requests_merged, merged);
 		}
 
-		k_sem_give(&send_wait_sem);
+		if (queued > 0) {
+			start = k_uptime_get();
+			ret = upload();
+			duration = (uint32_t)k_uptime_delta(&start);
+			complete_upload(id, ret, duration);
+			MFLT_METRICS_SET_UNSIGNED(memfault_upload_ms, duration);
+
+			/* Reset timer each time data is sent */
+			k_timer_start(&report_data_timer, REPORT_PERIOD, REPORT_PERIOD);
+		}
 
-		/* Reset timer each time data is sent */
-		k_timer_start(&report_data_timer,
-			      K_SECONDS(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_REPORT_PERIOD_SECONDS),
-			      K_SECONDS(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_REPORT_PERIOD_SECONDS));
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+		if (drain) {
+			drain_batch();
+		}
+#endif
 	}
 }
 
@@ -192,21 +606,99 @@ static char * get_mflt_transport_str(enum memfault_transport type)
 /**************************************************************************************************/
 int lcz_ble_gw_dm_memfault_post_data(void)
 {
-	k_thread_resume(memfault);
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	(void)request_upload();
+	k_spin_unlock(&lock, key);
+	k_sem_give(&request_sem);
 	return 0;
 }
 
 int lcz_ble_gw_dm_memfault_post_data_sync(void)
 {
+	struct post_waiter w;
+	int64_t start = k_uptime_get();
+	k_spinlock_key_t key;
 	int ret;
 
-	k_sem_take(&send_lock_sem, K_FOREVER);
-	k_sem_reset(&send_wait_sem);
-	k_thread_resume(memfault);
-	ret = k_sem_take(&send_wait_sem, K_MINUTES(SEND_SYNC_TIMEOUT_MINUTES));
-	k_sem_give(&send_lock_sem);
+	k_sem_init(&w.done, 0, 1);
+	key = k_spin_lock(&lock);
+	w.upload = request_upload();
+	sys_slist_append(&waiters, &w.node);
+	k_spin_unlock(&lock, key);
+	k_sem_give(&request_sem);
+
+	ret = k_sem_take(&w.done, K_MINUTES(SEND_SYNC_TIMEOUT_MINUTES));
+	if (ret < 0) {
+		key = k_spin_lock(&lock);
+		if (!sys_slist_find_and_remove(&waiters, &w.node)) {
+			/* Completed while timing out, the semaphore is about to be given */
+			ret = 0;
+		}
+		k_spin_unlock(&lock, key);
+		if (ret == 0) {
+			k_sem_take(&w.done, K_FOREVER);
+		}
+	}
+	if (ret == 0) {
+		ret = w.result;
+	}
+
+	MFLT_METRICS_ADD(memfault_post_sync_ms, (int32_t)k_uptime_delta(&start));
 	return ret;
 }
 
+int lcz_ble_gw_dm_memfault_post_data_async(lcz_ble_gw_dm_memfault_done_cb_t done)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	if (done_cb != NULL) {
+		k_spin_unlock(&lock, key);
+		return -EBUSY;
+	}
+	done_cb = done;
+	done_cb_upload = request_upload();
+	k_spin_unlock(&lock, key);
+	k_sem_give(&request_sem);
+	return 0;
+}
+
+#if defined(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_DRAIN)
+void lcz_ble_gw_dm_memfault_drain(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	drain_requested = true;
+	k_spin_unlock(&lock, key);
+	k_sem_give(&request_sem);
+}
+
+void lcz_ble_gw_dm_memfault_link_changed(void)
+{
+	bool ok = link_ok();
+	bool improved;
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&lock);
+	improved = ok && !link_was_ok;
+	link_was_ok = ok;
+	k_spin_unlock(&lock, key);
+
+	if (improved) {
+		LOG_DBG("Link improved, draining stored data");
+		lcz_ble_gw_dm_memfault_drain();
+	}
+}
+#endif
+
+void lcz_ble_gw_dm_memfault_stats_get(struct lcz_ble_gw_dm_memfault_stats *s)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	*s = stats;
+	s->queued = requests_queued;
+	k_spin_unlock(&lock, key);
+}
+
 K_THREAD_DEFINE(memfault, CONFIG_LCZ_BLE_GW_DM_MEMFAULT_THREAD_STACK_SIZE, memfault_thread, NULL,
 		NULL, NULL, K_PRIO_PREEMPT(CONFIG_LCZ_BLE_GW_DM_MEMFAULT_THREAD_PRIORITY), 0, 0);
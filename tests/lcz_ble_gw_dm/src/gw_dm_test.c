@@ -0,0 +1,173 @@
+/**
+ * @file gw_dm_test.c
+ * @brief Helpers shared by the gateway DM test suites
+ *
+ * The test thread is cooperative and the gateway task is preemptible, so the task only runs
+ * while a test sleeps. Simulated time doesn't pass while code runs.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/ztest.h>
+
+#include "lcz_ble_gw_dm_task.h"
+#include "gw_dm_stubs.h"
+#include "gw_dm_test.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define POLL_MS 100
+#define SETTLE_MS 10
+
+/* Longest wait for a connect call, covers a pending recovery step from the idle stay state */
+#define CONNECT_TIMEOUT_S 900
+
+struct trace_copy {
+	uint16_t mark;
+	struct lcz_ble_gw_dm_trace_record *records;
+	size_t max;
+	size_t count;
+};
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void trace_last_cb(const struct lcz_ble_gw_dm_trace_record *record, void *user_data)
+{
+	*(uint16_t *)user_data = record->seq + 1;
+}
+
+static void trace_copy_cb(const struct lcz_ble_gw_dm_trace_record *record, void *user_data)
+{
+	struct trace_copy *copy = user_data;
+
+	/* The sequence number wraps */
+	if ((int16_t)(record->seq - copy->mark) >= 0 && copy->count < copy->max) {
+		copy->records[copy->count++] = *record;
+	}
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int gw_dm_test_state(const char *name)
+{
+	int i;
+
+	for (i = 0; i < lcz_ble_gw_dm_state_count(); i++) {
+		if (strcmp(lcz_ble_gw_dm_state_name(i), name) == 0) {
+			return i;
+		}
+	}
+
+	zassert_unreachable("Unknown state %s", name);
+	return -1;
+}
+
+bool gw_dm_test_in_state(const char *name)
+{
+	return lcz_ble_gw_dm_state_get(NULL) == gw_dm_test_state(name);
+}
+
+bool gw_dm_test_wait_for_state(const char *name, uint32_t timeout_s)
+{
+	int64_t end = k_uptime_get() + (timeout_s * MSEC_PER_SEC);
+	int state = gw_dm_test_state(name);
+
+	while (lcz_ble_gw_dm_state_get(NULL) != state) {
+		if (k_uptime_get() >= end) {
+			return false;
+		}
+		k_sleep(K_MSEC(POLL_MS));
+	}
+
+	return true;
+}
+
+void gw_dm_test_settle(void)
+{
+	k_sleep(K_MSEC(SETTLE_MS));
+}
+
+void gw_dm_test_connect(void)
+{
+	nm_stub_set(true);
+	zassert_true(gw_dm_test_wait_for_state(STATE_WAIT_FOR_CONNECTION, CONNECT_TIMEOUT_S),
+		     "No connect call, state %s",
+		     lcz_ble_gw_dm_state_name(lcz_ble_gw_dm_state_get(NULL)));
+
+	lwm2m_stub_event(DM_CLIENT, true, LWM2M_RD_CLIENT_EVENT_REGISTRATION_COMPLETE);
+	gw_dm_test_settle();
+	zassert_true(gw_dm_test_in_state(STATE_IDLE), "Not idle after registration");
+}
+
+uint16_t gw_dm_test_trace_mark(void)
+{
+	uint16_t mark = 0;
+
+	lcz_ble_gw_dm_trace_foreach(trace_last_cb, &mark);
+	return mark;
+}
+
+size_t gw_dm_test_trace_get(uint16_t mark, struct lcz_ble_gw_dm_trace_record *records,
+			    size_t max)
+{
+	struct trace_copy copy = { .mark = mark, .records = records, .max = max };
+
+	lcz_ble_gw_dm_trace_foreach(trace_copy_cb, &copy);
+	return copy.count;
+}
+
+bool gw_dm_test_trace_has(uint16_t mark, const char *from, const char *to)
+{
+	struct lcz_ble_gw_dm_trace_record records[TRACE_RECORDS_MAX];
+	int from_state = gw_dm_test_state(from);
+	int to_state = gw_dm_test_state(to);
+	size_t count;
+	size_t i;
+
+	count = gw_dm_test_trace_get(mark, records, ARRAY_SIZE(records));
+	for (i = 0; i < count; i++) {
+		if (records[i].from == from_state && records[i].to == to_state) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void gw_dm_test_reset(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	lwm2m_stub_connect_result_set(0);
+	memfault_stub_post_result_set(0);
+	fwk_stub_send_fail(0);
+	attr_stub_reset();
+	gw_dm_test_settle();
+
+	if (gw_dm_test_in_state(STATE_IDLE)) {
+		/* Pet both connection watchdogs */
+		lwm2m_stub_event(DM_CLIENT, true, LWM2M_RD_CLIENT_EVENT_REG_UPDATE_COMPLETE);
+	} else {
+		gw_dm_test_connect();
+	}
+
+	nm_stub_set(false);
+	gw_dm_test_settle();
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_NETWORK), "Not waiting for network");
+	zassert_false(lwm2m_stub_connected(DM_CLIENT), "Still connected");
+
+	/* Let the Memfault upload of the connection finish */
+	k_sleep(K_SECONDS(1));
+	fwk_stub_stats_clear();
+	lwm2m_stub_stats_clear();
+	lcz_ble_gw_dm_queue_stats_clear();
+}
@@ -0,0 +1,126 @@
+/**
+ * @file gw_dm_test.h
+ * @brief Helpers shared by the gateway DM test suites
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __GW_DM_TEST_H__
+#define __GW_DM_TEST_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <lcz_ble_gw_dm_trace.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+#define STATE_WAIT_FOR_NETWORK "Wait for network"
+#define STATE_GET_NETWORK_TIME "Get network time"
+#define STATE_POST_MEMFAULT "Post Memfault data"
+#define STATE_WAIT_BEFORE_DM "Delay before DM connection"
+#define STATE_CONNECT_TO_DM "Connect to DM"
+#define STATE_WAIT_FOR_CONNECTION "Wait for connection"
+#define STATE_IDLE "Idle"
+#define STATE_IDLE_STAY "Idle Stay"
+#define STATE_DISCONNECT_DM "Disconnect DM"
+
+/* Must match the DM client index of the task */
+#define DM_CLIENT CONFIG_LCZ_BLE_GW_DM_CLIENT_INDEX
+
+/* Retries plus backoff retries of the attribute defaults */
+#define CONNECT_ATTEMPTS_BEFORE_IDLE_STAY 5
+
+/* A disconnect arms the connection watchdog for twice dm_cnx_delay_max. A test that stays
+ * disconnected for longer runs the recovery ladder.
+ */
+#define DISCONNECTED_WATCHDOG_SECONDS 600
+
+#define TRACE_RECORDS_MAX CONFIG_LCZ_BLE_GW_DM_TRACE_ENTRIES
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/**
+ * @brief Get the index of a state
+ *
+ * @param name state name
+ * @return state index, fails the test if the state doesn't exist
+ */
+int gw_dm_test_state(const char *name);
+
+/**
+ * @brief Check the current state
+ *
+ * @param name state name
+ * @return true if the task is in the state
+ */
+bool gw_dm_test_in_state(const char *name);
+
+/**
+ * @brief Sleep in 100 ms steps until the task enters a state
+ *
+ * @param name state name
+ * @param timeout_s simulated seconds to wait
+ * @return true if the state was reached
+ */
+bool gw_dm_test_wait_for_state(const char *name, uint32_t timeout_s);
+
+/**
+ * @brief Let the task handle its queued messages
+ */
+void gw_dm_test_settle(void);
+
+/**
+ * @brief Connect to the DM server from any state that leads to a connection
+ *
+ * Brings the network up, waits for the connect call and reports the registration.
+ */
+void gw_dm_test_connect(void);
+
+/**
+ * @brief Get the sequence number the next trace record will use
+ */
+uint16_t gw_dm_test_trace_mark(void);
+
+/**
+ * @brief Copy the trace records added since a mark
+ *
+ * @param mark value returned by gw_dm_test_trace_mark()
+ * @param records destination, oldest first
+ * @param max size of records
+ * @return number of records copied
+ */
+size_t gw_dm_test_trace_get(uint16_t mark, struct lcz_ble_gw_dm_trace_record *records,
+			    size_t max);
+
+/**
+ * @brief Check for a transition in the trace records added since a mark
+ *
+ * @param mark value returned by gw_dm_test_trace_mark()
+ * @param from state name
+ * @param to state name
+ * @return true if the transition was traced
+ */
+bool gw_dm_test_trace_has(uint16_t mark, const char *from, const char *to);
+
+/**
+ * @brief Test fixture that puts the task in the wait for network state with the network down
+ *
+ * The connection is made again first so that the connection watchdogs and the recovery ladder
+ * start over. Stub results, attributes and stub counters are reset.
+ */
+void gw_dm_test_reset(void *fixture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GW_DM_TEST_H__ */
@@ -0,0 +1,267 @@
+/**
+ * @file test_bench.c
+ * @brief Gateway DM benchmarks
+ *
+ * Counts are in simulated time. Costs are in host TSC cycles, they are only comparable between
+ * runs on the same host.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/ztest.h>
+
+#include "lcz_ble_gw_dm_task.h"
+#include "lcz_ble_gw_dm_timer.h"
+#include "gw_dm_stubs.h"
+#include "gw_dm_test.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define CONNECTION_CYCLES 10
+/* Attributes read by a refresh of the configuration snapshot */
+#define CONFIG_SNAPSHOT_READS 8
+/* The Memfault upload reads the transport, the state machine reads nothing */
+#define CYCLE_READS_MAX 1
+#define PERMISSION_CHECKS 10000
+
+/* Attribute load broadcasts, IDs from the first one past the stub table are unrelated */
+#define LOAD_BROADCAST_IDS 200
+#define LOAD_BROADCASTS 1000
+#define UNRELATED_ID_FIRST (ATTR_ID_smp_auth_timeout + 1)
+
+/* The server returns while the last recovery step before the reboot is retrying */
+#define OUTAGE_SECONDS                                                                             \
+	(DISCONNECTED_WATCHDOG_SECONDS + CONFIG_LCZ_BLE_GW_DM_RECOVERY_REREGISTER_TIMEOUT +        \
+	 CONFIG_LCZ_BLE_GW_DM_CONNECTION_DELAY + 1)
+
+#define SMP_OS_GROUP 0
+
+BUILD_ASSERT(UNRELATED_ID_FIRST + LOAD_BROADCAST_IDS <= ATTR_TABLE_SIZE);
+
+struct cycle_counts {
+	uint32_t timer_wakeups;
+	uint32_t timer_expirations;
+	uint32_t task_messages;
+	uint32_t connects;
+};
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void cycle_counts_get(struct cycle_counts *counts)
+{
+	struct lcz_ble_gw_dm_timer_stats timer;
+	struct lwm2m_stub_stats lwm2m;
+	struct fwk_stub_stats fwk;
+
+	lcz_ble_gw_dm_timer_stats_get(&timer);
+	lwm2m_stub_stats_get(&lwm2m);
+	fwk_stub_stats_get(&fwk);
+
+	counts->timer_wakeups = timer.wakeups;
+	counts->timer_expirations = timer.expirations;
+	counts->task_messages = fwk.dispatched[FWK_ID_BLE_GW_DM];
+	counts->connects = lwm2m.connects;
+}
+
+/* Broadcast a load of the IDs and return the filter cost per broadcast */
+static uint32_t load_broadcast_cost(const attr_id_t *ids, struct lcz_ble_gw_dm_queue_stats *queue)
+{
+	struct fwk_stub_stats stats;
+	int i;
+
+	attr_stub_load_ids_set(ids, LOAD_BROADCAST_IDS);
+	fwk_stub_stats_clear();
+	lcz_ble_gw_dm_queue_stats_clear();
+
+	/* The task can't run until the test sleeps, so a queued broadcast stays pending */
+	for (i = 0; i < LOAD_BROADCASTS; i++) {
+		zassert_equal(attr_load(NULL, NULL), 0, "Load failed");
+	}
+	fwk_stub_stats_get(&stats);
+	lcz_ble_gw_dm_queue_stats_get(queue);
+	gw_dm_test_settle();
+
+	return (uint32_t)(stats.filter_cycles / LOAD_BROADCASTS);
+}
+
+/**************************************************************************************************/
+/* Tests                                                                                          */
+/**************************************************************************************************/
+ZTEST(lcz_ble_gw_dm_bench, test_connection_cycle)
+{
+	struct cycle_counts start;
+	struct cycle_counts end;
+	int64_t start_ms;
+	int i;
+
+	cycle_counts_get(&start);
+	start_ms = k_uptime_get();
+	for (i = 0; i < CONNECTION_CYCLES; i++) {
+		gw_dm_test_connect();
+		nm_stub_set(false);
+		gw_dm_test_settle();
+	}
+	cycle_counts_get(&end);
+
+	zassert_equal(end.connects - start.connects, CONNECTION_CYCLES, "Connect calls %u",
+		      end.connects - start.connects);
+
+	TC_PRINT("%u connection cycles of %u ms: timer wakeups %u, expirations %u, "
+		 "task messages %u, connect attempts %u\n",
+		 CONNECTION_CYCLES, (uint32_t)(k_uptime_get() - start_ms) / CONNECTION_CYCLES,
+		 end.timer_wakeups - start.timer_wakeups,
+		 end.timer_expirations - start.timer_expirations,
+		 end.task_messages - start.task_messages, end.connects - start.connects);
+}
+
+ZTEST(lcz_ble_gw_dm_bench, test_attribute_locks)
+{
+	uint32_t cycle_locks;
+	uint32_t refresh_locks;
+	uint32_t other_locks;
+	uint32_t start;
+	int i;
+
+	start = attr_stub_locks();
+	for (i = 0; i < CONNECTION_CYCLES; i++) {
+		gw_dm_test_connect();
+		nm_stub_set(false);
+		/* Include the Memfault upload of the connection */
+		k_sleep(K_SECONDS(1));
+	}
+	cycle_locks = attr_stub_locks() - start;
+
+	/* One lock is taken by the set */
+	start = attr_stub_locks();
+	zassert_equal(attr_set_uint32(ATTR_ID_dm_cnx_retries, 4), 0, "Set failed");
+	gw_dm_test_settle();
+	refresh_locks = attr_stub_locks() - start - 1;
+
+	start = attr_stub_locks();
+	zassert_equal(attr_set_uint32(ATTR_ID_smp_auth_timeout, 301), 0, "Set failed");
+	gw_dm_test_settle();
+	other_locks = attr_stub_locks() - start - 1;
+
+	TC_PRINT("Attribute locks: %u per connection cycle (%u cycles), %u per relevant change, "
+		 "%u per other change\n",
+		 cycle_locks / CONNECTION_CYCLES, CONNECTION_CYCLES, refresh_locks, other_locks);
+
+	/* The configuration is read from the snapshot during a connection */
+	zassert_true(cycle_locks / CONNECTION_CYCLES <= CYCLE_READS_MAX, "Locks per cycle %u",
+		     cycle_locks / CONNECTION_CYCLES);
+	zassert_equal(refresh_locks, CONFIG_SNAPSHOT_READS, "Snapshot refresh locks %u",
+		      refresh_locks);
+	zassert_equal(other_locks, 0, "Refreshed for an unrelated attribute");
+}
+
+ZTEST(lcz_ble_gw_dm_bench, test_server_outage)
+{
+	struct lcz_ble_gw_dm_recovery_stats recovery;
+	uint32_t resets = reset_stub_count();
+	struct cycle_counts start;
+	struct cycle_counts end;
+
+	gw_dm_test_connect();
+	cycle_counts_get(&start);
+
+	lwm2m_stub_connect_result_set(-ECONNREFUSED);
+	lwm2m_stub_event(DM_CLIENT, false, LWM2M_RD_CLIENT_EVENT_DISCONNECT);
+	k_sleep(K_SECONDS(OUTAGE_SECONDS));
+	cycle_counts_get(&end);
+	lcz_ble_gw_dm_recovery_stats_get(&recovery);
+
+	/* Each recovery step starts a fresh retry budget */
+	zassert_true(end.connects - start.connects <= 3 * CONNECT_ATTEMPTS_BEFORE_IDLE_STAY,
+		     "Connect calls %u", end.connects - start.connects);
+	zassert_equal(reset_stub_count(), resets, "Reset during the outage");
+
+	TC_PRINT("Server outage of %u s: connect attempts %u, timer wakeups %u, "
+		 "task messages %u, recovery step %s\n",
+		 OUTAGE_SECONDS, end.connects - start.connects,
+		 end.timer_wakeups - start.timer_wakeups, end.task_messages - start.task_messages,
+		 lcz_ble_gw_dm_recovery_step_name(recovery.step));
+
+	/* The next retry of the step reconnects */
+	lwm2m_stub_connect_result_set(0);
+	gw_dm_test_connect();
+}
+
+ZTEST(lcz_ble_gw_dm_bench, test_load_broadcast_filter_cost)
+{
+	struct lcz_ble_gw_dm_queue_stats unrelated;
+	struct lcz_ble_gw_dm_queue_stats relevant;
+	attr_id_t ids[LOAD_BROADCAST_IDS];
+	uint32_t unrelated_cycles;
+	uint32_t relevant_cycles;
+	int i;
+
+	for (i = 0; i < LOAD_BROADCAST_IDS; i++) {
+		ids[i] = UNRELATED_ID_FIRST + i;
+	}
+	unrelated_cycles = load_broadcast_cost(ids, &unrelated);
+
+	/* Worst case for the filter, the only ID the task uses is last */
+	ids[LOAD_BROADCAST_IDS - 1] = ATTR_ID_dm_cnx_backoff_max;
+	relevant_cycles = load_broadcast_cost(ids, &relevant);
+
+	TC_PRINT("Filter cost of a %u attribute load broadcast (host TSC cycles, %u broadcasts):\n",
+		 LOAD_BROADCAST_IDS, LOAD_BROADCASTS);
+	TC_PRINT("  unrelated %u (filtered %u), last ID relevant %u (accepted %u, coalesced %u)\n",
+		 unrelated_cycles, unrelated.filtered, relevant_cycles, relevant.accepted,
+		 relevant.coalesced);
+
+	zassert_equal(unrelated.filtered, LOAD_BROADCASTS, "Filtered %u", unrelated.filtered);
+	zassert_equal(unrelated.accepted, 0, "Accepted %u", unrelated.accepted);
+	/* Loads that arrive while one is queued are merged into it */
+	zassert_equal(relevant.accepted, 1, "Accepted %u", relevant.accepted);
+	zassert_equal(relevant.coalesced, LOAD_BROADCASTS - 1, "Coalesced %u", relevant.coalesced);
+}
+
+ZTEST(lcz_ble_gw_dm_bench, test_permission_check_cost)
+{
+	static const char *const PATHS[] = {
+		"/lfs1/data.txt",
+		"/lfs1/enc/attr_load.txt",
+		"/lfs1/enc/dm/key.der",
+		"/lfs1/enc/other.txt",
+		"/other/file.txt",
+	};
+	uint64_t start;
+	uint64_t file_cycles;
+	uint64_t smp_cycles;
+	int allowed = 0;
+	int i;
+
+	start = gw_dm_stub_host_cycles();
+	for (i = 0; i < PERMISSION_CHECKS; i++) {
+		allowed += fs_mgmt_stub_permission_check(PATHS[i % ARRAY_SIZE(PATHS)], true);
+	}
+	file_cycles = gw_dm_stub_host_cycles() - start;
+	/* Three of the paths can be written */
+	zassert_equal(allowed, (int)(PERMISSION_CHECKS / ARRAY_SIZE(PATHS)) * 3, "Allowed %d",
+		      allowed);
+
+	smp_stub_auth_complete(true);
+	start = gw_dm_stub_host_cycles();
+	for (i = 0; i < PERMISSION_CHECKS; i++) {
+		(void)smp_stub_permission_check(SMP_OS_GROUP, 0);
+	}
+	smp_cycles = gw_dm_stub_host_cycles() - start;
+	smp_stub_auth_complete(false);
+
+	TC_PRINT("Permission check cost (host TSC cycles per call, %u calls):\n",
+		 PERMISSION_CHECKS);
+	TC_PRINT("  file write %u, SMP authorized %u\n",
+		 (uint32_t)(file_cycles / PERMISSION_CHECKS),
+		 (uint32_t)(smp_cycles / PERMISSION_CHECKS));
+}
+
+ZTEST_SUITE(lcz_ble_gw_dm_bench, NULL, NULL, gw_dm_test_reset, NULL, NULL);
@@ -0,0 +1,470 @@
+/**
+ * @file test_fsm.c
+ * @brief Gateway DM state machine tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/ztest.h>
+
+#include "lcz_ble_gw_dm_task.h"
+#include "lcz_ble_gw_dm_time.h"
+#include "lcz_ble_gw_dm_timer.h"
+#include "memfault_task.h"
+#include "gw_dm_stubs.h"
+#include "gw_dm_test.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define CONNECTION_DELAY_S CONFIG_LCZ_BLE_GW_DM_CONNECTION_DELAY
+#define CONNECTION_TIMEOUT_S CONFIG_LCZ_BLE_GW_DM_CONNECTION_TIMEOUT
+#define NETWORK_RECHECK_S CONFIG_LCZ_BLE_GW_DM_WAIT_FOR_NETWORK_TIMEOUT
+
+/* Longest delay before a connect call with the default backoff attributes */
+#define RETRY_DELAY_MAX_S 60
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void wait_for_connect_call(void)
+{
+	zassert_true(gw_dm_test_wait_for_state(STATE_WAIT_FOR_CONNECTION,
+					       RETRY_DELAY_MAX_S + 1),
+		     "No connect call");
+}
+
+/**************************************************************************************************/
+/* Tests                                                                                          */
+/**************************************************************************************************/
+ZTEST(lcz_ble_gw_dm_fsm, test_no_connect_while_network_down)
+{
+	struct lwm2m_stub_stats stats;
+
+	k_sleep(K_MINUTES(5));
+
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(stats.connects, 0, "Connect without a network");
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_NETWORK), "Left wait for network");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_network_recheck_after_lost_event)
+{
+	uint16_t mark = gw_dm_test_trace_mark();
+
+	nm_stub_set_silent(true);
+	gw_dm_test_settle();
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_NETWORK), "Ran without an event");
+
+	zassert_true(gw_dm_test_wait_for_state(STATE_WAIT_FOR_CONNECTION,
+					       NETWORK_RECHECK_S + CONNECTION_DELAY_S + 1),
+		     "Network ready not found by the re-check");
+	zassert_true(gw_dm_test_trace_has(mark, STATE_WAIT_FOR_NETWORK, STATE_GET_NETWORK_TIME),
+		     "Missing transition");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_connection_sequence)
+{
+	static const char *const EXPECTED[] = {
+		STATE_GET_NETWORK_TIME, STATE_POST_MEMFAULT,	   STATE_WAIT_BEFORE_DM,
+		STATE_CONNECT_TO_DM,	STATE_WAIT_FOR_CONNECTION, STATE_IDLE,
+	};
+	struct lcz_ble_gw_dm_trace_record records[TRACE_RECORDS_MAX];
+	uint16_t mark = gw_dm_test_trace_mark();
+	struct lwm2m_stub_stats stats;
+	size_t count;
+	size_t i;
+
+	gw_dm_test_connect();
+
+	count = gw_dm_test_trace_get(mark, records, ARRAY_SIZE(records));
+	zassert_equal(count, ARRAY_SIZE(EXPECTED), "Unexpected transition count %zu", count);
+	for (i = 0; i < count; i++) {
+		zassert_equal(records[i].to, gw_dm_test_state(EXPECTED[i]), "Expected %s, got %s",
+			      EXPECTED[i], lcz_ble_gw_dm_state_name(records[i].to));
+	}
+	zassert_equal(records[0].cause, LCZ_BLE_GW_DM_TRACE_CAUSE_NETWORK, "Wrong cause");
+	zassert_equal(records[count - 1].cause, LCZ_BLE_GW_DM_TRACE_CAUSE_LWM2M, "Wrong cause");
+
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(stats.connects, 1, "Connect calls %u", stats.connects);
+	zassert_equal(stats.credential_loads, 1, "Credential loads %u", stats.credential_loads);
+	zassert_equal(strcmp(stats.endpoint, "gw-test"), 0, "Endpoint %s", stats.endpoint);
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_connect_error_retries)
+{
+	struct lcz_ble_gw_dm_trace_record records[TRACE_RECORDS_MAX];
+	uint16_t mark = gw_dm_test_trace_mark();
+	struct lwm2m_stub_stats stats;
+	size_t count;
+	size_t i;
+
+	lwm2m_stub_connect_result_set(-EIO);
+	nm_stub_set(true);
+	k_sleep(K_SECONDS(CONNECTION_DELAY_S + 1));
+
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(stats.connects, 1, "Connect calls %u", stats.connects);
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_BEFORE_DM), "Not waiting to retry");
+	zassert_true(gw_dm_test_trace_has(mark, STATE_CONNECT_TO_DM, STATE_WAIT_FOR_NETWORK),
+		     "Connect error not handled");
+	zassert_false(gw_dm_test_trace_has(mark, STATE_CONNECT_TO_DM, STATE_WAIT_FOR_CONNECTION),
+		      "Waited for a failed connection");
+
+	/* The attempt is counted once the failure has been traced */
+	count = gw_dm_test_trace_get(mark, records, ARRAY_SIZE(records));
+	zassert_true(count > 0, "No trace");
+	zassert_equal(records[count - 1].cnx_tries, 1, "Tries %u", records[count - 1].cnx_tries);
+	for (i = 0; i < count; i++) {
+		zassert_not_equal(records[i].to, gw_dm_test_state(STATE_IDLE_STAY), "Gave up");
+	}
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_registration_failure)
+{
+	uint16_t mark = gw_dm_test_trace_mark();
+	struct lwm2m_stub_stats stats;
+
+	nm_stub_set(true);
+	wait_for_connect_call();
+
+	lwm2m_stub_event(DM_CLIENT, false, LWM2M_RD_CLIENT_EVENT_REGISTRATION_FAILURE);
+	gw_dm_test_settle();
+
+	zassert_true(gw_dm_test_trace_has(mark, STATE_WAIT_FOR_CONNECTION, STATE_DISCONNECT_DM),
+		     "Failure not handled");
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_BEFORE_DM), "Not waiting to retry");
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(stats.disconnects, 1, "Disconnect calls %u", stats.disconnects);
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_connection_timeout)
+{
+	struct lcz_ble_gw_dm_trace_record records[TRACE_RECORDS_MAX];
+	uint16_t mark;
+	size_t count;
+	size_t i;
+
+	nm_stub_set(true);
+	wait_for_connect_call();
+	mark = gw_dm_test_trace_mark();
+
+	k_sleep(K_SECONDS(CONNECTION_TIMEOUT_S - 1));
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_CONNECTION), "Timed out early");
+
+	k_sleep(K_SECONDS(2));
+	count = gw_dm_test_trace_get(mark, records, ARRAY_SIZE(records));
+	zassert_true(count > 0, "No timeout");
+	zassert_equal(records[0].to, gw_dm_test_state(STATE_DISCONNECT_DM), "Wrong state %s",
+		      lcz_ble_gw_dm_state_name(records[0].to));
+	zassert_equal(records[0].cause, LCZ_BLE_GW_DM_TRACE_CAUSE_DEADLINE, "Wrong cause");
+	for (i = 0; i < count; i++) {
+		zassert_not_equal(records[i].to, gw_dm_test_state(STATE_IDLE), "Connected");
+	}
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_network_lost_waiting_for_connection)
+{
+	uint16_t mark;
+
+	nm_stub_set(true);
+	wait_for_connect_call();
+	mark = gw_dm_test_trace_mark();
+
+	nm_stub_set(false);
+	gw_dm_test_settle();
+
+	zassert_true(gw_dm_test_trace_has(mark, STATE_WAIT_FOR_CONNECTION, STATE_DISCONNECT_DM),
+		     "Network loss not handled");
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_NETWORK), "Not waiting for network");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_network_lost_during_delay)
+{
+	struct lwm2m_stub_stats stats;
+
+	nm_stub_set(true);
+	gw_dm_test_settle();
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_BEFORE_DM), "Not delaying");
+
+	nm_stub_set(false);
+	k_sleep(K_SECONDS(CONNECTION_DELAY_S * 2));
+
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(stats.connects, 0, "Connect without a network");
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_NETWORK), "Not waiting for network");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_idle_server_disconnect)
+{
+	uint16_t mark;
+	struct lwm2m_stub_stats stats;
+
+	gw_dm_test_connect();
+	mark = gw_dm_test_trace_mark();
+	lwm2m_stub_stats_clear();
+
+	lwm2m_stub_event(DM_CLIENT, false, LWM2M_RD_CLIENT_EVENT_DISCONNECT);
+	gw_dm_test_settle();
+
+	zassert_true(gw_dm_test_trace_has(mark, STATE_IDLE, STATE_DISCONNECT_DM),
+		     "Disconnect not handled");
+	/* The network is still up so the connection is made again */
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_BEFORE_DM), "Not reconnecting");
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(stats.disconnects, 1, "Disconnect calls %u", stats.disconnects);
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_idle_network_down)
+{
+	uint16_t mark;
+
+	gw_dm_test_connect();
+	mark = gw_dm_test_trace_mark();
+
+	nm_stub_set(false);
+	gw_dm_test_settle();
+
+	zassert_true(gw_dm_test_trace_has(mark, STATE_IDLE, STATE_DISCONNECT_DM),
+		     "Network loss not handled");
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_NETWORK), "Not waiting for network");
+	zassert_false(lwm2m_stub_connected(DM_CLIENT), "Still connected");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_idle_wakeups_per_hour)
+{
+	struct lcz_ble_gw_dm_timer_stats timer_before;
+	struct lcz_ble_gw_dm_timer_stats timer_after;
+	struct fwk_stub_stats fwk_before;
+	struct fwk_stub_stats fwk_after;
+	uint32_t resets = reset_stub_count();
+	uint32_t task_messages;
+
+	gw_dm_test_connect();
+	/* Let the Memfault upload of the connection finish */
+	k_sleep(K_SECONDS(1));
+	lcz_ble_gw_dm_timer_stats_get(&timer_before);
+	fwk_stub_stats_get(&fwk_before);
+
+	/* A registration update is the only event while idle, it also pets the reboot watchdog */
+	k_sleep(K_MINUTES(30));
+	lwm2m_stub_event(DM_CLIENT, true, LWM2M_RD_CLIENT_EVENT_REG_UPDATE_COMPLETE);
+	k_sleep(K_MINUTES(30));
+
+	lcz_ble_gw_dm_timer_stats_get(&timer_after);
+	fwk_stub_stats_get(&fwk_after);
+	task_messages = fwk_after.dispatched[FWK_ID_BLE_GW_DM] -
+			fwk_before.dispatched[FWK_ID_BLE_GW_DM];
+
+	TC_PRINT("Idle for a simulated hour: timer wakeups %u, timer expirations %u, "
+		 "task messages %u\n",
+		 timer_after.wakeups - timer_before.wakeups,
+		 timer_after.expirations - timer_before.expirations, task_messages);
+
+	zassert_equal(timer_after.wakeups, timer_before.wakeups, "Timer wakeups while idle");
+	zassert_equal(timer_after.expirations, timer_before.expirations, "Timers expired");
+	/* The kick for the registration update */
+	zassert_equal(task_messages, 1, "Task messages %u", task_messages);
+	zassert_true(gw_dm_test_in_state(STATE_IDLE), "Not idle");
+	zassert_equal(reset_stub_count(), resets, "Reset while idle");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_idle_kick_retry_wakes_once)
+{
+	struct lcz_ble_gw_dm_timer_stats timer_before;
+	struct lcz_ble_gw_dm_timer_stats timer_after;
+	struct fwk_stub_stats fwk_before;
+	struct fwk_stub_stats fwk_after;
+	uint32_t resets = reset_stub_count();
+	uint32_t task_messages;
+
+	gw_dm_test_connect();
+	k_sleep(K_SECONDS(1));
+	lcz_ble_gw_dm_timer_stats_get(&timer_before);
+	fwk_stub_stats_get(&fwk_before);
+
+	/* The kick for the registration update can't be queued, the retry timer sends it */
+	fwk_stub_send_fail(1);
+	lwm2m_stub_event(DM_CLIENT, true, LWM2M_RD_CLIENT_EVENT_REG_UPDATE_COMPLETE);
+	k_sleep(K_MINUTES(30));
+
+	lcz_ble_gw_dm_timer_stats_get(&timer_after);
+	fwk_stub_stats_get(&fwk_after);
+	task_messages = fwk_after.dispatched[FWK_ID_BLE_GW_DM] -
+			fwk_before.dispatched[FWK_ID_BLE_GW_DM];
+
+	zassert_equal(fwk_after.send_failures - fwk_before.send_failures, 1, "Kick sent");
+	zassert_equal(timer_after.wakeups - timer_before.wakeups, 1, "Timer wakeups %u",
+		      timer_after.wakeups - timer_before.wakeups);
+	zassert_equal(timer_after.expirations - timer_before.expirations, 1,
+		      "Timer expirations %u", timer_after.expirations - timer_before.expirations);
+	zassert_equal(task_messages, 1, "Task messages %u", task_messages);
+	zassert_true(gw_dm_test_in_state(STATE_IDLE), "Not idle");
+	zassert_equal(reset_stub_count(), resets, "Reset while idle");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_retry_limit_and_recovery)
+{
+	struct lcz_ble_gw_dm_recovery_stats before;
+	struct lcz_ble_gw_dm_recovery_stats after;
+	struct lwm2m_stub_stats stats;
+	int step = LCZ_BLE_GW_DM_RECOVERY_REREGISTER;
+
+	gw_dm_test_connect();
+	lwm2m_stub_stats_clear();
+	lcz_ble_gw_dm_recovery_stats_get(&before);
+
+	/* The server goes away, this arms the connection watchdog */
+	lwm2m_stub_connect_result_set(-ECONNREFUSED);
+	lwm2m_stub_event(DM_CLIENT, false, LWM2M_RD_CLIENT_EVENT_DISCONNECT);
+
+	zassert_true(gw_dm_test_wait_for_state(STATE_IDLE_STAY,
+					       CONNECT_ATTEMPTS_BEFORE_IDLE_STAY *
+						       (RETRY_DELAY_MAX_S + 1)),
+		     "Retries not limited");
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(stats.connects, CONNECT_ATTEMPTS_BEFORE_IDLE_STAY, "Connect calls %u",
+		      stats.connects);
+
+	/* The watchdog re-registers, which restarts the connection in this state */
+	lwm2m_stub_connect_result_set(0);
+	zassert_true(gw_dm_test_wait_for_state(STATE_WAIT_FOR_CONNECTION,
+					       DISCONNECTED_WATCHDOG_SECONDS),
+		     "No recovery");
+	lcz_ble_gw_dm_recovery_stats_get(&after);
+	zassert_equal(after.step, step, "Step %d", after.step);
+	zassert_equal(after.attempts[step], before.attempts[step] + 1, "Not attempted");
+
+	lwm2m_stub_event(DM_CLIENT, true, LWM2M_RD_CLIENT_EVENT_REGISTRATION_COMPLETE);
+	gw_dm_test_settle();
+	zassert_true(gw_dm_test_in_state(STATE_IDLE), "Not idle");
+	lcz_ble_gw_dm_recovery_stats_get(&after);
+	zassert_equal(after.step, LCZ_BLE_GW_DM_RECOVERY_NONE, "Recovery still running");
+	zassert_equal(after.recovered[step], before.recovered[step] + 1, "Recovery not counted");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_kick_retried_when_queue_send_fails)
+{
+	struct lcz_ble_gw_dm_timer_stats timer_before;
+	struct lcz_ble_gw_dm_timer_stats timer_after;
+	struct fwk_stub_stats stats;
+
+	lcz_ble_gw_dm_timer_stats_get(&timer_before);
+	fwk_stub_send_fail(1);
+	nm_stub_set(true);
+	gw_dm_test_settle();
+
+	fwk_stub_stats_get(&stats);
+	zassert_equal(stats.send_failures, 1, "Kick not sent");
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_FOR_NETWORK), "Ran without a kick");
+
+	k_sleep(K_MSEC(1100));
+	zassert_true(gw_dm_test_in_state(STATE_WAIT_BEFORE_DM), "Kick not retried");
+	lcz_ble_gw_dm_timer_stats_get(&timer_after);
+	zassert_true(timer_after.expirations > timer_before.expirations, "No retry timer");
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_endpoint_change_applied)
+{
+	static const char ENDPOINT[] = "gw-renamed";
+	struct lwm2m_stub_stats stats;
+
+	zassert_equal(attr_set_string(ATTR_ID_lwm2m_endpoint, ENDPOINT, strlen(ENDPOINT)), 0,
+		      "Set failed");
+	gw_dm_test_settle();
+	gw_dm_test_connect();
+
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(strcmp(stats.endpoint, ENDPOINT), 0, "Endpoint %s", stats.endpoint);
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_lwm2m_time_write_not_a_time_source)
+{
+	struct lcz_ble_gw_dm_time_stats before;
+	struct lcz_ble_gw_dm_time_stats after;
+	int32_t now;
+
+	gw_dm_test_connect();
+	lcz_ble_gw_dm_time_stats_get(&before);
+
+	/* A server an hour ahead must not look like an hour of drift */
+	now = lcz_ble_gw_dm_time_get();
+	lcz_ble_gw_dm_time_set(now + SEC_PER_HOUR);
+	zassert_equal(lcz_ble_gw_dm_time_get(), now + SEC_PER_HOUR, "Offset not applied");
+
+	lcz_ble_gw_dm_time_stats_get(&after);
+	zassert_equal(after.lwm2m_writes, before.lwm2m_writes + 1, "Write not counted");
+	zassert_equal(after.lwm2m_write_age_ms, 0, "Write time not recorded");
+	zassert_equal(after.updates, before.updates, "Counted as an update");
+	zassert_equal(after.source, before.source, "Source %s",
+		      lcz_ble_gw_dm_time_source_name(after.source));
+	zassert_equal(after.measured_drift_ppm, before.measured_drift_ppm, "Drift %u ppm",
+		      after.measured_drift_ppm);
+	zassert_equal(after.error_ms, before.error_ms, "Error %u ms", after.error_ms);
+
+	lcz_ble_gw_dm_time_set(now);
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_change_applied_when_queue_full)
+{
+	static const char ENDPOINT[] = "gw-queue-full";
+	struct lcz_ble_gw_dm_queue_stats queue;
+	struct lwm2m_stub_stats stats;
+	FwkMsg_t *msg;
+	uint32_t locks;
+	uint32_t i;
+
+	/* The task can't run until the test sleeps, the first kick is handed to it directly */
+	lcz_ble_gw_dm_queue_stats_clear();
+	lcz_ble_gw_dm_queue_stats_get(&queue);
+	for (i = 0; i < queue.depth + 1; i++) {
+		msg = BufferPool_Take(sizeof(FwkMsg_t));
+		zassert_not_null(msg, "No buffer");
+		msg->header.msgCode = FMC_GW_DM_FSM_KICK;
+		msg->header.txId = FWK_ID_BLE_GW_DM;
+		msg->header.rxId = FWK_ID_BLE_GW_DM;
+		zassert_equal(Framework_Send(FWK_ID_BLE_GW_DM, msg), FWK_SUCCESS, "Send failed");
+	}
+
+	zassert_equal(attr_set_string(ATTR_ID_lwm2m_endpoint, ENDPOINT, strlen(ENDPOINT)), 0,
+		      "Set failed");
+	lcz_ble_gw_dm_queue_stats_get(&queue);
+	zassert_equal(queue.dropped, 1, "Dropped %u", queue.dropped);
+
+	/* Delivered without another broadcast, the snapshot refresh reads the attributes */
+	locks = attr_stub_locks();
+	gw_dm_test_settle();
+	zassert_true(attr_stub_locks() > locks, "Change not delivered");
+
+	gw_dm_test_connect();
+
+	lwm2m_stub_stats_get(&stats);
+	zassert_equal(strcmp(stats.endpoint, ENDPOINT), 0, "Endpoint %s", stats.endpoint);
+}
+
+ZTEST(lcz_ble_gw_dm_fsm, test_memfault_failure_does_not_block_connection)
+{
+	struct lcz_ble_gw_dm_memfault_stats before;
+	struct lcz_ble_gw_dm_memfault_stats after;
+	uint32_t posts = memfault_stub_posts();
+
+	lcz_ble_gw_dm_memfault_stats_get(&before);
+	memfault_stub_post_result_set(-EIO);
+	gw_dm_test_connect();
+	gw_dm_test_settle();
+
+	lcz_ble_gw_dm_memfault_stats_get(&after);
+	zassert_true(memfault_stub_posts() > posts, "Not posted");
+	zassert_true(after.uploads > before.uploads, "No upload");
+	zassert_equal(after.last_result, -EIO, "Result %d", after.last_result);
+	zassert_true(gw_dm_test_in_state(STATE_IDLE), "Not idle");
+}
+
+ZTEST_SUITE(lcz_ble_gw_dm_fsm, NULL, NULL, gw_dm_test_reset, NULL, NULL);
@@ -0,0 +1,190 @@
+/**
+ * @file test_rules.c
+ * @brief LwM2M file management and SMP permission rule tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/ztest.h>
+
+#include "lcz_ble_gw_dm_creds.h"
+#include "gw_dm_stubs.h"
+#include "gw_dm_test.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define LOAD_PATH "/lfs1/enc/attr_load.txt"
+#define FACTORY_LOAD_PATH "/lfs1/enc/factory_load.txt"
+#define DUMP_PATH "/lfs1/enc/attr_dump.txt"
+#define DM_KEY_PATH "/lfs1/enc/dm/key.der"
+#define DM_PUB_PATH "/lfs1/enc/dm/pub.der"
+#define TELEM_KEY_PATH "/lfs1/enc/telem/key.der"
+
+/* Writes to the factory load path stay allowed this long after the last one */
+#define FACTORY_WRITE_WINDOW_MS 1000
+/* A key file write is complete this long after the last write request */
+#define KEY_WRITE_WINDOW_MS 1000
+
+#define SMP_OS_GROUP 0
+#define SMP_AUTH_TIMEOUT_S 300
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static int creds_load(void)
+{
+	return lcz_ble_gw_dm_creds_load(LCZ_PKI_AUTH_STORE_DEVICE_MANAGEMENT,
+					CONFIG_LCZ_LWM2M_TLS_TAG);
+}
+
+static void rules_reset(void *fixture)
+{
+	ARG_UNUSED(fixture);
+
+	attr_stub_reset();
+	efs_stub_file_size_set(FACTORY_LOAD_PATH, -1);
+	smp_stub_auth_complete(false);
+	/* Close any factory write window left by the previous test */
+	k_sleep(K_MSEC(FACTORY_WRITE_WINDOW_MS * 2));
+}
+
+/**************************************************************************************************/
+/* Tests                                                                                          */
+/**************************************************************************************************/
+ZTEST(lcz_ble_gw_dm_rules, test_file_outside_mount_point_denied)
+{
+	zassert_false(fs_mgmt_stub_permission_check("/other/file.txt", false), "Read allowed");
+	zassert_false(fs_mgmt_stub_permission_check("/other/file.txt", true), "Write allowed");
+	zassert_false(fs_mgmt_stub_permission_check("/lfs1/../other/file.txt", false),
+		      "Escaped the mount point");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_file_plain_allowed)
+{
+	zassert_true(fs_mgmt_stub_permission_check("/lfs1/data.txt", false), "Read denied");
+	zassert_true(fs_mgmt_stub_permission_check("/lfs1/data.txt", true), "Write denied");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_file_encrypted_read_denied)
+{
+	zassert_false(fs_mgmt_stub_permission_check(LOAD_PATH, false), "Read allowed");
+	zassert_false(fs_mgmt_stub_permission_check(DM_KEY_PATH, false), "Key read allowed");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_file_load_path_write_allowed)
+{
+	zassert_true(fs_mgmt_stub_permission_check(LOAD_PATH, true), "Write denied");
+	zassert_true(fs_mgmt_stub_permission_check("/lfs1/./enc//attr_load.txt", true),
+		     "Path not simplified");
+	zassert_false(fs_mgmt_stub_permission_check("/lfs1/enc/other.txt", true),
+		      "Encrypted write allowed");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_file_factory_load_written_once)
+{
+	zassert_true(fs_mgmt_stub_permission_check(FACTORY_LOAD_PATH, true), "First write denied");
+
+	/* The file exists once the first block is written, the rest of the transfer follows */
+	efs_stub_file_size_set(FACTORY_LOAD_PATH, 512);
+	k_sleep(K_MSEC(FACTORY_WRITE_WINDOW_MS / 2));
+	zassert_true(fs_mgmt_stub_permission_check(FACTORY_LOAD_PATH, true), "Transfer denied");
+
+	k_sleep(K_MSEC(FACTORY_WRITE_WINDOW_MS * 2));
+	zassert_false(fs_mgmt_stub_permission_check(FACTORY_LOAD_PATH, true), "Overwrite allowed");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_file_key_write_allowed)
+{
+	zassert_true(fs_mgmt_stub_permission_check(DM_KEY_PATH, true), "DM key denied");
+	zassert_true(fs_mgmt_stub_permission_check(DM_PUB_PATH, true), "DM public key denied");
+	zassert_true(fs_mgmt_stub_permission_check(TELEM_KEY_PATH, true), "Telemetry key denied");
+	zassert_false(fs_mgmt_stub_permission_check("/lfs1/enc/dm/csr.pem", true),
+		      "Other credential allowed");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_file_key_write_reloads_credentials)
+{
+	struct lcz_ble_gw_dm_creds_stats before;
+	struct lcz_ble_gw_dm_creds_stats after;
+
+	zassert_equal(creds_load(), 0, "Load failed");
+	lcz_ble_gw_dm_creds_stats_get(&before);
+	zassert_equal(creds_load(), 0, "Load failed");
+	lcz_ble_gw_dm_creds_stats_get(&after);
+	zassert_equal(after.hits, before.hits + 1, "Unchanged credentials loaded");
+
+	zassert_true(fs_mgmt_stub_permission_check(DM_KEY_PATH, true), "DM key denied");
+	k_sleep(K_MSEC(KEY_WRITE_WINDOW_MS / 2));
+	zassert_true(fs_mgmt_stub_permission_check(DM_KEY_PATH, true), "DM key denied");
+	k_sleep(K_MSEC(KEY_WRITE_WINDOW_MS / 2));
+	lcz_ble_gw_dm_creds_stats_get(&after);
+	zassert_equal(after.invalidations, before.invalidations, "Invalidated during the write");
+
+	k_sleep(K_MSEC(KEY_WRITE_WINDOW_MS));
+	zassert_equal(creds_load(), 0, "Load failed");
+	lcz_ble_gw_dm_creds_stats_get(&after);
+	zassert_equal(after.invalidations, before.invalidations + 1, "Not invalidated");
+	zassert_equal(after.loads, before.loads + 1, "Written credentials not loaded");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_file_exec)
+{
+	uint32_t completions;
+	uint32_t scripts;
+	int result = -1;
+
+	completions = fs_mgmt_stub_exec_completions(NULL);
+	zassert_equal(fs_mgmt_stub_exec(LOAD_PATH), 0, "Load failed");
+	zassert_equal(fs_mgmt_stub_exec(DUMP_PATH), 0, "Dump failed");
+	zassert_equal(fs_mgmt_stub_exec(CONFIG_LCZ_BLE_GW_DM_TRACE_PATH), 0, "Trace dump failed");
+	zassert_equal(fs_mgmt_stub_exec_completions(&result), completions + 3, "Not completed");
+	zassert_equal(result, 0, "Result %d", result);
+
+	zassert_equal(fs_mgmt_stub_exec(FACTORY_LOAD_PATH), -EPERM, "Factory load allowed");
+	zassert_equal(fs_mgmt_stub_exec("/lfs1/data.txt"), -EPERM, "Exec allowed");
+
+	/* Scripts run from the system work queue */
+	scripts = zsh_stub_scripts_run();
+	zassert_equal(fs_mgmt_stub_exec("/lfs1/test.sh"), 0, "Script refused");
+	gw_dm_test_settle();
+	zassert_equal(zsh_stub_scripts_run(), scripts + 1, "Script not run");
+	zassert_equal(fs_mgmt_stub_exec_completions(&result), completions + 4, "Not completed");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_smp_requires_auth)
+{
+	zassert_true(smp_stub_permission_check(CONFIG_LCZ_PKI_AUTH_SMP_GROUP_ID, 0),
+		     "Auth group denied");
+	zassert_false(smp_stub_permission_check(SMP_OS_GROUP, 0), "Allowed without auth");
+
+	smp_stub_auth_complete(true);
+	zassert_true(smp_stub_permission_check(SMP_OS_GROUP, 0), "Denied after auth");
+
+	smp_stub_auth_complete(false);
+	zassert_false(smp_stub_permission_check(SMP_OS_GROUP, 0), "Allowed after failed auth");
+}
+
+ZTEST(lcz_ble_gw_dm_rules, test_smp_auth_expires)
+{
+	smp_stub_auth_complete(true);
+
+	/* Each allowed command restarts the timeout */
+	k_sleep(K_SECONDS(SMP_AUTH_TIMEOUT_S - 1));
+	zassert_true(smp_stub_permission_check(SMP_OS_GROUP, 0), "Expired early");
+	k_sleep(K_SECONDS(SMP_AUTH_TIMEOUT_S - 1));
+	zassert_true(smp_stub_permission_check(SMP_OS_GROUP, 0), "Timeout not restarted");
+
+	k_sleep(K_SECONDS(SMP_AUTH_TIMEOUT_S + 1));
+	zassert_false(smp_stub_permission_check(SMP_OS_GROUP, 0), "Auth didn't expire");
+	zassert_true(smp_stub_permission_check(CONFIG_LCZ_PKI_AUTH_SMP_GROUP_ID, 0),
+		     "Auth group denied");
+}
+
+ZTEST_SUITE(lcz_ble_gw_dm_rules, NULL, NULL, rules_reset, NULL, NULL);
@@ -0,0 +1,88 @@
+/**
+ * @file attr.h
+ * @brief Attribute stub for the native_posix tests
+ *
+ * Only the attributes used by the module exist. Each access takes the attribute lock once,
+ * like the real implementation, and is counted.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __ATTR_H__
+#define __ATTR_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <fwk_includes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+typedef uint16_t attr_id_t;
+
+/* The module checks for optional attributes with #if defined(ATTR_ID_x) */
+#define ATTR_ID_dm_cnx_delay 1
+#define ATTR_ID_dm_cnx_delay_min 2
+#define ATTR_ID_dm_cnx_delay_max 3
+#define ATTR_ID_dm_cnx_retries 4
+#define ATTR_ID_dm_cnx_backoff_retries 5
+#define ATTR_ID_dm_cnx_backoff_multi 6
+#define ATTR_ID_dm_cnx_backoff_policy 7
+#define ATTR_ID_dm_cnx_backoff_max 8
+#define ATTR_ID_lwm2m_endpoint 9
+#define ATTR_ID_device_id 10
+#define ATTR_ID_memfault_transport 11
+#define ATTR_ID_load_path 12
+#define ATTR_ID_factory_load_path 13
+#define ATTR_ID_dump_path 14
+#define ATTR_ID_smp_auth_req 15
+#define ATTR_ID_smp_auth_timeout 16
+
+/* Large enough for a full attribute load */
+#define ATTR_TABLE_SIZE 256
+
+#define ATTR_MAX_STR_LENGTH 64
+
+#define ATTR_DUMP_RW 0
+
+typedef struct {
+	FwkMsgHeader_t header;
+	size_t count;
+	attr_id_t list[ATTR_TABLE_SIZE];
+} attr_changed_msg_t;
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+uint32_t attr_get_uint32(attr_id_t id, uint32_t alt);
+
+int32_t attr_get_signed32(attr_id_t id, int32_t alt);
+
+const void *attr_get_quasi_static(attr_id_t id);
+
+int attr_set_uint32(attr_id_t id, uint32_t value);
+
+int attr_set_signed32(attr_id_t id, int32_t value);
+
+int attr_set_float(attr_id_t id, float value);
+
+int attr_set_string(attr_id_t id, char const *value, size_t length);
+
+/* Broadcasts the IDs given to attr_stub_load_ids_set() as changed */
+int attr_load(const char *abs_path, bool *modified);
+
+/* The caller frees the string */
+int attr_prepare_then_dump(char **fstr, int type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATTR_H__ */
@@ -0,0 +1,32 @@
+/**
+ * @file date_time.h
+ * @brief Date time stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __DATE_TIME_H__
+#define __DATE_TIME_H__
+
+#include <zephyr/zephyr.h>
+
+enum date_time_evt_type {
+	DATE_TIME_OBTAINED_MODEM,
+	DATE_TIME_OBTAINED_NTP,
+	DATE_TIME_OBTAINED_EXT,
+	DATE_TIME_NOT_OBTAINED,
+};
+
+struct date_time_evt {
+	enum date_time_evt_type type;
+};
+
+typedef void (*date_time_evt_handler_t)(const struct date_time_evt *evt);
+
+/* Reports NTP time right away */
+int date_time_update_async(date_time_evt_handler_t evt_handler);
+
+int date_time_now(int64_t *unix_time_ms);
+
+#endif /* __DATE_TIME_H__ */
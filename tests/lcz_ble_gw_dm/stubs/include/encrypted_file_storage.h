@@ -0,0 +1,19 @@
+/**
+ * @file encrypted_file_storage.h
+ * @brief Encrypted file storage stub, files below CONFIG_FSU_MOUNT_POINT/enc are encrypted
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __ENCRYPTED_FILE_STORAGE_H__
+#define __ENCRYPTED_FILE_STORAGE_H__
+
+#include <zephyr/zephyr.h>
+#include <sys/types.h>
+
+bool efs_is_encrypted_path(const char *abs_path);
+
+ssize_t efs_get_file_size(const char *abs_path);
+
+#endif /* __ENCRYPTED_FILE_STORAGE_H__ */
@@ -0,0 +1,24 @@
+/**
+ * @file file_system_utilities.h
+ * @brief File system utilities stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __FILE_SYSTEM_UTILITIES_H__
+#define __FILE_SYSTEM_UTILITIES_H__
+
+#include <zephyr/zephyr.h>
+#include <sys/types.h>
+
+#define FSU_MAX_ABS_PATH_SIZE 64
+
+/* Resolves "." and ".." and repeated separators. Returns -EINVAL if the result doesn't fit. */
+int fsu_simplify_path(const char *path, char *simple_path);
+
+ssize_t fsu_get_file_size_abs(const char *abs_path);
+
+ssize_t fsu_write_abs(const char *abs_path, const void *data, size_t size);
+
+#endif /* __FILE_SYSTEM_UTILITIES_H__ */
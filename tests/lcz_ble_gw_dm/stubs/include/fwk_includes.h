@@ -0,0 +1,115 @@
+/**
+ * @file fwk_includes.h
+ * @brief Framework stub for the native_posix tests
+ *
+ * Messages are passed by pointer through the receiver's queue like the real framework.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __FWK_INCLUDES_H__
+#define __FWK_INCLUDES_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+typedef uint8_t FwkId_t;
+typedef uint32_t FwkMsgCode_t;
+
+/* The module's lists are found through its framework_config include directory */
+enum {
+	FWK_ID_RESERVED = 0,
+	FWK_ID_LCZ_POWER,
+#include "fwk_ids.h"
+	FWK_ID_END
+};
+
+enum {
+	FMC_INVALID = 0,
+	FMC_PERIODIC,
+	FMC_ATTR_CHANGED,
+	FMC_LCZ_SENSOR_MEASURED,
+	FMC_LCZ_POWER_BATTERY_STATE,
+	FMC_LWM2M_OBJ_CREATED,
+#include "fwk_msg_codes.h"
+	FMC_END
+};
+
+typedef enum { FWK_SUCCESS = 0, FWK_ERROR = -1 } FwkStatus_t;
+
+typedef enum { DISPATCH_OK = 0, DISPATCH_ERROR, DISPATCH_DO_NOT_FREE } DispatchResult_t;
+
+typedef struct {
+	FwkMsgCode_t msgCode;
+	FwkId_t rxId;
+	FwkId_t txId;
+} FwkMsgHeader_t;
+
+typedef struct {
+	FwkMsgHeader_t header;
+} FwkMsg_t;
+
+typedef struct FwkMsgReceiver FwkMsgReceiver_t;
+
+typedef DispatchResult_t FwkMsgHandler_t(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
+
+struct FwkMsgReceiver {
+	FwkId_t id;
+	k_timeout_t rxBlockTicks;
+	FwkMsgHandler_t *(*pMsgDispatcher)(FwkMsgCode_t MsgCode);
+	struct k_msgq *pQueue;
+	bool (*acceptBroadcast)(const FwkMsg_t *pMsg);
+};
+
+typedef struct {
+	FwkMsgReceiver_t rxer;
+} FwkMsgTask_t;
+
+#define FWK_QUEUE_ENTRY_SIZE sizeof(FwkMsg_t *)
+#define FWK_QUEUE_ALIGNMENT sizeof(FwkMsg_t *)
+
+#define FRAMEWORK_MSG_CREATE_AND_BROADCAST(_txId, _code)                                           \
+	do {                                                                                       \
+		FwkMsg_t *_msg = BufferPool_Take(sizeof(FwkMsg_t));                                \
+		if (_msg != NULL) {                                                                \
+			_msg->header.msgCode = (_code);                                            \
+			_msg->header.txId = (_txId);                                               \
+			_msg->header.rxId = FWK_ID_RESERVED;                                       \
+			(void)Framework_Broadcast(_msg, sizeof(FwkMsg_t));                         \
+		}                                                                                  \
+	} while (0)
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+void Framework_RegisterTask(FwkMsgTask_t *pMsgTask);
+
+FwkStatus_t Framework_Send(FwkId_t RxId, FwkMsg_t *pMsg);
+
+/* Queues a copy for each receiver that accepts it and frees the original */
+FwkStatus_t Framework_Broadcast(FwkMsg_t *pMsg, size_t MsgSize);
+
+/* Waits for one message and dispatches it */
+void Framework_MsgReceiver(FwkMsgReceiver_t *pRxer);
+
+DispatchResult_t Framework_UnknownMsgHandler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
+
+void *BufferPool_Take(size_t Size);
+
+void BufferPool_Free(void *pBuffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FWK_INCLUDES_H__ */
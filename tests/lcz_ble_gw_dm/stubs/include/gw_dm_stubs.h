@@ -0,0 +1,115 @@
+/**
+ * @file gw_dm_stubs.h
+ * @brief Controls and counters of the stubs used by the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __GW_DM_STUBS_H__
+#define __GW_DM_STUBS_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <sys/types.h>
+#include <fwk_includes.h>
+#include <attr.h>
+#include <lcz_lwm2m_client.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+struct fwk_stub_stats {
+	/* Messages queued by Framework_Send */
+	uint32_t sent;
+	/* Framework_Send calls failed on purpose */
+	uint32_t send_failures;
+	/* Broadcast copies queued */
+	uint32_t broadcast_queued;
+	/* Broadcast copies refused by a receiver filter */
+	uint32_t broadcast_filtered;
+	/* Host TSC cycles spent in receiver filters */
+	uint64_t filter_cycles;
+	/* Messages handled by each receiver, indexed by framework ID */
+	uint32_t dispatched[FWK_ID_END];
+	/* Buffers taken and not freed */
+	int32_t buffers_outstanding;
+};
+
+struct lwm2m_stub_stats {
+	uint32_t connects;
+	uint32_t disconnects;
+	uint32_t credential_loads;
+	uint32_t reg_updates;
+	char endpoint[ATTR_MAX_STR_LENGTH + 1];
+};
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+/* Host TSC, the simulated clocks don't advance while code runs on native_posix */
+static inline uint64_t gw_dm_stub_host_cycles(void)
+{
+	return __builtin_ia32_rdtsc();
+}
+
+/* Framework */
+void fwk_stub_stats_get(struct fwk_stub_stats *stats);
+void fwk_stub_stats_clear(void);
+/* Fail the next count calls of Framework_Send */
+void fwk_stub_send_fail(uint32_t count);
+
+/* Attributes. Each access is one lock acquisition. */
+uint32_t attr_stub_locks(void);
+/* Restore the defaults, changed attributes are broadcast */
+void attr_stub_reset(void);
+/* IDs broadcast as changed by attr_load() */
+void attr_stub_load_ids_set(const attr_id_t *ids, size_t count);
+
+/* LwM2M client */
+void lwm2m_stub_stats_get(struct lwm2m_stub_stats *stats);
+void lwm2m_stub_stats_clear(void);
+/* Result of the following lcz_lwm2m_client_connect() calls */
+void lwm2m_stub_connect_result_set(int result);
+/* Report a client event, as the LwM2M engine would */
+void lwm2m_stub_event(int index, bool connected, enum lwm2m_rd_client_event event);
+bool lwm2m_stub_connected(int index);
+
+/* Network monitor, events are only generated when the state changes */
+void nm_stub_set(bool ready);
+/* Change the state without an event, as if the event was lost */
+void nm_stub_set_silent(bool ready);
+
+/* Date time */
+uint32_t date_time_stub_queries(void);
+
+/* Software reset */
+uint32_t reset_stub_count(void);
+
+/* Memfault */
+void memfault_stub_post_result_set(int result);
+uint32_t memfault_stub_posts(void);
+
+/* SMP peripheral authentication */
+void smp_stub_auth_complete(bool status);
+/* Run the registered mcumgr permission check */
+bool smp_stub_permission_check(uint16_t group_id, uint16_t command_id);
+
+/* LwM2M file management */
+bool fs_mgmt_stub_permission_check(const char *path, bool write);
+int fs_mgmt_stub_exec(const char *path);
+uint32_t fs_mgmt_stub_exec_completions(int *last_result);
+void efs_stub_file_size_set(const char *abs_path, ssize_t size);
+uint32_t zsh_stub_scripts_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GW_DM_STUBS_H__ */
@@ -0,0 +1,120 @@
+/**
+ * @file lcz_lwm2m_client.h
+ * @brief LwM2M client stub for the native_posix tests
+ *
+ * Connecting only records the attempt. Registration results are delivered by the tests through
+ * lwm2m_stub_event().
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_LWM2M_CLIENT_H__
+#define __LCZ_LWM2M_CLIENT_H__
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************/
+/* Global Constants, Macros and Type Definitions                                                  */
+/**************************************************************************************************/
+#define LWM2M_MAX_PATH_STR_LEN 32
+
+#define LWM2M_DEVICE_ERROR_LOW_POWER 1
+#define LWM2M_DEVICE_ERROR_EXT_POWER_SUPPLY_OFF 2
+#define LWM2M_DEVICE_ERROR_LOW_SIGNAL_STRENGTH 4
+
+#define LCZ_LWM2M_CLIENT_MAX_INSTANCES 2
+
+enum lwm2m_rd_client_event {
+	LWM2M_RD_CLIENT_EVENT_NONE,
+	LWM2M_RD_CLIENT_EVENT_BOOTSTRAP_REG_FAILURE,
+	LWM2M_RD_CLIENT_EVENT_BOOTSTRAP_REG_COMPLETE,
+	LWM2M_RD_CLIENT_EVENT_BOOTSTRAP_TRANSFER_COMPLETE,
+	LWM2M_RD_CLIENT_EVENT_REGISTRATION_FAILURE,
+	LWM2M_RD_CLIENT_EVENT_REGISTRATION_COMPLETE,
+	LWM2M_RD_CLIENT_EVENT_REG_UPDATE_FAILURE,
+	LWM2M_RD_CLIENT_EVENT_REG_UPDATE_COMPLETE,
+	LWM2M_RD_CLIENT_EVENT_DEREGISTER_FAILURE,
+	LWM2M_RD_CLIENT_EVENT_DISCONNECT,
+	LWM2M_RD_CLIENT_EVENT_QUEUE_MODE_RX_OFF,
+	LWM2M_RD_CLIENT_EVENT_NETWORK_ERROR,
+	LWM2M_RD_CLIENT_EVENT_REG_UPDATE,
+};
+
+enum lcz_lwm2m_client_transport {
+	LCZ_LWM2M_CLIENT_TRANSPORT_UDP = 0,
+	LCZ_LWM2M_CLIENT_TRANSPORT_BLE,
+};
+
+struct lwm2m_ctx {
+	int tls_tag;
+	uint16_t srv_obj_inst;
+	int (*load_credentials)(struct lwm2m_ctx *client_ctx);
+	int (*set_socketoptions)(struct lwm2m_ctx *client_ctx);
+};
+
+typedef void (*lcz_lwm2m_client_connected_cb_t)(struct lwm2m_ctx *client, int lwm2m_client_index,
+						bool connected,
+						enum lwm2m_rd_client_event client_event);
+
+struct lcz_lwm2m_client_event_callback_agent {
+	sys_snode_t node;
+	lcz_lwm2m_client_connected_cb_t connected_callback;
+};
+
+typedef void *(*lwm2m_engine_get_data_cb_t)(uint16_t obj_inst_id, uint16_t res_id,
+					    uint16_t res_inst_id, size_t *data_len);
+
+typedef int (*lwm2m_engine_set_data_cb_t)(uint16_t obj_inst_id, uint16_t res_id,
+					  uint16_t res_inst_id, uint8_t *data, uint16_t data_len,
+					  bool last_block, size_t total_size);
+
+typedef int (*lwm2m_engine_execute_cb_t)(uint16_t obj_inst_id, uint8_t *args, uint16_t args_len);
+
+typedef int (*lcz_lwm2m_client_load_credentials_t)(struct lwm2m_ctx *client_ctx);
+
+/**************************************************************************************************/
+/* Global Function Prototypes                                                                     */
+/**************************************************************************************************/
+int lcz_lwm2m_client_connect(int client_index, int security_index, uint16_t server_inst,
+			     char *endpoint_name, enum lcz_lwm2m_client_transport transport,
+			     int tls_tag, lcz_lwm2m_client_load_credentials_t load_credentials);
+
+/* Reports a disconnect event if the client was connected */
+int lcz_lwm2m_client_disconnect(int client_index, bool deregister);
+
+bool lcz_lwm2m_client_is_connected(int client_index);
+
+int lcz_lwm2m_client_register_event_callback(struct lcz_lwm2m_client_event_callback_agent *agent);
+
+int lcz_lwm2m_client_device_set_err(int error_code);
+
+void lcz_lwm2m_client_register_get_time_callback(lwm2m_engine_get_data_cb_t cb);
+
+void lcz_lwm2m_client_register_pre_write_set_time_callback(lwm2m_engine_get_data_cb_t cb);
+
+void lcz_lwm2m_client_register_post_write_set_time_callback(lwm2m_engine_set_data_cb_t cb);
+
+void lcz_lwm2m_client_register_factory_default_callback(lwm2m_engine_execute_cb_t cb);
+
+int lcz_lwm2m_client_reboot(void);
+
+/* Provided by the gateway device manager */
+int lcz_lwm2m_dm_load_certs(struct lwm2m_ctx *client_ctx);
+
+int lwm2m_engine_get_u32(const char *pathstr, uint32_t *value);
+
+void lwm2m_rd_client_update(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LCZ_LWM2M_CLIENT_H__ */
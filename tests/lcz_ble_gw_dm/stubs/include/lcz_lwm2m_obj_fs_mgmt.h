@@ -0,0 +1,23 @@
+/**
+ * @file lcz_lwm2m_obj_fs_mgmt.h
+ * @brief LwM2M file management object stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_LWM2M_OBJ_FS_MGMT_H__
+#define __LCZ_LWM2M_OBJ_FS_MGMT_H__
+
+#include <zephyr/zephyr.h>
+
+typedef bool (*lcz_lwm2m_obj_fs_mgmt_perm_cb_t)(const char *path, bool write);
+typedef int (*lcz_lwm2m_obj_fs_mgmt_exec_cb_t)(const char *path);
+
+void lcz_lwm2m_obj_fs_mgmt_reg_perm_cb(lcz_lwm2m_obj_fs_mgmt_perm_cb_t cb);
+
+void lcz_lwm2m_obj_fs_mgmt_reg_exec_cb(lcz_lwm2m_obj_fs_mgmt_exec_cb_t cb);
+
+void lcz_lwm2m_obj_fs_mgmt_exec_complete(int result);
+
+#endif /* __LCZ_LWM2M_OBJ_FS_MGMT_H__ */
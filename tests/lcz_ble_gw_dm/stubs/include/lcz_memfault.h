@@ -0,0 +1,38 @@
+/**
+ * @file lcz_memfault.h
+ * @brief Memfault stub for the native_posix tests, HTTP posts are counted
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_MEMFAULT_H__
+#define __LCZ_MEMFAULT_H__
+
+#include <zephyr/zephyr.h>
+
+enum memfault_transport {
+	MEMFAULT_TRANSPORT_NONE = 0,
+	MEMFAULT_TRANSPORT_HTTP,
+	MEMFAULT_TRANSPORT_MQTT,
+	MEMFAULT_TRANSPORT_COAP,
+};
+
+#define MFLT_METRICS_ADD(key, value) ((void)(value))
+#define MFLT_METRICS_SET_UNSIGNED(key, value) ((void)(value))
+#define MFLT_METRICS_SET_SIGNED(key, value) ((void)(value))
+
+#define LCZ_MEMFAULT_HTTP_INIT()
+#define LCZ_MEMFAULT_MQTT_ENABLED() false
+#define LCZ_MEMFAULT_COAP_ENABLED() false
+#define LCZ_MEMFAULT_POST_DATA_V2(buf, size) lcz_memfault_post_data_v2(buf, size)
+#define LCZ_MEMFAULT_PUBLISH_DATA(buf, size, timeout) (-ENOTSUP)
+#define LCZ_MEMFAULT_COAP_PUBLISH_DATA(buf, size, timeout) (-ENOTSUP)
+
+int lcz_memfault_post_data_v2(uint8_t *buf, size_t buf_len);
+
+int lcz_memfault_save_data_to_file(const char *abs_path, uint8_t *buf, size_t buf_len,
+				   bool delete_first, bool save_coredump, size_t *file_size,
+				   bool *has_coredump);
+
+#endif /* __LCZ_MEMFAULT_H__ */
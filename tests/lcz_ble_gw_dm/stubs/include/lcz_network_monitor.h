@@ -0,0 +1,30 @@
+/**
+ * @file lcz_network_monitor.h
+ * @brief Network monitor stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_NETWORK_MONITOR_H__
+#define __LCZ_NETWORK_MONITOR_H__
+
+#include <zephyr/zephyr.h>
+
+enum lcz_nm_event {
+	LCZ_NM_EVENT_IFACE_INIT = 0,
+	LCZ_NM_EVENT_IFACE_DOWN,
+	LCZ_NM_EVENT_IFACE_UP,
+	LCZ_NM_EVENT_IFACE_DNS_ADDED,
+};
+
+struct lcz_nm_event_agent {
+	sys_snode_t node;
+	void (*callback)(enum lcz_nm_event event);
+};
+
+void lcz_nm_register_event_callback(struct lcz_nm_event_agent *agent);
+
+bool lcz_nm_network_ready(void);
+
+#endif /* __LCZ_NETWORK_MONITOR_H__ */
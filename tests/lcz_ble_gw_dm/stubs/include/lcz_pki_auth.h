@@ -0,0 +1,34 @@
+/**
+ * @file lcz_pki_auth.h
+ * @brief PKI authentication stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_PKI_AUTH_H__
+#define __LCZ_PKI_AUTH_H__
+
+#include <zephyr/zephyr.h>
+
+typedef enum {
+	LCZ_PKI_AUTH_STORE_DEVICE_MANAGEMENT = 0,
+	LCZ_PKI_AUTH_STORE_TELEMETRY,
+	LCZ_PKI_AUTH_STORE__NUM
+} LCZ_PKI_AUTH_STORE_T;
+
+typedef enum {
+	LCZ_PKI_AUTH_FILE_PRIVATE_KEY = 0,
+	LCZ_PKI_AUTH_FILE_PUBLIC_KEY,
+	LCZ_PKI_AUTH_FILE_CSR,
+	LCZ_PKI_AUTH_FILE_DEVICE_CERTIFICATE,
+	LCZ_PKI_AUTH_FILE_CA_CERTIFICATE,
+	LCZ_PKI_AUTH_FILE__NUM
+} LCZ_PKI_AUTH_FILE_T;
+
+int lcz_pki_auth_tls_credential_load(LCZ_PKI_AUTH_STORE_T store, int tag, bool root_ca_only);
+
+int lcz_pki_auth_file_name_get(LCZ_PKI_AUTH_STORE_T store, LCZ_PKI_AUTH_FILE_T file,
+			       char *name, size_t name_size);
+
+#endif /* __LCZ_PKI_AUTH_H__ */
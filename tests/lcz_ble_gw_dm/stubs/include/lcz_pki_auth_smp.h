@@ -0,0 +1,22 @@
+/**
+ * @file lcz_pki_auth_smp.h
+ * @brief SMP peripheral authentication stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_PKI_AUTH_SMP_H__
+#define __LCZ_PKI_AUTH_SMP_H__
+
+#include <zephyr/zephyr.h>
+
+struct lcz_pki_auth_smp_periph_auth_callback_agent {
+	sys_snode_t node;
+	void (*cb)(bool status);
+};
+
+void lcz_pki_auth_smp_periph_register_handler(
+	struct lcz_pki_auth_smp_periph_auth_callback_agent *agent);
+
+#endif /* __LCZ_PKI_AUTH_SMP_H__ */
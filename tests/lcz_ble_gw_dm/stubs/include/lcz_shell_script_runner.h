@@ -0,0 +1,18 @@
+/**
+ * @file lcz_shell_script_runner.h
+ * @brief Shell script runner stub, files ending in .sh are scripts
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_SHELL_SCRIPT_RUNNER_H__
+#define __LCZ_SHELL_SCRIPT_RUNNER_H__
+
+#include <zephyr/zephyr.h>
+
+bool lcz_zsh_is_script(const char *abs_path);
+
+int lcz_zsh_run_script(const char *abs_path, void *output);
+
+#endif /* __LCZ_SHELL_SCRIPT_RUNNER_H__ */
@@ -0,0 +1,16 @@
+/**
+ * @file lcz_software_reset.h
+ * @brief Software reset stub for the native_posix tests, resets are only counted
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __LCZ_SOFTWARE_RESET_H__
+#define __LCZ_SOFTWARE_RESET_H__
+
+#include <zephyr/zephyr.h>
+
+void lcz_software_reset_after_assert(uint32_t delay_ms);
+
+#endif /* __LCZ_SOFTWARE_RESET_H__ */
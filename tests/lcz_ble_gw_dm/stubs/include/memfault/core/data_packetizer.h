@@ -0,0 +1,33 @@
+/**
+ * @file data_packetizer.h
+ * @brief Memfault packetizer declarations for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __MEMFAULT_DATA_PACKETIZER_H__
+#define __MEMFAULT_DATA_PACKETIZER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+	kMfltDataSourceMask_None = 0,
+	kMfltDataSourceMask_Coredump = (1 << 0),
+	kMfltDataSourceMask_Event = (1 << 1),
+	kMfltDataSourceMask_Log = (1 << 2),
+	kMfltDataSourceMask_Cdr = (1 << 3),
+	kMfltDataSourceMask_All = 0xf,
+} eMfltDataSourceMask;
+
+bool memfault_packetizer_data_available(void);
+
+bool memfault_packetizer_get_chunk(void *buf, size_t *buf_len);
+
+void memfault_packetizer_abort(void);
+
+void memfault_packetizer_set_active_sources(uint32_t mask);
+
+#endif /* __MEMFAULT_DATA_PACKETIZER_H__ */
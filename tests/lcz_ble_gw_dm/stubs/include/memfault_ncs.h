@@ -0,0 +1,16 @@
+/**
+ * @file memfault_ncs.h
+ * @brief Memfault NCS stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __MEMFAULT_NCS_H__
+#define __MEMFAULT_NCS_H__
+
+#include <zephyr/zephyr.h>
+
+int memfault_ncs_device_id_set(const char *device_id, size_t len);
+
+#endif /* __MEMFAULT_NCS_H__ */
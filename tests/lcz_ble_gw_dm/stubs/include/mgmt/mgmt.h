@@ -0,0 +1,18 @@
+/**
+ * @file mgmt.h
+ * @brief mcumgr permission hook stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __MGMT_MGMT_H__
+#define __MGMT_MGMT_H__
+
+#include <zephyr/zephyr.h>
+
+typedef bool (*mgmt_permission_cb_t)(uint16_t group_id, uint16_t command_id);
+
+void mgmt_register_permission_cb(mgmt_permission_cb_t cb);
+
+#endif /* __MGMT_MGMT_H__ */
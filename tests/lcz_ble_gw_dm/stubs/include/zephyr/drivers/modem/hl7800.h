@@ -0,0 +1,17 @@
+/**
+ * @file hl7800.h
+ * @brief HL7800 declarations used by the module, there is no modem on native_posix
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+#ifndef __HL7800_H__
+#define __HL7800_H__
+
+enum mdm_hl7800_radio_mode {
+	MDM_RAT_CAT_M1 = 0,
+	MDM_RAT_CAT_NB1
+};
+
+#endif /* __HL7800_H__ */
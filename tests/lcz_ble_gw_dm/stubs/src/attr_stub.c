@@ -0,0 +1,249 @@
+/**
+ * @file attr_stub.c
+ * @brief Attribute stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <attr.h>
+
+#include "gw_dm_stubs.h"
+#include "lcz_ble_gw_dm_backoff.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define ATTR_STUB_COUNT (ATTR_ID_smp_auth_timeout + 1)
+
+enum attr_stub_type {
+	ATTR_STUB_NONE = 0,
+	ATTR_STUB_U32,
+	ATTR_STUB_S32,
+	ATTR_STUB_FLOAT,
+	ATTR_STUB_BOOL,
+	ATTR_STUB_STRING
+};
+
+union attr_stub_value {
+	uint32_t u32;
+	int32_t s32;
+	float f;
+	bool b;
+	char str[ATTR_MAX_STR_LENGTH + 1];
+};
+
+struct attr_stub_entry {
+	enum attr_stub_type type;
+	union attr_stub_value def;
+};
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static const struct attr_stub_entry ENTRIES[ATTR_STUB_COUNT] = {
+	[ATTR_ID_dm_cnx_delay] = { ATTR_STUB_U32, { .u32 = 5 } },
+	[ATTR_ID_dm_cnx_delay_min] = { ATTR_STUB_U32, { .u32 = 1 } },
+	[ATTR_ID_dm_cnx_delay_max] = { ATTR_STUB_U32, { .u32 = 300 } },
+	[ATTR_ID_dm_cnx_retries] = { ATTR_STUB_U32, { .u32 = 3 } },
+	[ATTR_ID_dm_cnx_backoff_retries] = { ATTR_STUB_U32, { .u32 = 2 } },
+	[ATTR_ID_dm_cnx_backoff_multi] = { ATTR_STUB_FLOAT, { .f = 2.0f } },
+	[ATTR_ID_dm_cnx_backoff_policy] = { ATTR_STUB_U32,
+					    { .u32 = LCZ_BLE_GW_DM_BACKOFF_CAPPED_EXPONENTIAL } },
+	[ATTR_ID_dm_cnx_backoff_max] = { ATTR_STUB_U32, { .u32 = 60 } },
+	[ATTR_ID_lwm2m_endpoint] = { ATTR_STUB_STRING, { .str = "gw-test" } },
+	/* Set at boot on hardware, native_posix has no SoC device ID */
+	[ATTR_ID_device_id] = { ATTR_STUB_STRING, { .str = "0000000000000001" } },
+	[ATTR_ID_memfault_transport] = { ATTR_STUB_U32, { .u32 = 1 } },
+	[ATTR_ID_load_path] = { ATTR_STUB_STRING, { .str = "/lfs1/enc/attr_load.txt" } },
+	[ATTR_ID_factory_load_path] = { ATTR_STUB_STRING,
+					{ .str = "/lfs1/enc/factory_load.txt" } },
+	[ATTR_ID_dump_path] = { ATTR_STUB_STRING, { .str = "/lfs1/enc/attr_dump.txt" } },
+	[ATTR_ID_smp_auth_req] = { ATTR_STUB_BOOL, { .b = true } },
+	[ATTR_ID_smp_auth_timeout] = { ATTR_STUB_U32, { .u32 = 300 } },
+};
+
+static union attr_stub_value values[ATTR_STUB_COUNT];
+static bool values_init;
+static atomic_t locks;
+static attr_id_t load_ids[ATTR_TABLE_SIZE];
+static size_t load_count;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static void values_init_once(void)
+{
+	size_t i;
+
+	if (!values_init) {
+		for (i = 0; i < ATTR_STUB_COUNT; i++) {
+			values[i] = ENTRIES[i].def;
+		}
+		values_init = true;
+	}
+}
+
+/* Returns the entry if it exists and has the type */
+static union attr_stub_value *lock_value(attr_id_t id, enum attr_stub_type type)
+{
+	atomic_inc(&locks);
+	values_init_once();
+
+	if (id >= ATTR_STUB_COUNT || ENTRIES[id].type != type) {
+		return NULL;
+	}
+
+	return &values[id];
+}
+
+static void broadcast_changed(const attr_id_t *ids, size_t count)
+{
+	attr_changed_msg_t *msg;
+
+	if (count == 0) {
+		return;
+	}
+
+	msg = BufferPool_Take(sizeof(attr_changed_msg_t));
+	if (msg == NULL) {
+		return;
+	}
+
+	msg->header.msgCode = FMC_ATTR_CHANGED;
+	msg->header.txId = FWK_ID_RESERVED;
+	msg->header.rxId = FWK_ID_RESERVED;
+	msg->count = MIN(count, ATTR_TABLE_SIZE);
+	memcpy(msg->list, ids, msg->count * sizeof(attr_id_t));
+	(void)Framework_Broadcast((FwkMsg_t *)msg, sizeof(attr_changed_msg_t));
+}
+
+static int set_value(attr_id_t id, enum attr_stub_type type, const void *value, size_t size)
+{
+	union attr_stub_value *v = lock_value(id, type);
+
+	if (v == NULL) {
+		return -EPERM;
+	}
+
+	if (memcmp(v, value, size) != 0) {
+		memcpy(v, value, size);
+		broadcast_changed(&id, 1);
+	}
+
+	return 0;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+uint32_t attr_get_uint32(attr_id_t id, uint32_t alt)
+{
+	union attr_stub_value *v = lock_value(id, ATTR_STUB_U32);
+
+	return (v != NULL) ? v->u32 : alt;
+}
+
+int32_t attr_get_signed32(attr_id_t id, int32_t alt)
+{
+	union attr_stub_value *v = lock_value(id, ATTR_STUB_S32);
+
+	return (v != NULL) ? v->s32 : alt;
+}
+
+const void *attr_get_quasi_static(attr_id_t id)
+{
+	union attr_stub_value *v;
+
+	v = lock_value(id, (id < ATTR_STUB_COUNT) ? ENTRIES[id].type : ATTR_STUB_NONE);
+	__ASSERT(v != NULL, "Unknown attribute %u", id);
+	return v;
+}
+
+int attr_set_uint32(attr_id_t id, uint32_t value)
+{
+	return set_value(id, ATTR_STUB_U32, &value, sizeof(value));
+}
+
+int attr_set_signed32(attr_id_t id, int32_t value)
+{
+	return set_value(id, ATTR_STUB_S32, &value, sizeof(value));
+}
+
+int attr_set_float(attr_id_t id, float value)
+{
+	return set_value(id, ATTR_STUB_FLOAT, &value, sizeof(value));
+}
+
+int attr_set_string(attr_id_t id, char const *value, size_t length)
+{
+	char str[ATTR_MAX_STR_LENGTH + 1] = { 0 };
+
+	if (length > ATTR_MAX_STR_LENGTH) {
+		return -EINVAL;
+	}
+
+	memcpy(str, value, length);
+	return set_value(id, ATTR_STUB_STRING, str, sizeof(str));
+}
+
+int attr_load(const char *abs_path, bool *modified)
+{
+	ARG_UNUSED(abs_path);
+
+	if (modified != NULL) {
+		*modified = (load_count > 0);
+	}
+	broadcast_changed(load_ids, load_count);
+	return 0;
+}
+
+int attr_prepare_then_dump(char **fstr, int type)
+{
+	static const char DUMP[] = "dm_cnx_delay=5\n";
+
+	ARG_UNUSED(type);
+
+	*fstr = k_malloc(sizeof(DUMP));
+	if (*fstr == NULL) {
+		return -ENOMEM;
+	}
+
+	strcpy(*fstr, DUMP);
+	return strlen(DUMP);
+}
+
+uint32_t attr_stub_locks(void)
+{
+	return (uint32_t)atomic_get(&locks);
+}
+
+void attr_stub_reset(void)
+{
+	attr_id_t changed[ATTR_STUB_COUNT];
+	size_t count = 0;
+	attr_id_t id;
+
+	values_init_once();
+	for (id = 0; id < ATTR_STUB_COUNT; id++) {
+		if (ENTRIES[id].type != ATTR_STUB_NONE &&
+		    memcmp(&values[id], &ENTRIES[id].def, sizeof(union attr_stub_value)) != 0) {
+			values[id] = ENTRIES[id].def;
+			changed[count++] = id;
+		}
+	}
+
+	load_count = 0;
+	broadcast_changed(changed, count);
+}
+
+void attr_stub_load_ids_set(const attr_id_t *ids, size_t count)
+{
+	load_count = MIN(count, ATTR_TABLE_SIZE);
+	memcpy(load_ids, ids, load_count * sizeof(attr_id_t));
+}
@@ -0,0 +1,53 @@
+/**
+ * @file date_time_stub.c
+ * @brief Date time stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <date_time.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+/* 2022-01-01 00:00:00 UTC */
+#define EPOCH_MS 1640995200000LL
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static uint32_t queries;
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int date_time_update_async(date_time_evt_handler_t evt_handler)
+{
+	struct date_time_evt evt = { .type = DATE_TIME_OBTAINED_NTP };
+
+	queries++;
+	if (evt_handler != NULL) {
+		evt_handler(&evt);
+	}
+
+	return 0;
+}
+
+int date_time_now(int64_t *unix_time_ms)
+{
+	*unix_time_ms = EPOCH_MS + k_uptime_get();
+	return 0;
+}
+
+uint32_t date_time_stub_queries(void)
+{
+	return queries;
+}
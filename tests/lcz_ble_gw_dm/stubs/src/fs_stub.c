@@ -0,0 +1,205 @@
+/**
+ * @file fs_stub.c
+ * @brief File system, encrypted file storage, LwM2M file management and script runner stubs
+ * for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <file_system_utilities.h>
+#include <encrypted_file_storage.h>
+#include <lcz_lwm2m_obj_fs_mgmt.h>
+#include <lcz_shell_script_runner.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define ENCRYPTED_DIR CONFIG_FSU_MOUNT_POINT "/enc/"
+#define SCRIPT_SUFFIX ".sh"
+#define MAX_EFS_FILES 4
+
+struct efs_file {
+	char path[FSU_MAX_ABS_PATH_SIZE + 1];
+	ssize_t size;
+};
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static struct efs_file efs_files[MAX_EFS_FILES];
+static lcz_lwm2m_obj_fs_mgmt_perm_cb_t perm_cb;
+static lcz_lwm2m_obj_fs_mgmt_exec_cb_t exec_cb;
+static uint32_t exec_completions;
+static int exec_last_result;
+static atomic_t scripts_run;
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int fsu_simplify_path(const char *path, char *simple_path)
+{
+	const char *p = path;
+	const char *end;
+	size_t out = 0;
+	size_t len;
+
+	if (path == NULL || path[0] != '/') {
+		return -EINVAL;
+	}
+
+	while (*p != '\0') {
+		while (*p == '/') {
+			p++;
+		}
+		end = p;
+		while (*end != '\0' && *end != '/') {
+			end++;
+		}
+		len = end - p;
+
+		if (len == 0 || (len == 1 && p[0] == '.')) {
+			/* Nothing to add */
+		} else if (len == 2 && p[0] == '.' && p[1] == '.') {
+			if (out == 0) {
+				return -EINVAL;
+			}
+			while (out > 0 && simple_path[--out] != '/') {
+			}
+		} else {
+			if (out + 1 + len > FSU_MAX_ABS_PATH_SIZE) {
+				return -EINVAL;
+			}
+			simple_path[out++] = '/';
+			memcpy(&simple_path[out], p, len);
+			out += len;
+		}
+		p = end;
+	}
+
+	if (out == 0) {
+		simple_path[out++] = '/';
+	}
+	simple_path[out] = '\0';
+	return 0;
+}
+
+ssize_t fsu_get_file_size_abs(const char *abs_path)
+{
+	ARG_UNUSED(abs_path);
+
+	return -ENOENT;
+}
+
+ssize_t fsu_write_abs(const char *abs_path, const void *data, size_t size)
+{
+	ARG_UNUSED(abs_path);
+	ARG_UNUSED(data);
+
+	return size;
+}
+
+bool efs_is_encrypted_path(const char *abs_path)
+{
+	return strncmp(abs_path, ENCRYPTED_DIR, strlen(ENCRYPTED_DIR)) == 0;
+}
+
+ssize_t efs_get_file_size(const char *abs_path)
+{
+	size_t i;
+
+	for (i = 0; i < MAX_EFS_FILES; i++) {
+		if (strcmp(efs_files[i].path, abs_path) == 0) {
+			return efs_files[i].size;
+		}
+	}
+
+	return -ENOENT;
+}
+
+void efs_stub_file_size_set(const char *abs_path, ssize_t size)
+{
+	struct efs_file *free_slot = NULL;
+	size_t i;
+
+	for (i = 0; i < MAX_EFS_FILES; i++) {
+		if (strcmp(efs_files[i].path, abs_path) == 0) {
+			free_slot = &efs_files[i];
+			break;
+		} else if (free_slot == NULL && efs_files[i].path[0] == '\0') {
+			free_slot = &efs_files[i];
+		}
+	}
+
+	__ASSERT(free_slot != NULL, "Too many files");
+	if (size < 0) {
+		free_slot->path[0] = '\0';
+	} else {
+		strncpy(free_slot->path, abs_path, FSU_MAX_ABS_PATH_SIZE);
+		free_slot->size = size;
+	}
+}
+
+void lcz_lwm2m_obj_fs_mgmt_reg_perm_cb(lcz_lwm2m_obj_fs_mgmt_perm_cb_t cb)
+{
+	perm_cb = cb;
+}
+
+void lcz_lwm2m_obj_fs_mgmt_reg_exec_cb(lcz_lwm2m_obj_fs_mgmt_exec_cb_t cb)
+{
+	exec_cb = cb;
+}
+
+void lcz_lwm2m_obj_fs_mgmt_exec_complete(int result)
+{
+	exec_completions++;
+	exec_last_result = result;
+}
+
+bool fs_mgmt_stub_permission_check(const char *path, bool write)
+{
+	return (perm_cb != NULL) ? perm_cb(path, write) : true;
+}
+
+int fs_mgmt_stub_exec(const char *path)
+{
+	return (exec_cb != NULL) ? exec_cb(path) : -EPERM;
+}
+
+uint32_t fs_mgmt_stub_exec_completions(int *last_result)
+{
+	if (last_result != NULL) {
+		*last_result = exec_last_result;
+	}
+
+	return exec_completions;
+}
+
+bool lcz_zsh_is_script(const char *abs_path)
+{
+	size_t len = strlen(abs_path);
+
+	return len > strlen(SCRIPT_SUFFIX) &&
+	       strcmp(&abs_path[len - strlen(SCRIPT_SUFFIX)], SCRIPT_SUFFIX) == 0;
+}
+
+int lcz_zsh_run_script(const char *abs_path, void *output)
+{
+	ARG_UNUSED(abs_path);
+	ARG_UNUSED(output);
+
+	atomic_inc(&scripts_run);
+	return 0;
+}
+
+uint32_t zsh_stub_scripts_run(void)
+{
+	return (uint32_t)atomic_get(&scripts_run);
+}
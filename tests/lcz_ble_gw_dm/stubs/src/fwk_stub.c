@@ -0,0 +1,182 @@
+/**
+ * @file fwk_stub.c
+ * @brief Framework stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <fwk_includes.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define MAX_TASKS 4
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static FwkMsgReceiver_t *receivers[MAX_TASKS];
+static size_t receiver_count;
+static struct fwk_stub_stats stats;
+static atomic_t send_failures;
+static struct k_spinlock lock;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static FwkMsgReceiver_t *find_receiver(FwkId_t id)
+{
+	size_t i;
+
+	for (i = 0; i < receiver_count; i++) {
+		if (receivers[i]->id == id) {
+			return receivers[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+void Framework_RegisterTask(FwkMsgTask_t *pMsgTask)
+{
+	k_spinlock_key_t key = k_spin_lock(&lock);
+
+	__ASSERT(receiver_count < MAX_TASKS, "Too many tasks");
+	receivers[receiver_count++] = &pMsgTask->rxer;
+	k_spin_unlock(&lock, key);
+}
+
+FwkStatus_t Framework_Send(FwkId_t RxId, FwkMsg_t *pMsg)
+{
+	FwkMsgReceiver_t *rxer = find_receiver(RxId);
+	atomic_val_t fail;
+
+	do {
+		fail = atomic_get(&send_failures);
+	} while (fail > 0 && !atomic_cas(&send_failures, fail, fail - 1));
+
+	if (fail > 0) {
+		stats.send_failures++;
+		return FWK_ERROR;
+	}
+
+	if (rxer == NULL || k_msgq_put(rxer->pQueue, &pMsg, K_NO_WAIT) != 0) {
+		return FWK_ERROR;
+	}
+
+	stats.sent++;
+	return FWK_SUCCESS;
+}
+
+FwkStatus_t Framework_Broadcast(FwkMsg_t *pMsg, size_t MsgSize)
+{
+	FwkMsg_t *copy;
+	uint64_t start;
+	bool accept;
+	size_t i;
+
+	for (i = 0; i < receiver_count; i++) {
+		if (receivers[i]->acceptBroadcast != NULL) {
+			start = gw_dm_stub_host_cycles();
+			accept = receivers[i]->acceptBroadcast(pMsg);
+			stats.filter_cycles += gw_dm_stub_host_cycles() - start;
+			if (!accept) {
+				stats.broadcast_filtered++;
+				continue;
+			}
+		}
+
+		copy = BufferPool_Take(MsgSize);
+		if (copy == NULL) {
+			continue;
+		}
+		memcpy(copy, pMsg, MsgSize);
+		copy->header.rxId = receivers[i]->id;
+		if (k_msgq_put(receivers[i]->pQueue, &copy, K_NO_WAIT) != 0) {
+			BufferPool_Free(copy);
+			continue;
+		}
+		stats.broadcast_queued++;
+	}
+
+	BufferPool_Free(pMsg);
+	return FWK_SUCCESS;
+}
+
+void Framework_MsgReceiver(FwkMsgReceiver_t *pRxer)
+{
+	FwkMsgHandler_t *handler;
+	DispatchResult_t result;
+	FwkMsg_t *pMsg;
+
+	if (k_msgq_get(pRxer->pQueue, &pMsg, pRxer->rxBlockTicks) != 0) {
+		return;
+	}
+
+	stats.dispatched[pRxer->id]++;
+	handler = pRxer->pMsgDispatcher(pMsg->header.msgCode);
+	if (handler == NULL) {
+		handler = Framework_UnknownMsgHandler;
+	}
+
+	result = handler(pRxer, pMsg);
+	if (result != DISPATCH_DO_NOT_FREE) {
+		BufferPool_Free(pMsg);
+	}
+}
+
+DispatchResult_t Framework_UnknownMsgHandler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+{
+	ARG_UNUSED(pMsgRxer);
+	ARG_UNUSED(pMsg);
+
+	return DISPATCH_ERROR;
+}
+
+void *BufferPool_Take(size_t Size)
+{
+	void *pBuffer = k_calloc(1, Size);
+
+	if (pBuffer != NULL) {
+		stats.buffers_outstanding++;
+	}
+
+	return pBuffer;
+}
+
+void BufferPool_Free(void *pBuffer)
+{
+	if (pBuffer != NULL) {
+		stats.buffers_outstanding--;
+		k_free(pBuffer);
+	}
+}
+
+void fwk_stub_stats_get(struct fwk_stub_stats *s)
+{
+	*s = stats;
+}
+
+void fwk_stub_stats_clear(void)
+{
+	int32_t outstanding = stats.buffers_outstanding;
+
+	memset(&stats, 0, sizeof(stats));
+	stats.buffers_outstanding = outstanding;
+}
+
+void fwk_stub_send_fail(uint32_t count)
+{
+	atomic_set(&send_failures, count);
+}
@@ -0,0 +1,170 @@
+/**
+ * @file lwm2m_stub.c
+ * @brief LwM2M client stub for the native_posix tests
+ *
+ * Connections complete when the test reports a client event.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/sys/slist.h>
+#include <lcz_lwm2m_client.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define CLIENTS 2
+/* Registration lifetime (seconds) read by the connection watchdog */
+#define LIFETIME_SECONDS 43200
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static sys_slist_t agents = SYS_SLIST_STATIC_INIT(&agents);
+static struct lwm2m_ctx contexts[CLIENTS];
+static bool connected[CLIENTS];
+static int connect_result;
+static struct lwm2m_stub_stats stats;
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_lwm2m_client_connect(int client_index, int security_index, uint16_t server_inst,
+			     char *endpoint_name, enum lcz_lwm2m_client_transport transport,
+			     int tls_tag, lcz_lwm2m_client_load_credentials_t load_credentials)
+{
+	ARG_UNUSED(security_index);
+	ARG_UNUSED(transport);
+
+	if (client_index < 0 || client_index >= CLIENTS) {
+		return -EINVAL;
+	}
+
+	stats.connects++;
+	strncpy(stats.endpoint, endpoint_name, sizeof(stats.endpoint) - 1);
+	if (connect_result < 0) {
+		return connect_result;
+	}
+
+	contexts[client_index].tls_tag = tls_tag;
+	contexts[client_index].srv_obj_inst = server_inst;
+	contexts[client_index].load_credentials = load_credentials;
+	if (load_credentials != NULL) {
+		stats.credential_loads++;
+		(void)load_credentials(&contexts[client_index]);
+	}
+
+	return 0;
+}
+
+int lcz_lwm2m_client_disconnect(int client_index, bool deregister)
+{
+	ARG_UNUSED(deregister);
+
+	if (client_index < 0 || client_index >= CLIENTS) {
+		return -EINVAL;
+	}
+
+	stats.disconnects++;
+	if (connected[client_index]) {
+		lwm2m_stub_event(client_index, false, LWM2M_RD_CLIENT_EVENT_DISCONNECT);
+	}
+
+	return 0;
+}
+
+bool lcz_lwm2m_client_is_connected(int client_index)
+{
+	return lwm2m_stub_connected(client_index);
+}
+
+int lcz_lwm2m_client_register_event_callback(struct lcz_lwm2m_client_event_callback_agent *agent)
+{
+	sys_slist_append(&agents, &agent->node);
+	return 0;
+}
+
+int lcz_lwm2m_client_device_set_err(int error_code)
+{
+	ARG_UNUSED(error_code);
+
+	return 0;
+}
+
+void lcz_lwm2m_client_register_get_time_callback(lwm2m_engine_get_data_cb_t cb)
+{
+	ARG_UNUSED(cb);
+}
+
+void lcz_lwm2m_client_register_pre_write_set_time_callback(lwm2m_engine_get_data_cb_t cb)
+{
+	ARG_UNUSED(cb);
+}
+
+void lcz_lwm2m_client_register_post_write_set_time_callback(lwm2m_engine_set_data_cb_t cb)
+{
+	ARG_UNUSED(cb);
+}
+
+void lcz_lwm2m_client_register_factory_default_callback(lwm2m_engine_execute_cb_t cb)
+{
+	ARG_UNUSED(cb);
+}
+
+int lcz_lwm2m_client_reboot(void)
+{
+	return 0;
+}
+
+int lwm2m_engine_get_u32(const char *pathstr, uint32_t *value)
+{
+	ARG_UNUSED(pathstr);
+
+	*value = LIFETIME_SECONDS;
+	return 0;
+}
+
+void lwm2m_rd_client_update(void)
+{
+	stats.reg_updates++;
+}
+
+void lwm2m_stub_stats_get(struct lwm2m_stub_stats *s)
+{
+	*s = stats;
+}
+
+void lwm2m_stub_stats_clear(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void lwm2m_stub_connect_result_set(int result)
+{
+	connect_result = result;
+}
+
+void lwm2m_stub_event(int index, bool is_connected, enum lwm2m_rd_client_event event)
+{
+	struct lcz_lwm2m_client_event_callback_agent *agent;
+
+	connected[index] = is_connected;
+	SYS_SLIST_FOR_EACH_CONTAINER (&agents, agent, node) {
+		if (agent->connected_callback != NULL) {
+			agent->connected_callback(&contexts[index], index, is_connected, event);
+		}
+	}
+}
+
+bool lwm2m_stub_connected(int index)
+{
+	return (index >= 0 && index < CLIENTS) ? connected[index] : false;
+}
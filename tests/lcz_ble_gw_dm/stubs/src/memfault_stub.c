@@ -0,0 +1,95 @@
+/**
+ * @file memfault_stub.c
+ * @brief Memfault stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <lcz_memfault.h>
+#include <memfault_ncs.h>
+#include <memfault/core/data_packetizer.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static atomic_t post_result;
+static atomic_t posts;
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_memfault_post_data_v2(uint8_t *buf, size_t buf_len)
+{
+	ARG_UNUSED(buf);
+	ARG_UNUSED(buf_len);
+
+	atomic_inc(&posts);
+	return (int)atomic_get(&post_result);
+}
+
+int lcz_memfault_save_data_to_file(const char *abs_path, uint8_t *buf, size_t buf_len,
+				   bool delete_first, bool save_coredump, size_t *file_size,
+				   bool *has_coredump)
+{
+	ARG_UNUSED(abs_path);
+	ARG_UNUSED(buf);
+	ARG_UNUSED(delete_first);
+	ARG_UNUSED(save_coredump);
+
+	if (file_size != NULL) {
+		*file_size = buf_len;
+	}
+	if (has_coredump != NULL) {
+		*has_coredump = false;
+	}
+
+	return 0;
+}
+
+int memfault_ncs_device_id_set(const char *device_id, size_t len)
+{
+	ARG_UNUSED(device_id);
+	ARG_UNUSED(len);
+
+	return 0;
+}
+
+bool memfault_packetizer_data_available(void)
+{
+	return false;
+}
+
+bool memfault_packetizer_get_chunk(void *buf, size_t *buf_len)
+{
+	ARG_UNUSED(buf);
+
+	*buf_len = 0;
+	return false;
+}
+
+void memfault_packetizer_abort(void)
+{
+}
+
+void memfault_packetizer_set_active_sources(uint32_t mask)
+{
+	ARG_UNUSED(mask);
+}
+
+void memfault_stub_post_result_set(int result)
+{
+	atomic_set(&post_result, result);
+}
+
+uint32_t memfault_stub_posts(void)
+{
+	return (uint32_t)atomic_get(&posts);
+}
@@ -0,0 +1,55 @@
+/**
+ * @file nm_stub.c
+ * @brief Network monitor stub for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/sys/slist.h>
+#include <lcz_network_monitor.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static sys_slist_t agents = SYS_SLIST_STATIC_INIT(&agents);
+static bool network_ready;
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+void lcz_nm_register_event_callback(struct lcz_nm_event_agent *agent)
+{
+	sys_slist_append(&agents, &agent->node);
+}
+
+bool lcz_nm_network_ready(void)
+{
+	return network_ready;
+}
+
+void nm_stub_set(bool ready)
+{
+	struct lcz_nm_event_agent *agent;
+
+	if (ready == network_ready) {
+		return;
+	}
+
+	network_ready = ready;
+	SYS_SLIST_FOR_EACH_CONTAINER (&agents, agent, node) {
+		agent->callback(ready ? LCZ_NM_EVENT_IFACE_DNS_ADDED : LCZ_NM_EVENT_IFACE_DOWN);
+	}
+}
+
+void nm_stub_set_silent(bool ready)
+{
+	network_ready = ready;
+}
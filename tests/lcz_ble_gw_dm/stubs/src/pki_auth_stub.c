@@ -0,0 +1,86 @@
+/**
+ * @file pki_auth_stub.c
+ * @brief PKI authentication and mcumgr stubs for the native_posix tests
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <stdio.h>
+#include <mgmt/mgmt.h>
+#include <lcz_pki_auth.h>
+#include <lcz_pki_auth_smp.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static const char *const STORE_DIRS[LCZ_PKI_AUTH_STORE__NUM] = {
+	[LCZ_PKI_AUTH_STORE_DEVICE_MANAGEMENT] = "dm",
+	[LCZ_PKI_AUTH_STORE_TELEMETRY] = "telem",
+};
+
+static const char *const FILE_NAMES[LCZ_PKI_AUTH_FILE__NUM] = {
+	[LCZ_PKI_AUTH_FILE_PRIVATE_KEY] = "key.der",
+	[LCZ_PKI_AUTH_FILE_PUBLIC_KEY] = "pub.der",
+	[LCZ_PKI_AUTH_FILE_CSR] = "csr.der",
+	[LCZ_PKI_AUTH_FILE_DEVICE_CERTIFICATE] = "cert.der",
+	[LCZ_PKI_AUTH_FILE_CA_CERTIFICATE] = "ca.der",
+};
+
+static mgmt_permission_cb_t permission_cb;
+static struct lcz_pki_auth_smp_periph_auth_callback_agent *auth_agent;
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int lcz_pki_auth_tls_credential_load(LCZ_PKI_AUTH_STORE_T store, int tag, bool root_ca_only)
+{
+	ARG_UNUSED(tag);
+	ARG_UNUSED(root_ca_only);
+
+	return (store < LCZ_PKI_AUTH_STORE__NUM) ? 0 : -EINVAL;
+}
+
+int lcz_pki_auth_file_name_get(LCZ_PKI_AUTH_STORE_T store, LCZ_PKI_AUTH_FILE_T file,
+			       char *name, size_t name_size)
+{
+	int len;
+
+	if (store >= LCZ_PKI_AUTH_STORE__NUM || file >= LCZ_PKI_AUTH_FILE__NUM) {
+		return -EINVAL;
+	}
+
+	len = snprintf(name, name_size, "%s/enc/%s/%s", CONFIG_FSU_MOUNT_POINT, STORE_DIRS[store],
+		       FILE_NAMES[file]);
+	return (len >= 0 && (size_t)len < name_size) ? 0 : -ENOMEM;
+}
+
+void lcz_pki_auth_smp_periph_register_handler(
+	struct lcz_pki_auth_smp_periph_auth_callback_agent *agent)
+{
+	auth_agent = agent;
+}
+
+void mgmt_register_permission_cb(mgmt_permission_cb_t cb)
+{
+	permission_cb = cb;
+}
+
+void smp_stub_auth_complete(bool status)
+{
+	if (auth_agent != NULL) {
+		auth_agent->cb(status);
+	}
+}
+
+bool smp_stub_permission_check(uint16_t group_id, uint16_t command_id)
+{
+	return (permission_cb != NULL) ? permission_cb(group_id, command_id) : true;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file posix_time_stub.c
+ * @brief clock_gettime() for the native_posix tests
+ *
+ * The module only reads the wall clock. The POSIX clock library isn't used on native_posix, so
+ * the clock is derived from the date time stub instead.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <zephyr/posix/time.h>
+#include <date_time.h>
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int clock_gettime(clockid_t clock_id, struct timespec *ts)
+{
+	int64_t ms;
+
+	if (clock_id == CLOCK_MONOTONIC) {
+		ms = k_uptime_get();
+	} else {
+		(void)date_time_now(&ms);
+	}
+
+	ts->tv_sec = ms / MSEC_PER_SEC;
+	ts->tv_nsec = (ms % MSEC_PER_SEC) * NSEC_PER_MSEC;
+	return 0;
+}
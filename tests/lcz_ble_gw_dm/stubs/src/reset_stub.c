@@ -0,0 +1,36 @@
+/**
+ * @file reset_stub.c
+ * @brief Software reset stub for the native_posix tests, resets are only counted
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <zephyr/zephyr.h>
+#include <lcz_software_reset.h>
+
+#include "gw_dm_stubs.h"
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static atomic_t resets;
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+void lcz_software_reset_after_assert(uint32_t delay_ms)
+{
+	ARG_UNUSED(delay_ms);
+
+	atomic_inc(&resets);
+}
+
+uint32_t reset_stub_count(void)
+{
+	return (uint32_t)atomic_get(&resets);
+}
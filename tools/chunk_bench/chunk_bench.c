@@ -0,0 +1,360 @@
+/**
+ * @file chunk_bench.c
+ * @brief Host throughput benchmark of the Memfault chunk pipeline
+ *
+ * Streams data to a stand-in server on the loopback interface, once with a single buffer
+ * (read a chunk, then send it) and once with the two-buffer pipeline of lcz_ble_gw_dm_chunk.c
+ * (read the next chunk while the current one is sent). Reading a chunk costs a fixed time per
+ * KiB to model the packetizer reading a coredump from flash. The server models the link: each
+ * chunk takes its transfer time at the configured rate plus one round trip before it is
+ * acknowledged, like an HTTP POST per chunk.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define BUF_COUNT 2
+#define MAX_SIZES 8
+#define MAX_CHUNK_SIZE 65536
+
+struct options {
+	uint32_t bytes;
+	uint32_t rtt_ms;
+	uint32_t rate;
+	uint32_t read_us_per_kib;
+	uint32_t sizes[MAX_SIZES];
+	int size_count;
+};
+
+struct stream {
+	int sock;
+	uint32_t chunk_size;
+	uint32_t remaining;
+	uint8_t bufs[BUF_COUNT][MAX_CHUNK_SIZE];
+	uint32_t lens[BUF_COUNT];
+	sem_t free_sem;
+	sem_t full_sem;
+};
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static struct options opts = {
+	.bytes = 64 * 1024,
+	.rtt_ms = 40,
+	.rate = 64 * 1024,
+	.read_us_per_kib = 8000,
+	.sizes = { 512, 1024, 2048, 4096 },
+	.size_count = 4,
+};
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static int64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void sleep_us(int64_t us)
+{
+	struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+
+	while (nanosleep(&ts, &ts) != 0) {
+	}
+}
+
+static bool recv_all(int sock, void *buf, size_t len)
+{
+	uint8_t *p = buf;
+	ssize_t n;
+
+	while (len > 0) {
+		n = recv(sock, p, len, 0);
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		len -= (size_t)n;
+	}
+	return true;
+}
+
+static bool send_all(int sock, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+	ssize_t n;
+
+	while (len > 0) {
+		n = send(sock, p, len, 0);
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		len -= (size_t)n;
+	}
+	return true;
+}
+
+/* Stand-in server, acknowledges each chunk after the link time */
+static void *server_thread(void *arg)
+{
+	static uint8_t buf[MAX_CHUNK_SIZE];
+	int sock = *(int *)arg;
+	uint32_t len;
+	uint8_t ack = 0;
+
+	while (recv_all(sock, &len, sizeof(len)) && len <= sizeof(buf) &&
+	       recv_all(sock, buf, len)) {
+		sleep_us(((int64_t)len * 1000000 / opts.rate) + ((int64_t)opts.rtt_ms * 1000));
+		if (!send_all(sock, &ack, sizeof(ack))) {
+			break;
+		}
+	}
+
+	close(sock);
+	return NULL;
+}
+
+static int connect_server(pthread_t *server)
+{
+	static int server_sock;
+	struct sockaddr_in addr = { .sin_family = AF_INET };
+	socklen_t addr_len = sizeof(addr);
+	int listen_sock;
+	int sock;
+	int one = 1;
+
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	listen_sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_sock < 0 || bind(listen_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listen_sock, 1) < 0 ||
+	    getsockname(listen_sock, (struct sockaddr *)&addr, &addr_len) < 0) {
+		perror("server");
+		return -1;
+	}
+
+	sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		perror("connect");
+		return -1;
+	}
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	server_sock = accept(listen_sock, NULL, NULL);
+	close(listen_sock);
+	if (server_sock < 0) {
+		perror("accept");
+		return -1;
+	}
+	setsockopt(server_sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	pthread_create(server, NULL, server_thread, &server_sock);
+	return sock;
+}
+
+/* Model of the packetizer, returns false when there is no more data */
+static bool read_chunk(struct stream *s, uint8_t *buf, uint32_t *len)
+{
+	if (s->remaining == 0) {
+		return false;
+	}
+
+	*len = (s->remaining < s->chunk_size) ? s->remaining : s->chunk_size;
+	memset(buf, (int)(s->remaining & 0xff), *len);
+	s->remaining -= *len;
+	sleep_us(((int64_t)*len * opts.read_us_per_kib) / 1024);
+	return true;
+}
+
+static bool send_chunk(struct stream *s, const uint8_t *buf, uint32_t len)
+{
+	uint8_t ack;
+
+	return send_all(s->sock, &len, sizeof(len)) && send_all(s->sock, buf, len) &&
+	       recv_all(s->sock, &ack, sizeof(ack));
+}
+
+/* Same hand-off as chunk_thread() in lcz_ble_gw_dm_chunk.c */
+static void *packetizer_thread(void *arg)
+{
+	struct stream *s = arg;
+	uint32_t len;
+	bool more;
+	int slot;
+
+	for (slot = 0;; slot = (slot + 1) % BUF_COUNT) {
+		sem_wait(&s->free_sem);
+		more = read_chunk(s, s->bufs[slot], &len);
+		s->lens[slot] = more ? len : 0;
+		sem_post(&s->full_sem);
+		if (!more) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+static bool run_sequential(struct stream *s)
+{
+	uint32_t len;
+
+	while (read_chunk(s, s->bufs[0], &len)) {
+		if (!send_chunk(s, s->bufs[0], len)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool run_pipelined(struct stream *s)
+{
+	pthread_t packetizer;
+	bool ok = true;
+	int slot;
+
+	sem_init(&s->free_sem, 0, BUF_COUNT);
+	sem_init(&s->full_sem, 0, 0);
+	pthread_create(&packetizer, NULL, packetizer_thread, s);
+
+	for (slot = 0;; slot = (slot + 1) % BUF_COUNT) {
+		sem_wait(&s->full_sem);
+		if (s->lens[slot] == 0) {
+			break;
+		}
+		if (ok) {
+			ok = send_chunk(s, s->bufs[slot], s->lens[slot]);
+		}
+		sem_post(&s->free_sem);
+	}
+
+	pthread_join(packetizer, NULL);
+	sem_destroy(&s->free_sem);
+	sem_destroy(&s->full_sem);
+	return ok;
+}
+
+/* Returns the throughput in bytes per second, 0 on error */
+static uint32_t run(int buffers, uint32_t chunk_size)
+{
+	static struct stream s;
+	pthread_t server;
+	int64_t start;
+	int64_t elapsed;
+	bool ok;
+
+	s.sock = connect_server(&server);
+	if (s.sock < 0) {
+		return 0;
+	}
+	s.chunk_size = chunk_size;
+	s.remaining = opts.bytes;
+
+	start = now_us();
+	ok = (buffers == 1) ? run_sequential(&s) : run_pipelined(&s);
+	elapsed = now_us() - start;
+
+	shutdown(s.sock, SHUT_WR);
+	pthread_join(server, NULL);
+	close(s.sock);
+
+	if (!ok || elapsed <= 0) {
+		return 0;
+	}
+	return (uint32_t)(((int64_t)opts.bytes * 1000000) / elapsed);
+}
+
+static bool parse_sizes(const char *arg)
+{
+	char *end;
+
+	opts.size_count = 0;
+	while (*arg != '\0' && opts.size_count < MAX_SIZES) {
+		opts.sizes[opts.size_count] = (uint32_t)strtoul(arg, &end, 0);
+		if (end == arg || opts.sizes[opts.size_count] == 0 ||
+		    opts.sizes[opts.size_count] > MAX_CHUNK_SIZE) {
+			return false;
+		}
+		opts.size_count++;
+		arg = (*end == ',') ? end + 1 : end;
+	}
+	return opts.size_count > 0;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [options]\n"
+	       "  --bytes=N     data to upload (%u)\n"
+	       "  --rtt=MS      round trip time per chunk (%u)\n"
+	       "  --rate=BPS    link rate in bytes per second (%u)\n"
+	       "  --read=US     packetizer time per KiB read (%u)\n"
+	       "  --sizes=LIST  comma separated chunk sizes, at most %d\n",
+	       name, opts.bytes, opts.rtt_ms, opts.rate, opts.read_us_per_kib, MAX_SIZES);
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int main(int argc, char *argv[])
+{
+	uint32_t sequential;
+	uint32_t pipelined;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--bytes=", 8) == 0) {
+			opts.bytes = (uint32_t)strtoul(argv[i] + 8, NULL, 0);
+		} else if (strncmp(argv[i], "--rtt=", 6) == 0) {
+			opts.rtt_ms = (uint32_t)strtoul(argv[i] + 6, NULL, 0);
+		} else if (strncmp(argv[i], "--rate=", 7) == 0) {
+			opts.rate = (uint32_t)strtoul(argv[i] + 7, NULL, 0);
+		} else if (strncmp(argv[i], "--read=", 7) == 0) {
+			opts.read_us_per_kib = (uint32_t)strtoul(argv[i] + 7, NULL, 0);
+		} else if (strncmp(argv[i], "--sizes=", 8) == 0 && parse_sizes(argv[i] + 8)) {
+			continue;
+		} else {
+			usage(argv[0]);
+			return (strcmp(argv[i], "--help") == 0) ? 0 : 1;
+		}
+	}
+	if (opts.rate == 0) {
+		opts.rate = 1;
+	}
+
+	printf("chunk_size,sequential_bytes_per_s,pipelined_bytes_per_s,speedup\n");
+	for (i = 0; i < opts.size_count; i++) {
+		sequential = run(1, opts.sizes[i]);
+		pipelined = run(BUF_COUNT, opts.sizes[i]);
+		if (sequential == 0 || pipelined == 0) {
+			fprintf(stderr, "Run failed\n");
+			return 1;
+		}
+		printf("%u,%u,%u,%.2f\n", opts.sizes[i], sequential, pipelined,
+		       (double)pipelined / sequential);
+	}
+
+	return 0;
+}
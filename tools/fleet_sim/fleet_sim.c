@@ -0,0 +1,545 @@
+/**
+ * @file fleet_sim.c
+ * @brief Host simulation of a fleet of gateways reconnecting to the DM server
+ *
+ * Every gateway runs a model of the connection path of the gateway FSM in
+ * lcz_ble_gw_dm_task.c (wait before DM connection, connect, wait for connection,
+ * retry and backoff, idle stay and the connection reboot watchdog) using the
+ * same backoff module as the target. All gateways lose the network at time 0
+ * and regain it after the outage. The server accepts a limited number of
+ * handshakes per second, attempts over the limit time out and accepted
+ * attempts fail with a configurable probability.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcz_ble_gw_dm_backoff.h"
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+/* Same as DM_CONNECTION_DELAY_MIN_RAND in the task */
+#define DM_CONNECTION_DELAY_MIN_RAND 30
+#define MAX_SWEEP 8
+
+enum gw_state {
+	GW_CONNECTED = 0,
+	GW_WAIT_FOR_NETWORK,
+	GW_WAIT_BEFORE_DM_CONNECTION,
+	GW_WAIT_FOR_CONNECTION,
+	GW_IDLE_STAY,
+	GW_BOOTING,
+};
+
+enum handshake_result {
+	HANDSHAKE_OK = 0,
+	HANDSHAKE_FAILED,
+	HANDSHAKE_DROPPED,
+};
+
+struct gw {
+	enum gw_state state;
+	/* Time of the next state event (seconds) */
+	uint32_t deadline;
+	/* Time the connection reboot watchdog fires */
+	uint32_t watchdog;
+	/* Result of the handshake in progress */
+	enum handshake_result handshake;
+	uint32_t seq;
+	uint32_t cnx_delay;
+	uint32_t delay;
+	uint32_t cnx_tries;
+	struct lcz_ble_gw_dm_backoff backoff;
+};
+
+struct event {
+	uint32_t time;
+	uint32_t id;
+	uint32_t seq;
+};
+
+struct sim_config {
+	uint32_t gateways;
+	uint32_t duration;
+	uint32_t outage;
+	uint32_t net_jitter;
+	uint32_t delay_max;
+	uint32_t retries;
+	uint32_t backoff_retries;
+	float multiplier;
+	uint32_t ceiling;
+	uint32_t timeout;
+	uint32_t reboot;
+	uint32_t boot;
+	uint32_t capacity;
+	float fail_rate;
+	uint32_t latency;
+	uint32_t seed;
+	bool series;
+	int policies[MAX_SWEEP];
+	int num_policies;
+	uint32_t delays[MAX_SWEEP];
+	int num_delays;
+};
+
+struct sim_result {
+	uint64_t attempts;
+	uint64_t failures;
+	uint32_t peak_attempts;
+	uint32_t peak_time;
+	uint32_t reboots;
+	uint32_t connected;
+	uint32_t recovery;
+	bool recovered;
+};
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static const char *POLICY_NAMES[LCZ_BLE_GW_DM_BACKOFF_POLICY__NUM] = {
+	[LCZ_BLE_GW_DM_BACKOFF_CAPPED_EXPONENTIAL] = "capped_exp",
+	[LCZ_BLE_GW_DM_BACKOFF_FULL_JITTER] = "full_jitter",
+	[LCZ_BLE_GW_DM_BACKOFF_DECORRELATED_JITTER] = "decorrelated",
+};
+
+static uint32_t rng_state;
+
+static struct gw *gws;
+static struct event *heap;
+static size_t heap_len;
+static size_t heap_size;
+static uint32_t *attempts_per_second;
+
+/* Server handshakes accepted in the current second */
+static uint32_t server_second;
+static uint32_t server_used;
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static uint32_t rand32(void)
+{
+	/* xorshift32 */
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static bool chance(float probability)
+{
+	return ((float)rand32() / 4294967296.0f) < probability;
+}
+
+static void heap_push(uint32_t time, uint32_t id, uint32_t seq)
+{
+	size_t i;
+	struct event e = { time, id, seq };
+
+	if (heap_len == heap_size) {
+		heap_size = (heap_size == 0) ? 1024 : heap_size * 2;
+		heap = realloc(heap, heap_size * sizeof(*heap));
+		if (heap == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (i = heap_len++; i > 0 && heap[(i - 1) / 2].time > time; i = (i - 1) / 2) {
+		heap[i] = heap[(i - 1) / 2];
+	}
+	heap[i] = e;
+}
+
+static struct event heap_pop(void)
+{
+	struct event top = heap[0];
+	struct event last = heap[--heap_len];
+	size_t i = 0;
+	size_t child;
+
+	while ((child = (2 * i) + 1) < heap_len) {
+		if (child + 1 < heap_len && heap[child + 1].time < heap[child].time) {
+			child++;
+		}
+		if (heap[child].time >= last.time) {
+			break;
+		}
+		heap[i] = heap[child];
+		i = child;
+	}
+	if (heap_len > 0) {
+		heap[i] = last;
+	}
+
+	return top;
+}
+
+/* Each gateway has a single live event, older ones are skipped when popped */
+static void schedule(uint32_t id, uint32_t deadline)
+{
+	struct gw *g = &gws[id];
+	uint32_t next = (deadline < g->watchdog) ? deadline : g->watchdog;
+
+	g->deadline = deadline;
+	heap_push(next, id, ++g->seq);
+}
+
+static enum handshake_result server_handshake(uint32_t now, const struct sim_config *cfg)
+{
+	if (now != server_second) {
+		server_second = now;
+		server_used = 0;
+	}
+
+	if (server_used >= cfg->capacity) {
+		return HANDSHAKE_DROPPED;
+	}
+	server_used++;
+
+	return chance(cfg->fail_rate) ? HANDSHAKE_FAILED : HANDSHAKE_OK;
+}
+
+static void fresh_boot(struct gw *g, uint32_t now, const struct sim_config *cfg)
+{
+	g->cnx_tries = 0;
+	g->delay = g->cnx_delay;
+	lcz_ble_gw_dm_backoff_reset(&g->backoff);
+	g->watchdog = now + cfg->reboot;
+}
+
+/* Models the post Memfault data state: retry limit and backoff */
+static void start_connection_cycle(uint32_t id, uint32_t now, const struct sim_config *cfg,
+				   int policy)
+{
+	struct gw *g = &gws[id];
+
+	if (g->cnx_tries >= cfg->retries + cfg->backoff_retries) {
+		g->state = GW_IDLE_STAY;
+		schedule(id, UINT32_MAX);
+		return;
+	} else if (g->cnx_tries >= cfg->retries) {
+		lcz_ble_gw_dm_backoff_configure(&g->backoff, policy, g->cnx_delay, cfg->ceiling,
+						cfg->multiplier);
+		g->delay = lcz_ble_gw_dm_backoff_next(&g->backoff);
+	}
+
+	g->state = GW_WAIT_BEFORE_DM_CONNECTION;
+	schedule(id, now + g->delay);
+}
+
+static void gw_event(uint32_t id, uint32_t now, const struct sim_config *cfg, int policy,
+		     struct sim_result *res)
+{
+	struct gw *g = &gws[id];
+
+	if (now >= g->watchdog && g->state != GW_CONNECTED) {
+		res->reboots++;
+		fresh_boot(g, now + cfg->boot, cfg);
+		g->state = GW_BOOTING;
+		schedule(id, now + cfg->boot + (rand32() % (cfg->net_jitter + 1)));
+		return;
+	}
+
+	switch (g->state) {
+	case GW_WAIT_FOR_NETWORK:
+	case GW_BOOTING:
+		start_connection_cycle(id, now, cfg, policy);
+		break;
+	case GW_WAIT_BEFORE_DM_CONNECTION:
+		res->attempts++;
+		if (now < cfg->duration) {
+			attempts_per_second[now]++;
+		}
+		/* Dropped handshakes time out, others complete after the round trip */
+		g->handshake = server_handshake(now, cfg);
+		schedule(id, now + ((g->handshake == HANDSHAKE_DROPPED) ? cfg->timeout :
+									  cfg->latency));
+		g->state = GW_WAIT_FOR_CONNECTION;
+		break;
+	case GW_WAIT_FOR_CONNECTION:
+		if (g->handshake == HANDSHAKE_OK) {
+			g->state = GW_CONNECTED;
+			g->cnx_tries = 0;
+			g->delay = g->cnx_delay;
+			lcz_ble_gw_dm_backoff_reset(&g->backoff);
+			g->watchdog = UINT32_MAX;
+			res->connected++;
+			if (res->connected == cfg->gateways) {
+				res->recovered = true;
+				res->recovery = now - cfg->outage;
+			}
+		} else {
+			res->failures++;
+			g->cnx_tries++;
+			start_connection_cycle(id, now, cfg, policy);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void run(const struct sim_config *cfg, int policy, uint32_t delay, struct sim_result *res)
+{
+	struct event e;
+	uint32_t id;
+	uint32_t t;
+
+	memset(res, 0, sizeof(*res));
+	memset(attempts_per_second, 0, cfg->duration * sizeof(*attempts_per_second));
+	rng_state = (cfg->seed == 0) ? 1 : cfg->seed;
+	heap_len = 0;
+	server_second = UINT32_MAX;
+	server_used = 0;
+
+	for (id = 0; id < cfg->gateways; id++) {
+		struct gw *g = &gws[id];
+
+		memset(g, 0, sizeof(*g));
+		lcz_ble_gw_dm_backoff_init(&g->backoff, rand32);
+		/* A delay of 0 is randomized once per gateway, see random_connect_handler() */
+		g->cnx_delay = (delay == 0) ? lcz_ble_gw_dm_backoff_rand_range(
+						      rand32, DM_CONNECTION_DELAY_MIN_RAND, cfg->delay_max) :
+					      delay;
+		/* Network lost at time 0, the reboot watchdog restarts on disconnect */
+		fresh_boot(g, 0, cfg);
+		g->state = GW_WAIT_FOR_NETWORK;
+		schedule(id, cfg->outage + (rand32() % (cfg->net_jitter + 1)));
+	}
+
+	while (heap_len > 0) {
+		e = heap_pop();
+		if (e.time >= cfg->duration || res->recovered) {
+			break;
+		}
+		if (e.seq == gws[e.id].seq) {
+			gw_event(e.id, e.time, cfg, policy, res);
+		}
+	}
+
+	for (t = 0; t < cfg->duration; t++) {
+		if (attempts_per_second[t] > res->peak_attempts) {
+			res->peak_attempts = attempts_per_second[t];
+			res->peak_time = t;
+		}
+	}
+}
+
+static void print_series(const struct sim_config *cfg, int policy, uint32_t delay)
+{
+	uint32_t t;
+	uint32_t last = 0;
+
+	for (t = 0; t < cfg->duration; t++) {
+		if (attempts_per_second[t] != 0) {
+			last = t;
+		}
+	}
+	for (t = cfg->outage; t <= last; t++) {
+		printf("series,%s,%u,%u,%u\n", POLICY_NAMES[policy], delay, t - cfg->outage,
+		       attempts_per_second[t]);
+	}
+}
+
+static int parse_list(const char *value, bool policy, struct sim_config *cfg)
+{
+	char buf[128];
+	char *tok;
+	int p;
+
+	snprintf(buf, sizeof(buf), "%s", value);
+	for (tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+		if (!policy) {
+			if (cfg->num_delays == MAX_SWEEP) {
+				return -1;
+			}
+			cfg->delays[cfg->num_delays++] = (uint32_t)strtoul(tok, NULL, 0);
+			continue;
+		}
+		for (p = 0; p < LCZ_BLE_GW_DM_BACKOFF_POLICY__NUM; p++) {
+			if (strcmp(tok, "all") == 0 || strcmp(tok, POLICY_NAMES[p]) == 0) {
+				if (cfg->num_policies == MAX_SWEEP) {
+					return -1;
+				}
+				cfg->policies[cfg->num_policies++] = p;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	printf("usage: %s [--option=value ...]\n"
+	       "  --gateways=N         number of gateways (10000)\n"
+	       "  --outage=S           network outage length (600)\n"
+	       "  --net_jitter=S       spread of network reattach after the outage (60)\n"
+	       "  --delay=S[,S...]     dm_cnx_delay, 0 randomizes per gateway (0)\n"
+	       "  --delay_max=S        dm_cnx_delay_max (300)\n"
+	       "  --retries=N          dm_cnx_retries (3)\n"
+	       "  --backoff_retries=N  dm_cnx_backoff_retries (5)\n"
+	       "  --multi=F            dm_cnx_backoff_multi (2.0)\n"
+	       "  --policy=P[,P...]    capped_exp, full_jitter, decorrelated or all (all)\n"
+	       "  --ceiling=S          dm_cnx_backoff_max (3600)\n"
+	       "  --timeout=S          connection timeout (60)\n"
+	       "  --reboot=S           connection reboot watchdog (3600)\n"
+	       "  --boot=S             time from reboot to network search (30)\n"
+	       "  --capacity=N         server handshakes per second (50)\n"
+	       "  --fail=F             handshake failure probability (0.01)\n"
+	       "  --latency=S          handshake round trip (2)\n"
+	       "  --duration=S         simulated time (172800)\n"
+	       "  --seed=N             random seed (1)\n"
+	       "  --series             print connection attempts per second\n",
+	       name);
+}
+
+static int parse_args(int argc, char **argv, struct sim_config *cfg)
+{
+	char *value;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--", 2) != 0) {
+			return -1;
+		}
+		if (strcmp(argv[i], "--series") == 0) {
+			cfg->series = true;
+			continue;
+		}
+		value = strchr(argv[i], '=');
+		if (value == NULL) {
+			return -1;
+		}
+		*value++ = '\0';
+
+#define ARG_U32(name, field)                                                                       \
+	if (strcmp(argv[i] + 2, name) == 0) {                                                      \
+		cfg->field = (uint32_t)strtoul(value, NULL, 0);                                    \
+		continue;                                                                          \
+	}
+		ARG_U32("gateways", gateways)
+		ARG_U32("outage", outage)
+		ARG_U32("net_jitter", net_jitter)
+		ARG_U32("delay_max", delay_max)
+		ARG_U32("retries", retries)
+		ARG_U32("backoff_retries", backoff_retries)
+		ARG_U32("ceiling", ceiling)
+		ARG_U32("timeout", timeout)
+		ARG_U32("reboot", reboot)
+		ARG_U32("boot", boot)
+		ARG_U32("capacity", capacity)
+		ARG_U32("latency", latency)
+		ARG_U32("duration", duration)
+		ARG_U32("seed", seed)
+#undef ARG_U32
+		if (strcmp(argv[i] + 2, "multi") == 0) {
+			cfg->multiplier = strtof(value, NULL);
+		} else if (strcmp(argv[i] + 2, "fail") == 0) {
+			cfg->fail_rate = strtof(value, NULL);
+		} else if (strcmp(argv[i] + 2, "delay") == 0) {
+			cfg->num_delays = 0;
+			if (parse_list(value, false, cfg) < 0) {
+				return -1;
+			}
+		} else if (strcmp(argv[i] + 2, "policy") == 0) {
+			cfg->num_policies = 0;
+			if (parse_list(value, true, cfg) < 0 || cfg->num_policies == 0) {
+				return -1;
+			}
+		} else {
+			return -1;
+		}
+	}
+
+	if (cfg->gateways == 0 || cfg->duration <= cfg->outage || cfg->capacity == 0 ||
+	    cfg->delay_max < DM_CONNECTION_DELAY_MIN_RAND) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int main(int argc, char **argv)
+{
+	struct sim_config cfg = {
+		.gateways = 10000,
+		.duration = 172800,
+		.outage = 600,
+		.net_jitter = 60,
+		.delay_max = 300,
+		.retries = 3,
+		.backoff_retries = 5,
+		.multiplier = 2.0f,
+		.ceiling = 3600,
+		.timeout = 60,
+		.reboot = 3600,
+		.boot = 30,
+		.capacity = 50,
+		.fail_rate = 0.01f,
+		.latency = 2,
+		.seed = 1,
+		.policies = { LCZ_BLE_GW_DM_BACKOFF_CAPPED_EXPONENTIAL,
+			      LCZ_BLE_GW_DM_BACKOFF_FULL_JITTER,
+			      LCZ_BLE_GW_DM_BACKOFF_DECORRELATED_JITTER },
+		.num_policies = 3,
+		.delays = { 0 },
+		.num_delays = 1,
+	};
+	struct sim_result res;
+	int p;
+	int d;
+
+	if (parse_args(argc, argv, &cfg) < 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	gws = calloc(cfg.gateways, sizeof(*gws));
+	attempts_per_second = calloc(cfg.duration, sizeof(*attempts_per_second));
+	if (gws == NULL || attempts_per_second == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("policy,delay,attempts,retries,peak_attempts_per_s,peak_at_s,reboots,"
+	       "connected,recovery_s\n");
+	for (p = 0; p < cfg.num_policies; p++) {
+		for (d = 0; d < cfg.num_delays; d++) {
+			run(&cfg, cfg.policies[p], cfg.delays[d], &res);
+			printf("%s,%u,%llu,%llu,%u,%u,%u,%u,", POLICY_NAMES[cfg.policies[p]],
+			       cfg.delays[d], (unsigned long long)res.attempts,
+			       (unsigned long long)res.failures, res.peak_attempts,
+			       (res.peak_time >= cfg.outage) ? res.peak_time - cfg.outage : 0,
+			       res.reboots, res.connected);
+			if (res.recovered) {
+				printf("%u\n", res.recovery);
+			} else {
+				printf("none\n");
+			}
+			if (cfg.series) {
+				print_series(&cfg, cfg.policies[p], cfg.delays[d]);
+			}
+		}
+	}
+
+	free(heap);
+	free(attempts_per_second);
+	free(gws);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file mflt_store_read.c
+ * @brief Host reader of the Memfault segment store (lcz_ble_gw_dm_mflt_store.h)
+ *
+ * Segment files are sorted by sequence number and every chunk is printed oldest first. Reading
+ * a segment stops at the first record that is truncated or has a bad CRC.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+#define STORE_MAGIC 0x3153464d
+#define STORE_VERSION 1
+#define SEG_HEADER_SIZE 12
+#define REC_HEADER_SIZE 8
+#define MAX_CHUNK_SIZE 65535
+
+struct segment {
+	const char *path;
+	uint32_t seq;
+	uint8_t cls;
+};
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+static const char *const class_names[] = { "data", "coredump" };
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static uint32_t get_le16(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return get_le16(p) | (get_le16(p + 2) << 16);
+}
+
+static uint32_t crc32_ieee(const uint8_t *data, size_t len)
+{
+	uint32_t crc = 0xffffffff;
+	int i;
+
+	while (len-- > 0) {
+		crc ^= *data++;
+		for (i = 0; i < 8; i++) {
+			crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+static bool read_header(const char *path, struct segment *seg)
+{
+	uint8_t hdr[SEG_HEADER_SIZE];
+	FILE *f = fopen(path, "rb");
+	bool ok;
+
+	if (f == NULL) {
+		perror(path);
+		return false;
+	}
+	ok = (fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr) && get_le32(hdr) == STORE_MAGIC &&
+	      hdr[4] == STORE_VERSION && hdr[5] < (sizeof(class_names) / sizeof(class_names[0])));
+	fclose(f);
+	if (!ok) {
+		fprintf(stderr, "%s: not a segment\n", path);
+		return false;
+	}
+
+	seg->path = path;
+	seg->cls = hdr[5];
+	seg->seq = get_le32(&hdr[8]);
+	return true;
+}
+
+static int compare_seq(const void *a, const void *b)
+{
+	uint32_t sa = ((const struct segment *)a)->seq;
+	uint32_t sb = ((const struct segment *)b)->seq;
+
+	return (sa > sb) - (sa < sb);
+}
+
+static void print_segment(const struct segment *seg, bool hex)
+{
+	static uint8_t chunk[MAX_CHUNK_SIZE];
+	uint8_t rec[REC_HEADER_SIZE];
+	uint32_t offset = SEG_HEADER_SIZE;
+	uint32_t len;
+	uint32_t i;
+	FILE *f = fopen(seg->path, "rb");
+
+	if (f == NULL || fseek(f, offset, SEEK_SET) != 0) {
+		perror(seg->path);
+		return;
+	}
+
+	while (fread(rec, 1, sizeof(rec), f) == sizeof(rec)) {
+		len = get_le16(rec);
+		if (len == 0 || fread(chunk, 1, len, f) != len ||
+		    crc32_ieee(chunk, len) != get_le32(&rec[4])) {
+			fprintf(stderr, "%s: bad record at %u\n", seg->path, offset);
+			break;
+		}
+
+		printf("%u,%s,%u,%u", seg->seq, class_names[seg->cls], offset, len);
+		if (hex) {
+			printf(",");
+			for (i = 0; i < len; i++) {
+				printf("%02x", chunk[i]);
+			}
+		}
+		printf("\n");
+		offset += sizeof(rec) + len;
+	}
+
+	fclose(f);
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int main(int argc, char *argv[])
+{
+	struct segment *segs;
+	bool hex = false;
+	int count = 0;
+	int i;
+
+	segs = calloc(argc, sizeof(*segs));
+	if (segs == NULL) {
+		return 1;
+	}
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--hex") == 0) {
+			hex = true;
+		} else if (argv[i][0] == '-') {
+			printf("Usage: %s [--hex] segment...\n", argv[0]);
+			return (strcmp(argv[i], "--help") == 0) ? 0 : 1;
+		} else if (read_header(argv[i], &segs[count])) {
+			count++;
+		}
+	}
+
+	qsort(segs, count, sizeof(*segs), compare_seq);
+
+	printf("seq,class,offset,length%s\n", hex ? ",chunk" : "");
+	for (i = 0; i < count; i++) {
+		print_segment(&segs[i], hex);
+	}
+
+	free(segs);
+	return 0;
+}
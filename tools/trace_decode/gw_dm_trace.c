@@ -0,0 +1,185 @@
+/**
+ * @file gw_dm_trace.c
+ * @brief Host decoder for the gateway state transition trace
+ *
+ * Reads a trace dumped by lcz_ble_gw_dm_trace_dump() (see lcz_ble_gw_dm_trace.h) and prints
+ * one CSV row per transition. State names are taken from the dump so that the decoder doesn't
+ * depend on which states the firmware was built with.
+ *
+ * Copyright (c) 2022 Laird Connectivity LLC
+ *
+ * SPDX-License-Identifier: LicenseRef-LairdConnectivity-Clause
+ */
+
+/**************************************************************************************************/
+/* Includes                                                                                       */
+/**************************************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**************************************************************************************************/
+/* Local Constant, Macro and Type Definitions                                                     */
+/**************************************************************************************************/
+/* Same as lcz_ble_gw_dm_trace.h */
+#define TRACE_MAGIC 0x52544447
+#define TRACE_VERSION 1
+#define HEADER_SIZE 16
+#define RECORD_SIZE 12
+#define MAX_STATES 64
+
+/**************************************************************************************************/
+/* Local Data Definitions                                                                         */
+/**************************************************************************************************/
+/* enum lcz_ble_gw_dm_trace_cause */
+static const char *const CAUSE_NAMES[] = {
+	"start",
+	"recovery",
+	"network",
+	"lwm2m",
+	"modem_wake",
+	"deadline",
+	"attr",
+	"obj_created",
+	"memfault",
+};
+
+/* enum lwm2m_rd_client_event (Zephyr 3.2) */
+static const char *const EVENT_NAMES[] = {
+	"none",
+	"bootstrap_reg_failure",
+	"bootstrap_reg_complete",
+	"bootstrap_transfer_complete",
+	"registration_failure",
+	"registration_complete",
+	"reg_update_failure",
+	"reg_update_complete",
+	"deregister_failure",
+	"disconnect",
+	"queue_mode_rx_off",
+	"engine_suspended",
+	"network_error",
+};
+
+static const char *state_names[MAX_STATES];
+
+/**************************************************************************************************/
+/* Local Function Definitions                                                                     */
+/**************************************************************************************************/
+static uint16_t get_u16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+	return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static const char *name(const char *const *names, size_t count, unsigned int value,
+			char *buf, size_t size)
+{
+	if (value < count && names[value] != NULL) {
+		return names[value];
+	}
+
+	snprintf(buf, size, "%u", value);
+	return buf;
+}
+
+static int decode(const uint8_t *data, size_t len)
+{
+	const uint8_t *p;
+	const uint8_t *end = data + len;
+	char from_buf[12];
+	char to_buf[12];
+	char cause_buf[12];
+	char event_buf[12];
+	unsigned int state_count;
+	unsigned int records;
+	unsigned int i;
+	size_t n;
+
+	if (len < HEADER_SIZE || get_u32(data) != TRACE_MAGIC) {
+		fprintf(stderr, "not a gateway trace\n");
+		return -1;
+	}
+	if (data[4] != TRACE_VERSION || data[5] != RECORD_SIZE || data[6] > MAX_STATES) {
+		fprintf(stderr, "unsupported trace version %u record size %u\n", data[4], data[5]);
+		return -1;
+	}
+	state_count = data[6];
+	records = get_u16(data + 8);
+
+	p = data + HEADER_SIZE;
+	for (i = 0; i < state_count; i++) {
+		n = strnlen((const char *)p, (size_t)(end - p));
+		if (p + n >= end) {
+			fprintf(stderr, "truncated state names\n");
+			return -1;
+		}
+		state_names[i] = (const char *)p;
+		p += n + 1;
+	}
+
+	if ((size_t)(end - p) < (size_t)records * RECORD_SIZE) {
+		fprintf(stderr, "truncated, %u of %u records\n",
+			(unsigned int)((end - p) / RECORD_SIZE), records);
+		records = (unsigned int)((end - p) / RECORD_SIZE);
+	}
+
+	printf("# uptime %u ms, next seq %u, %u records\n", get_u32(data + 12),
+	       get_u16(data + 10), records);
+	printf("seq,ms,from,to,cause,lwm2m_event,cnx_tries\n");
+	for (i = 0; i < records; i++, p += RECORD_SIZE) {
+		printf("%u,%u,%s,%s,%s,%s,%u\n", get_u16(p + 10), get_u32(p),
+		       name(state_names, state_count, p[4], from_buf, sizeof(from_buf)),
+		       name(state_names, state_count, p[5], to_buf, sizeof(to_buf)),
+		       name(CAUSE_NAMES, sizeof(CAUSE_NAMES) / sizeof(CAUSE_NAMES[0]), p[6],
+			    cause_buf, sizeof(cause_buf)),
+		       name(EVENT_NAMES, sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]), p[7],
+			    event_buf, sizeof(event_buf)),
+		       get_u16(p + 8));
+	}
+
+	return 0;
+}
+
+/**************************************************************************************************/
+/* Global Function Definitions                                                                    */
+/**************************************************************************************************/
+int main(int argc, char **argv)
+{
+	FILE *f;
+	uint8_t *data;
+	long len;
+	int ret;
+
+	if (argc != 2) {
+		printf("usage: %s <trace file>\n", argv[0]);
+		return 1;
+	}
+
+	f = fopen(argv[1], "rb");
+	if (f == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	rewind(f);
+
+	data = malloc((len > 0) ? (size_t)len : 1);
+	if (data == NULL || fread(data, 1, (size_t)len, f) != (size_t)len) {
+		fprintf(stderr, "read failed\n");
+		fclose(f);
+		free(data);
+		return 1;
+	}
+	fclose(f);
+
+	ret = decode(data, (size_t)len);
+	free(data);
+	return (ret == 0) ? 0 : 1;
+}